@@ -17,7 +17,7 @@
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #
 #-----------------------------------------------------------------------#
-QT += network positioning
+QT += network positioning concurrent
 QT -= gui
 
 include($$PWD/../global.pri)
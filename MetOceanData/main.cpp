@@ -46,6 +46,7 @@ int main(int argc, char *argv[]) {
   d = new MetOceanData(opt.service, opt.station, opt.product, opt.parameterId,
                        opt.vdatum, opt.datum, opt.startDate, opt.endDate,
                        opt.outputFile, &a);
+  if (opt.raggedArray) d->setNetcdfLayout(Hmdf::HmdfNetcdfRaggedArray);
   d->setLoggingActive();
   QObject::connect(d, SIGNAL(finished()), &a, SLOT(quit()));
   QTimer::singleShot(0, d, SLOT(run()));
@@ -19,13 +19,14 @@
 //-----------------------------------------------------------------------*/
 #include "metoceandata.h"
 #include <QHash>
+#include <QSet>
 #include <algorithm>
 #include <iostream>
-#include "constants.h"
 #include "generic.h"
 #include "hmdf.h"
 #include "ndbcdata.h"
 #include "noaacoops.h"
+#include "stationtree.h"
 #include "usgswaterdata.h"
 #include "xtidedata.h"
 
@@ -64,6 +65,7 @@ MetOceanData::MetOceanData(QObject *parent)
       m_endDate(QDateTime()),
       m_outputFile(QString()),
       m_usevdatum(false),
+      m_netcdfLayout(Hmdf::HmdfNetcdfLegacy),
       m_previousProduct(QString()),
       m_productId(QString()),
       QObject(parent) {}
@@ -80,6 +82,7 @@ MetOceanData::MetOceanData(serviceTypes service, QStringList station,
       m_endDate(endDate),
       m_outputFile(outputFile),
       m_usevdatum(useVdatum),
+      m_netcdfLayout(Hmdf::HmdfNetcdfLegacy),
       m_productId(productId),
       m_previousProduct((QString())),
       QObject(parent) {}
@@ -108,6 +111,19 @@ void MetOceanData::setEndDate(const QDateTime &endDate) {
 
 QString MetOceanData::outputFile() const { return this->m_outputFile; }
 
+Hmdf::HmdfNetcdfLayout MetOceanData::netcdfLayout() const {
+  return this->m_netcdfLayout;
+}
+
+void MetOceanData::setNetcdfLayout(Hmdf::HmdfNetcdfLayout netcdfLayout) {
+  this->m_netcdfLayout = netcdfLayout;
+}
+
+int MetOceanData::writeOutput(Hmdf *data) {
+  data->setNetcdfLayout(this->m_netcdfLayout);
+  return data->write(this->m_outputFile);
+}
+
 void MetOceanData::setOutputFile(const QString &outputFile) {
   this->m_outputFile = outputFile;
 }
@@ -175,16 +191,16 @@ QStringList MetOceanData::selectStations(serviceTypes service, double x1,
                                          double y1, double x2, double y2) {
   QStringList stationList;
   StationLocations::MarkerType m = MetOceanData::serviceToMarkerType(service);
-  QVector<Station> markerLocations = StationLocations::readMarkers(m);
+  StationCatalog::View markerLocations = StationLocations::catalog(m);
   double xmin = std::min(x1, x2);
   double xmax = std::max(x1, x2);
   double ymin = std::min(y1, y2);
   double ymax = std::max(y1, y2);
-  for (size_t i = 0; i < markerLocations.size(); ++i) {
-    double x = markerLocations[i].coordinate().longitude();
-    double y = markerLocations[i].coordinate().latitude();
+  for (int i = 0; i < markerLocations.size(); ++i) {
+    double x = markerLocations.longitude(i);
+    double y = markerLocations.latitude(i);
     if (x >= xmin && x <= xmax && y >= ymin && y <= ymax) {
-      stationList.push_back(markerLocations[i].id());
+      stationList.push_back(markerLocations.id(i));
     }
   }
   return stationList;
@@ -192,27 +208,42 @@ QStringList MetOceanData::selectStations(serviceTypes service, double x1,
 
 QString MetOceanData::selectNearestStation(serviceTypes service, double x,
                                            double y) {
+  QStringList station = MetOceanData::selectNearestStations(
+      service, QVector<QPointF>() << QPointF(x, y), 1);
+  return station.isEmpty() ? QString() : station.first();
+}
+
+//...Stations closest to each location, answered from one tree built over
+//   the service's station list. With a radius (meters) only stations
+//   that close are selected, up to count per location if count is
+//   positive. Each station is listed once, in the order first selected
+QStringList MetOceanData::selectNearestStations(
+    serviceTypes service, const QVector<QPointF> &locations, int count,
+    double radius) {
   StationLocations::MarkerType m = MetOceanData::serviceToMarkerType(service);
-  QVector<Station> markerLocations = StationLocations::readMarkers(m);
-
-  double d = std::numeric_limits<double>::max();
-  size_t j = std::numeric_limits<size_t>::max();
-
-  for (size_t i = 0; i < markerLocations.size(); i++) {
-    double xs = markerLocations[i].coordinate().longitude();
-    double ys = markerLocations[i].coordinate().latitude();
-    double d1 = Constants::distance(x, y, xs, ys, true);
-    if (d1 < d) {
-      d = d1;
-      j = i;
+  StationCatalog::View markerLocations = StationLocations::catalog(m);
+  StationTree tree(markerLocations);
+
+  QStringList stationList;
+  QSet<int> selected;
+  for (int i = 0; i < locations.size(); ++i) {
+    double x = locations[i].x();
+    double y = locations[i].y();
+    QVector<int> nearest;
+    if (radius > 0.0) {
+      nearest = tree.withinRadius(x, y, radius);
+      if (count > 0 && nearest.size() > count) nearest.resize(count);
+    } else {
+      nearest = tree.nearest(x, y, std::max(count, 1));
     }
-  }
 
-  if (j != std::numeric_limits<size_t>::max()) {
-    return markerLocations[j].id();
-  } else {
-    return QString();
+    for (int j = 0; j < nearest.size(); ++j) {
+      if (selected.contains(nearest[j])) continue;
+      selected.insert(nearest[j]);
+      stationList.push_back(markerLocations.id(nearest[j]));
+    }
   }
+  return stationList;
 }
 
 StationLocations::MarkerType MetOceanData::serviceToMarkerType(
@@ -234,21 +265,13 @@ StationLocations::MarkerType MetOceanData::serviceToMarkerType(
 bool MetOceanData::findStation(QStringList name,
                                StationLocations::MarkerType type,
                                QVector<Station> &s) {
-  QVector<bool> found;
-  found.resize(name.size());
-  std::fill(found.begin(), found.end(), false);
-  QVector<Station> markerLocations = StationLocations::readMarkers(type);
+  StationCatalog::View markerLocations = StationLocations::catalog(type);
   s.resize(name.length());
 
-  for (size_t j = 0; j < name.length(); j++) {
-    for (size_t i = 0; i < markerLocations.length(); ++i) {
-      if (name.at(j).simplified() == markerLocations[i].id().simplified()) {
-        found[j] = true;
-        s[j] = markerLocations[i];
-        break;
-      }
-    }
-    if (!found[j]) return false;
+  for (int j = 0; j < name.length(); j++) {
+    int index = markerLocations.indexOf(name.at(j).simplified());
+    if (index < 0) return false;
+    s[j] = markerLocations.station(index);
   }
   return true;
 }
@@ -300,7 +323,7 @@ void MetOceanData::getNdbcData() {
   dataOut->setUnits("ndbc_units");
   dataOut->setDatum("ndbc_datum");
 
-  int ierr = dataOut->write(this->m_outputFile);
+  int ierr = this->writeOutput(dataOut);
   if (ierr != 0) {
     emit error("Error writing to file.");
     return;
@@ -352,7 +375,7 @@ void MetOceanData::getXtideData() {
     delete x;
   }
 
-  int ierr = dataOut->write(this->m_outputFile);
+  int ierr = this->writeOutput(dataOut);
   if (ierr != 0) {
     emit error("Error writing data to file.");
     return;
@@ -409,7 +432,7 @@ void MetOceanData::getUsgsData() {
   }
 
   if (data2->nstations() > 0) {
-    int ierr = data2->write(this->m_outputFile);
+    int ierr = this->writeOutput(data2);
     if (ierr != 0) {
       emit error("Error writing to file.");
       return;
@@ -525,7 +548,7 @@ void MetOceanData::getNoaaData() {
     delete coops;
   }
 
-  int ierr = dataOut->write(this->m_outputFile);
+  int ierr = this->writeOutput(dataOut);
   if (ierr != 0) {
     emit error("Error writing data to file");
     return;
@@ -22,6 +22,7 @@
 
 #include <QDateTime>
 #include <QObject>
+#include <QPointF>
 #include "hmdf.h"
 #include "station.h"
 #include "stationlocations.h"
@@ -42,6 +43,10 @@ class MetOceanData : public QObject {
 
   static QString selectNearestStation(serviceTypes service, double x, double y);
 
+  static QStringList selectNearestStations(serviceTypes service,
+                                           const QVector<QPointF> &locations,
+                                           int count, double radius = 0.0);
+
   int service() const;
   void setService(int service);
 
@@ -57,6 +62,9 @@ class MetOceanData : public QObject {
   QString outputFile() const;
   void setOutputFile(const QString &outputFile);
 
+  Hmdf::HmdfNetcdfLayout netcdfLayout() const;
+  void setNetcdfLayout(Hmdf::HmdfNetcdfLayout netcdfLayout);
+
   void setLoggingActive();
   void setLoggingInactive();
 
@@ -93,6 +101,7 @@ class MetOceanData : public QObject {
 
   int printAvailableProducts(Hmdf *data, bool reselect = true);
   int getUSGSProductIndex(Hmdf *stationdata, const QString &product);
+  int writeOutput(Hmdf *data);
 
   bool m_usevdatum;
   int m_service;
@@ -102,6 +111,7 @@ class MetOceanData : public QObject {
   QDateTime m_startDate;
   QDateTime m_endDate;
   QString m_outputFile;
+  Hmdf::HmdfNetcdfLayout m_netcdfLayout;
   QString m_previousProduct;
   QString m_productId;
 };
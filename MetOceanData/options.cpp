@@ -35,9 +35,11 @@ void Options::addOptions() {
   this->parser()->addVersionOption();
   this->parser()->addOptions(QList<QCommandLineOption>()
                              << m_serviceType << m_stationId << m_boundingBox
-                             << m_nearest << m_startDate << m_endDate
+                             << m_nearest << m_nearestCount << m_radius
+                             << m_points << m_startDate << m_endDate
                              << m_product << m_parameterId << m_outputFile
-                             << m_datum << m_vdatum << m_list << m_show);
+                             << m_datum << m_vdatum << m_raggedArray << m_list
+                             << m_show);
 }
 
 Options::CommandLineOptions Options::getCommandLineOptions() {
@@ -48,6 +50,7 @@ Options::CommandLineOptions Options::getCommandLineOptions() {
   inputOptions.push_back(this->parser()->isSet(m_boundingBox));
   inputOptions.push_back(this->parser()->isSet(m_nearest));
   inputOptions.push_back(this->parser()->isSet(m_list));
+  inputOptions.push_back(this->parser()->isSet(m_points));
 
   int inputCount = std::count(inputOptions.begin(), inputOptions.end(), true);
   if (inputCount < 1) {
@@ -59,6 +62,16 @@ Options::CommandLineOptions Options::getCommandLineOptions() {
     this->parser()->showHelp(1);
   }
 
+  if ((this->parser()->isSet(m_nearestCount) ||
+       this->parser()->isSet(m_radius)) &&
+      !this->parser()->isSet(m_nearest) && !this->parser()->isSet(m_points)) {
+    std::cerr << "Error: --nearest-k and --radius require --nearest or "
+                 "--points."
+              << std::endl;
+    std::cerr.flush();
+    this->parser()->showHelp(1);
+  }
+
   if (!this->parser()->isSet(m_serviceType)) {
     std::cerr << "Error: No service selected." << std::endl;
     std::cerr.flush();
@@ -83,19 +96,9 @@ Options::CommandLineOptions Options::getCommandLineOptions() {
     }
     double x = this->parser()->value(m_nearest).split(",").at(0).toDouble();
     double y = this->parser()->value(m_nearest).split(",").at(1).toDouble();
-    opt.station.push_back(
-        MetOceanData::selectNearestStation(opt.service, x, y));
-    if (!opt.station.at(0).isNull()) {
-      if (!this->parser()->isSet(m_show)) {
-        std::cout << "Selected " << opt.station.at(0).toStdString()
-                  << " using nearest location." << std::endl;
-        std::cout.flush();
-      }
-    } else {
-      std::cerr << "No station could be selected." << std::endl;
-      std::cerr.flush();
-      exit(1);
-    }
+    this->selectNearestStations(opt, QVector<QPointF>() << QPointF(x, y));
+  } else if (this->parser()->isSet(m_points)) {
+    this->selectNearestStations(opt, this->readPointList());
   } else if (this->parser()->isSet(m_boundingBox)) {
     QStringList v = this->parser()->value(m_boundingBox).split(",");
     if (v.length() != 4) {
@@ -183,6 +186,13 @@ Options::CommandLineOptions Options::getCommandLineOptions() {
   if (this->parser()->isSet(m_vdatum)) {
     opt.vdatum = true;
   }
+
+  opt.raggedArray = this->parser()->isSet(m_raggedArray);
+  if (opt.raggedArray && !opt.outputFile.toLower().endsWith(".nc")) {
+    std::cerr << "Error: --ragged requires netCDF (.nc) output." << std::endl;
+    std::cerr.flush();
+    this->parser()->showHelp(1);
+  }
   if (this->parser()->isSet(m_datum)) {
     QString datumString = this->parser()->value(m_datum);
     opt.datum = checkIntegerString(datumString);
@@ -304,3 +314,90 @@ void Options::readStationList(QStringList &station,
 
   return;
 }
+
+QVector<QPointF> Options::readPointList() {
+  QString filename = this->parser()->value(m_points);
+  QFile f(filename);
+  if (!f.exists()) {
+    std::cout << "Error: Input file does not exist." << std::endl;
+    std::cout.flush();
+    exit(1);
+  }
+
+  if (!f.open(QIODevice::ReadOnly)) {
+    std::cout << "Error: Could not open input file." << std::endl;
+    std::cout.flush();
+    exit(1);
+  }
+
+  QVector<QPointF> locations;
+  int lineNumber = 0;
+  while (!f.atEnd()) {
+    QString l = f.readLine().simplified();
+    lineNumber++;
+    if (l.isEmpty()) continue;
+    QStringList v = l.split(",");
+    bool okx = false, oky = false;
+    double x = v.value(0).toDouble(&okx);
+    double y = v.value(1).toDouble(&oky);
+    if (v.length() < 2 || !okx || !oky) {
+      std::cerr << "Error: Poorly formed coordinate on line " << lineNumber
+                << " of the points file." << std::endl;
+      std::cerr.flush();
+      exit(1);
+    }
+    locations.push_back(QPointF(x, y));
+  }
+  f.close();
+
+  if (locations.length() == 0) {
+    std::cerr << "Error: No locations found in file." << std::endl;
+    std::cerr.flush();
+    exit(1);
+  }
+
+  return locations;
+}
+
+void Options::selectNearestStations(Options::CommandLineOptions &opt,
+                                    const QVector<QPointF> &locations) {
+  int count = 1;
+  if (this->parser()->isSet(m_nearestCount)) {
+    bool ok = false;
+    count = this->parser()->value(m_nearestCount).toInt(&ok);
+    if (!ok || count < 1) {
+      std::cerr << "Error: Invalid value for --nearest-k." << std::endl;
+      std::cerr.flush();
+      exit(1);
+    }
+  }
+
+  double radius = 0.0;
+  if (this->parser()->isSet(m_radius)) {
+    bool ok = false;
+    radius = this->parser()->value(m_radius).toDouble(&ok) * 1000.0;
+    if (!ok || radius <= 0.0) {
+      std::cerr << "Error: Invalid value for --radius." << std::endl;
+      std::cerr.flush();
+      exit(1);
+    }
+    if (!this->parser()->isSet(m_nearestCount)) count = 0;
+  }
+
+  opt.station = MetOceanData::selectNearestStations(opt.service, locations,
+                                                    count, radius);
+  if (opt.station.length() == 0) {
+    std::cerr << "No station could be selected." << std::endl;
+    std::cerr.flush();
+    exit(1);
+  } else if (!this->parser()->isSet(m_show)) {
+    if (opt.station.length() == 1) {
+      std::cout << "Selected " << opt.station.at(0).toStdString()
+                << " using nearest location." << std::endl;
+    } else {
+      std::cout << "Selected " << opt.station.length()
+                << " stations using nearest locations." << std::endl;
+    }
+    std::cout.flush();
+  }
+}
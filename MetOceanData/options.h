@@ -34,6 +34,7 @@ class Options : public QObject {
     int product;
     int datum;
     bool vdatum;
+    bool raggedArray;
     MetOceanData::serviceTypes service;
     QDateTime startDate;
     QDateTime endDate;
@@ -55,6 +56,9 @@ class Options : public QObject {
                         MetOceanData::serviceTypes markerType);
   void readStationList(QStringList &station,
                        MetOceanData::serviceTypes markerType);
+  QVector<QPointF> readPointList();
+  void selectNearestStations(Options::CommandLineOptions &opt,
+                             const QVector<QPointF> &locations);
 
   QDateTime checkDateString(QString str);
   MetOceanData::serviceTypes checkServiceString(QString str);
@@ -70,6 +70,11 @@ static const QCommandLineOption m_outputFile =
                        "processing, the output extension will always be *.nc",
                        "filename");
 
+static const QCommandLineOption m_raggedArray = QCommandLineOption(
+    QStringList() << "ragged",
+    "Write netCDF output as a CF-1.8 contiguous ragged array, with all "
+    "stations sharing one time and one data variable");
+
 static const QCommandLineOption m_boundingBox =
     QCommandLineOption(QStringList() << "boundingbox",
                        "Bounding box coordinates. Selects all stations that "
@@ -80,6 +85,26 @@ static const QCommandLineOption m_nearest = QCommandLineOption(
     QStringList() << "nearest",
     "Selects the station that falls closest to the specfied location", "x,y");
 
+static const QCommandLineOption m_nearestCount = QCommandLineOption(
+    QStringList() << "nearest-k",
+    "Number of stations to select closest to each location given with "
+    "--nearest or --points",
+    "N");
+
+static const QCommandLineOption m_radius = QCommandLineOption(
+    QStringList() << "radius",
+    "Selects the stations within this distance of each location given with "
+    "--nearest or --points. Combined with --nearest-k, at most N stations "
+    "are selected per location",
+    "km");
+
+static const QCommandLineOption m_points =
+    QCommandLineOption(QStringList() << "points",
+                       "Provide a list of locations via input file formatted "
+                       "as x,y on each line. Selects the stations closest to "
+                       "each location",
+                       "file");
+
 static const QCommandLineOption m_list =
     QCommandLineOption(QStringList() << "list",
                        "Provide a list of stations via input file formatted "
@@ -18,7 +18,7 @@
 #
 #-----------------------------------------------------------------------#
 
-QT  += core gui network xml charts printsupport
+QT  += core gui network xml charts printsupport concurrent
 QT  += qml quick positioning location quickwidgets
 
 include($$PWD/../global.pri)
@@ -34,14 +34,20 @@ SOURCES +=\
     src/crms.cpp \
     src/crmsdialog.cpp \
     src/stationmodel.cpp \
+    src/stationmarkerlayer.cpp \
+    src/stationindex.cpp \
     src/colors.cpp \
     src/dflow.cpp \
+    src/dflowprofile.cpp \
+    src/dflowprofilecache.cpp \
     src/errors.cpp \
     src/filetypes.cpp \
     src/hwm.cpp \
     src/keyhandler.cpp \
     src/noaa.cpp \
     src/session.cpp \
+    src/seriesdecimator.cpp \
+    src/seriesraster.cpp \
     src/uicrmstab.cpp \
     src/usgs.cpp \
     src/xtide.cpp \
@@ -67,14 +73,20 @@ HEADERS  += \
     src/crmsdialog.h \
     src/metoceanviewer.h \
     src/stationmodel.h \
+    src/stationmarkerlayer.h \
+    src/stationindex.h \
     src/colors.h \
     src/dflow.h \
+    src/dflowprofile.h \
+    src/dflowprofilecache.h \
     src/errors.h \
     src/filetypes.h \
     src/hwm.h \
     src/keyhandler.h \
     src/noaa.h \
     src/session.h \
+    src/seriesdecimator.h \
+    src/seriesraster.h \
     src/usgs.h \
     src/xtide.h \
     src/chartview.h \
@@ -107,7 +119,6 @@ RC_FILE = resources.rc
 
 DISTFILES += \
     qml/MapboxGLMapViewer.qml \
-    qml/MovMapItem.qml \
     qml/MapViewer.qml \
     qml/InfoWindow.qml \
     qml/MapLegend.qml \
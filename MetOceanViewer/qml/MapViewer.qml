@@ -23,6 +23,7 @@ import QtQuick.Controls 1.4
 import QtLocation 5.9
 import QtPositioning 5.8
 import QtQuick.Layouts 1.3
+import MetOceanViewer 1.0
 
 Rectangle {
 
@@ -40,6 +41,10 @@ Rectangle {
         return map.visibleRegion;
     }
 
+    function getZoomLevel() {
+        return map.zoomLevel;
+    }
+
     function getMapTypes() {
         var list;
         for(var i=0;i<map.supportedMapTypes.length;i++){
@@ -68,44 +73,63 @@ Rectangle {
     }
 
     function selectedMarkers() {
-        var selectedList = "";
-        var nSelected = 0;
-        for(var child in mapItemView.children){
-            if(mapItemView.children[child].objectName==="marker"){
-                if(mapItemView.children[child].selected===true){
-                    nSelected = nSelected + 1;
-                    if(nSelected===1)
-                        selectedList = mapItemView.children[child].stationId;
-                    else
-                        selectedList = selectedList + "," + mapItemView.children[child].stationId;
-                }
-            }
-        }
-        markerChanged(selectedList);
-        return nSelected;
+        var ids = markerLayer.selectedIds();
+        markerChanged(ids.join(","));
+        return ids.length;
     }
 
     function deselectMarkers() {
-        for(var child in mapItemView.children){
-            if(mapItemView.children[child].objectName==="marker"){
-                if(mapItemView.children[child].selected===true){
-                    mapItemView.children[child].deselect();
-                }
-            }
-        }
+        markerLayer.deselectAll();
         infoWindow.state = "hidden"
     }
 
     function numSelectedMarkers() {
-        var nSelected = 0;
-        for(var child in mapItemView.children){
-            if(mapItemView.children[child].objectName==="marker"){
-                if(mapItemView.children[child].selected===true){
-                    nSelected = nSelected + 1;
-                }
+        return markerLayer.selectedIds().length;
+    }
+
+    function generateInfoWindowText(d){
+        var text;
+        if(markerMode===0){
+            text =
+                    "<b>Location: &nbsp;</b>"+d.longitude+", "+d.latitude+"<br>"+
+                    "<b>Station: &nbsp;&nbsp;&nbsp; </b>"+d.id+"<br>"+
+                    "<b>Name: &nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;</b>"+d.name
+        }else if (markerMode===1){
+            text =
+                    "<b>Location: &nbsp;</b>"+d.longitude+", "+d.latitude+"<br>"+
+                    "<b>Station: &nbsp;&nbsp;&nbsp; </b>"+d.id+"<br>"+
+                    "<b>Name: &nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;</b>"+d.name
+        }else if(markerMode===2){
+            var diff;
+            var modeledText;
+            if(d.modeled<-900){
+                modeledText = "Dry";
+                diff = "n/a";
+            } else {
+                modeledText = d.modeled.toFixed(2);
+                diff = (Math.round((-d.difference)*100)/100).toFixed(2);
             }
+
+            text = "<b>Location: &nbsp;&nbsp;</b>"+d.longitude+", "+d.latitude+"<br>"+
+                    "<b>Observed:</b>&nbsp;&nbsp; "+d.measured.toFixed(2)+"<br>"+
+                    "<b>Modeled:</b> &nbsp;&nbsp;&nbsp;"+modeledText+"<br>"+
+                    "<b>Difference:</b> &nbsp;"+diff
+            infoWindow.shownHeight = 78;
+        } else if(markerMode===3){
+            var endDateString;
+            if(d.endDate=="01/01/2050")
+                endDateString = "present";
+            else
+                endDateString = d.endDate;
+            text =
+                    "<b>Location: &nbsp;</b>"+d.longitude+", "+d.latitude+"<br>"+
+                    "<b>Station: &nbsp;&nbsp;&nbsp; </b>"+d.id+"<br>"+
+                    "<b>Name: &nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;</b>"+d.name+"<br>"+
+                    "<b>Available: </b> "+d.startDate+" - "+endDateString;
+            infoWindow.shownHeight = 78;
         }
-        return nSelected;
+
+        return text;
     }
 
     function showLegend(c0,c1,c2,c3,c4,c5,c6,units) {
@@ -155,7 +179,7 @@ Rectangle {
         onZoomLevelChanged: mapWindowChange()
         onCenterChanged: mapWindowChange()
 
-        property MovMapItem previousMarker
+        property string previousMarker: ""
 
         MouseArea{
             acceptedButtons: Qt.AllButtons
@@ -164,118 +188,65 @@ Rectangle {
             onDoubleClicked: zoomClick(mouse.button)
         }
 
-        MapItemView{
-            id: mapItemView
+        StationMarkerLayer {
+            id: markerLayer
+            objectName: "markerLayer"
+            anchors.fill: parent
             model: stationModel
-            objectName: "mapItemView"
-            delegate: mapcomponent
-        }
-
-        Component {
-            id: mapcomponent
-            MovMapItem {
-                objectName: "marker"
-                mode: markerMode
-                stationActive: active
-                id: markerid
-                stationId: id
-                coordinate: position
-                markerCategory: category
-                parent: mapItemView
-
-                function generateInfoWindowText(){
-                    var text;
-                    if(markerMode===0){
-                        text =
-                                "<b>Location: &nbsp;</b>"+longitude+", "+latitude+"<br>"+
-                                "<b>Station: &nbsp;&nbsp;&nbsp; </b>"+id+"<br>"+
-                                "<b>Name: &nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;</b>"+name
-                    }else if (markerMode===1){
-                        text =
-                                "<b>Location: &nbsp;</b>"+longitude+", "+latitude+"<br>"+
-                                "<b>Station: &nbsp;&nbsp;&nbsp; </b>"+id+"<br>"+
-                                "<b>Name: &nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;</b>"+name
-                    }else if(markerMode===2){
-                        var diff;
-                        var modeledText;
-                        if(modeled<-900){
-                            modeledText = "Dry";
-                            diff = "n/a";
-                        } else {
-                            modeledText = modeled.toFixed(2);
-                            diff = (Math.round((-difference)*100)/100).toFixed(2);
-                        }
-
-                        text = "<b>Location: &nbsp;&nbsp;</b>"+longitude+", "+latitude+"<br>"+
-                                "<b>Observed:</b>&nbsp;&nbsp; "+measured.toFixed(2)+"<br>"+
-                                "<b>Modeled:</b> &nbsp;&nbsp;&nbsp;"+modeledText+"<br>"+
-                                "<b>Difference:</b> &nbsp;"+diff
-                        infoWindow.shownHeight = 78;
-                    } else if(markerMode===3){
-                        var endDateString;
-                        if(endDate=="01/01/2050")
-                            endDateString = "present";
-                        else
-                            endDateString = endDate;
-                        text =
-                                "<b>Location: &nbsp;</b>"+longitude+", "+latitude+"<br>"+
-                                "<b>Station: &nbsp;&nbsp;&nbsp; </b>"+id+"<br>"+
-                                "<b>Name: &nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;</b>"+name+"<br>"+
-                                "<b>Available: </b> "+startDate+" - "+endDateString;
-                        infoWindow.shownHeight = 78;
+            center: map.center
+            zoomLevel: map.zoomLevel
+            mode: markerMode
+
+            function singleMarkerSelection(d){
+                if(isSelected(d.id)){
+                    deselect(d.id)
+                    infoWindow.state = "hidden"
+                } else {
+                    if(map.previousMarker !== ""){
+                        deselect(map.previousMarker)
+                        infoWindow.state = "hidden"
                     }
 
-                    return text;
+                    select(d.id)
+                    selectedMarkers();
+                    map.previousMarker = d.id
+                    window.markerChanged(d.id);
+                    stationText = generateInfoWindowText(d)
+                    infoWindow.state = "shown"
                 }
+            }
 
-                MouseArea{
+            function multipleMarkerSelection(d){
+                select(d.id)
+                selectedMarkers()
 
-                    function singleMarkerSelection(){
-                        if(markerid.selected){
-                            markerid.deselect()
-                            infoWindow.state = "hidden"
-                        } else {
-                            if(map.previousMarker){
-                                map.previousMarker.deselect()
-                                infoWindow.state = "hidden"
-                            }
-
-                            markerid.select()
-                            selectedMarkers();
-                            map.previousMarker = markerid
-                            window.markerChanged(id);
-                            stationText = parent.generateInfoWindowText()
-                            infoWindow.state = "shown"
-                        }
-                    }
+                if(numSelectedMarkers()===1){
+                    infoWindow.state = "shown"
+                    stationText = generateInfoWindowText(d)
+                } else {
+                    infoWindow.state = "hidden"
+                }
+            }
 
-                    function multipleMarkerSelection(){
-                        markerid.select()
-                        selectedMarkers()
+            function zoomToCluster(d){
+                map.center = d.position
+                map.zoomLevel = Math.floor(map.zoomLevel) + 2
+            }
 
-                        if(numSelectedMarkers()===1){
-                            infoWindow.state = "shown"
-                            stationText = parent.generateInfoWindowText()
+            onMarkerClicked: {
+                var d = rowData(row);
+                if(d.clusterCount > 1) {
+                    zoomToCluster(d);
+                } else if(markerMode===0 || markerMode===2 || markerMode===3) {
+                    singleMarkerSelection(d);
+                } else if(markerMode===1) {
+                    if(isSelected(d.id)){
+                        deselect(d.id)
+                    } else {
+                        if ((button === Qt.LeftButton) && (modifiers & Qt.ControlModifier)) {
+                            multipleMarkerSelection(d);
                         } else {
-                            infoWindow.state = "hidden"
-                        }
-                    }
-
-                    anchors.fill: parent
-                    hoverEnabled: true
-                    onClicked: {
-                        if(markerMode===0 || markerMode===2 || markerMode===3) {
-                            singleMarkerSelection();
-                        } else if(markerMode===1) {
-                            if(markerid.selected){
-                                markerid.deselect()
-                            } else {
-                                if ((mouse.button === Qt.LeftButton) && (mouse.modifiers & Qt.ControlModifier)) {
-                                    multipleMarkerSelection();
-                                } else {
-                                    singleMarkerSelection();
-                                }
-                            }
+                            singleMarkerSelection(d);
                         }
                     }
                 }
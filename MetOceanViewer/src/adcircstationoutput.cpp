@@ -19,18 +19,39 @@
 //-----------------------------------------------------------------------*/
 #include "adcircstationoutput.h"
 #include <QFile>
+#include <QtConcurrent>
 #include <algorithm>
+#include <cctype>
 #include <cmath>
 #include <iterator>
 #include "errors.h"
 #include "hmdf.h"
+#include "hmdfasciiparser.h"
 #include "netcdf.h"
+#include "netcdftimeseries.h"
+
+namespace {
+bool isBlankLine(const char *begin, const char *end) {
+  for (const char *c = begin; c < end; ++c)
+    if (!std::isspace(static_cast<unsigned char>(*c))) return false;
+  return true;
+}
+}  // namespace
 
 AdcircStationOutput::AdcircStationOutput(QObject *parent) : QObject(parent) {
   this->_error = MetOceanViewer::Error::NOERR;
   this->_ncerr = NC_NOERR;
   this->nStations = 0;
   this->nSnaps = 0;
+  this->_ncid = -1;
+  this->_varid = -1;
+  this->_varid2 = -1;
+  this->_fillVal = 0.0;
+}
+
+AdcircStationOutput::~AdcircStationOutput() {
+  QMutexLocker lock(NetcdfTimeseries::mutex());
+  if (this->_ncid != -1) nc_close(this->_ncid);
 }
 
 int AdcircStationOutput::error() { return this->_error; }
@@ -53,12 +74,12 @@ int AdcircStationOutput::read(QString AdcircFile, QDateTime coldStart) {
 int AdcircStationOutput::readAscii(QString AdcircOutputFile,
                                    QString AdcircStationFile) {
   QFile MyFile(AdcircOutputFile), StationFile(AdcircStationFile);
-  QString header1, header2, TempLine;
+  QString header2, TempLine;
   QStringList headerData, TempList;
   int nColumns;
 
   // Check if we can open the file
-  if (!MyFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+  if (!MyFile.open(QIODevice::ReadOnly)) {
     this->_error = MetOceanViewer::Error::CANNOT_OPEN_FILE;
     return this->_error;
   }
@@ -68,39 +89,101 @@ int AdcircStationOutput::readAscii(QString AdcircOutputFile,
     return this->_error;
   }
 
-  // Read the 61/62 style file
-  header1 = MyFile.readLine();
-  header2 = MyFile.readLine().simplified();
+  // Map the 61/62 style file. Fall back to a bulk read if the
+  // platform won't map it
+  QByteArray buffer;
+  const char *begin = nullptr;
+  qint64 size = MyFile.size();
+  uchar *map = size > 0 ? MyFile.map(0, size) : nullptr;
+  if (map != nullptr) {
+    begin = reinterpret_cast<const char *>(map);
+  } else {
+    buffer = MyFile.readAll();
+    begin = buffer.constData();
+    size = buffer.size();
+  }
+  const char *end = begin + size;
+
+  // Read the header
+  const char *pos = HmdfAsciiParser::lineEnd(begin, end);
+  pos = pos < end ? pos + 1 : end;
+  const char *eol = HmdfAsciiParser::lineEnd(pos, end);
+  header2 = QString::fromLatin1(pos, static_cast<int>(eol - pos)).simplified();
   headerData = header2.split(" ");
+  pos = eol < end ? eol + 1 : end;
 
-  this->nSnaps = headerData.value(0).toInt();
+  size_t headerSnaps = headerData.value(0).toInt();
   this->nStations = headerData.value(1).toInt();
   nColumns = headerData.value(4).toInt();
 
-  this->time.resize(this->nSnaps);
-  this->data.resize(this->nStations);
+  // Locate the first line of every snapshot so that the snapshots can
+  // be parsed independently. Each is a time line followed by one line
+  // per station. A truncated final snapshot is dropped
+  std::vector<const char *> snapStart;
+  snapStart.reserve(headerSnaps);
+  size_t lineInSnap = 0;
+  const char *snapBegin = nullptr;
+  while (pos < end && snapStart.size() < headerSnaps) {
+    eol = HmdfAsciiParser::lineEnd(pos, end);
+    if (!isBlankLine(pos, eol)) {
+      if (lineInSnap == 0) snapBegin = pos;
+      if (++lineInSnap == this->nStations + 1) {
+        snapStart.push_back(snapBegin);
+        lineInSnap = 0;
+      }
+    }
+    pos = eol < end ? eol + 1 : end;
+  }
 
-  for (size_t i = 0; i < this->nStations; ++i)
-    this->data[i].resize(this->nSnaps);
-
-  for (size_t i = 0; i < this->nSnaps; ++i) {
-    TempLine = MyFile.readLine().simplified();
-    TempList = TempLine.split(" ");
-    this->time[i] = TempList.value(0).toDouble();
-    for (size_t j = 0; j < this->nStations; ++j) {
-      TempLine = MyFile.readLine().simplified();
-      TempList = TempLine.split(" ");
-      if (TempList.value(1).toDouble() < -900) {
-        this->data[j][i] = HmdfStation::nullDataValue();
-      } else {
-        this->data[j][i] = TempList.value(1).toDouble();
-        if (nColumns == 2)
-          this->data[j][i] = pow(
-              pow(this->data[j][i], 2) + pow(TempList.value(2).toDouble(), 2),
-              2);
+  // Station major so that each station's series is a contiguous column
+  // of the arena the stations are handed
+  this->nSnaps = snapStart.size();
+  this->time.resize(this->nSnaps);
+  this->arena.reset(new HmdfArena(
+      QVector<size_t>(static_cast<int>(this->nStations), this->nSnaps)));
+
+  const size_t nStations = this->nStations;
+  const size_t nSnaps = this->nSnaps;
+  const bool isVector = nColumns == 2;
+  double *timePtr = this->time.data();
+  double *dataPtr = this->arena->data();
+
+  auto parseSnap = [&](size_t i) {
+    const char *p = snapStart[i];
+    double values[3];
+    size_t line = 0;
+    while (p < end && line <= nStations) {
+      const char *e = HmdfAsciiParser::lineEnd(p, end);
+      if (!isBlankLine(p, e)) {
+        size_t n = HmdfAsciiParser::parseNumbers(p, e, values, 3);
+        if (line == 0) {
+          timePtr[i] = n > 0 ? values[0] : 0.0;
+        } else {
+          double &v = dataPtr[(line - 1) * nSnaps + i];
+          if (n < 2 || values[1] < -900) {
+            v = HmdfStation::nullDataValue();
+          } else if (isVector) {
+            double v2 = n > 2 ? values[2] : 0.0;
+            v = std::sqrt(values[1] * values[1] + v2 * v2);
+          } else {
+            v = values[1];
+          }
+        }
+        ++line;
       }
+      p = e < end ? e + 1 : end;
     }
+  };
+
+  std::vector<size_t> snaps(nSnaps);
+  for (size_t i = 0; i < nSnaps; ++i) snaps[i] = i;
+  if (nSnaps > 1) {
+    QtConcurrent::blockingMap(snaps, parseSnap);
+  } else {
+    for (auto i : snaps) parseSnap(i);
   }
+
+  if (map != nullptr) MyFile.unmap(map);
   MyFile.close();
 
   // Now read the station location file
@@ -138,10 +221,6 @@ int AdcircStationOutput::readNetCDF(QString AdcircOutputFile) {
   int dimid_time, dimid_station;
   bool isVector;
 
-  // Size the location array
-  size_t start[2];
-  size_t count[2];
-
   QVector<QString> netcdf_types;
   netcdf_types.resize(6);
   netcdf_types[0] = "zeta";
@@ -151,12 +230,14 @@ int AdcircStationOutput::readNetCDF(QString AdcircOutputFile) {
   netcdf_types[4] = "windx";
   netcdf_types[5] = "windy";
 
-  // Open the file
+  // Open the file. It stays open to serve the stations as they are
+  // read, and is closed when this object is destroyed
   this->_ncerr = nc_open(AdcircOutputFile.toUtf8(), NC_NOWRITE, &ncid);
   if (this->_ncerr != NC_NOERR) {
     this->_error = MetOceanViewer::Error::NETCDF;
     return this->_error;
   }
+  this->_ncid = ncid;
 
   // Get the dimension ids
   this->_ncerr = nc_inq_dimid(ncid, "time", &dimid_time);
@@ -209,15 +290,6 @@ int AdcircStationOutput::readNetCDF(QString AdcircOutputFile) {
     if (i == 5) return MetOceanViewer::Error::NO_VARIABLE_FOUND;
   }
 
-  // Size the output variables
-  this->latitude.reserve(station_size);
-  this->longitude.reserve(station_size);
-  this->nStations = station_size;
-  this->nSnaps = time_size;
-  this->time.reserve(time_size);
-  this->data.resize(station_size);
-  for (size_t i = 0; i < station_size; ++i) this->data[i].resize(time_size);
-
   // Read the station locations and times
   this->_ncerr = nc_inq_varid(ncid, "time", &varid_time);
   if (this->_ncerr != NC_NOERR) {
@@ -244,102 +316,214 @@ int AdcircStationOutput::readNetCDF(QString AdcircOutputFile) {
     return this->_error;
   }
 
-  double *timeData = new double[time_size];
-  this->_ncerr = nc_get_var_double(ncid, varid_time, timeData);
-  if (this->_ncerr != NC_NOERR) {
-    this->_error = MetOceanViewer::Error::NETCDF;
-    delete[] timeData;
-    return this->_error;
-  }
-  this->time.reserve(time_size);
-  std::copy(timeData, timeData + time_size, std::back_inserter(this->time));
-  delete[] timeData;
-
-  double *coor = new double[station_size];
-  this->_ncerr = nc_get_var_double(ncid, varid_lon, coor);
-  if (this->_ncerr != NC_NOERR) {
-    this->_error = MetOceanViewer::Error::NETCDF;
-    delete[] coor;
-    return this->_error;
-  }
-  std::copy(coor, coor + station_size, std::back_inserter(this->longitude));
-  delete[] coor;
-
-  coor = new double[station_size];
-  this->_ncerr = nc_get_var_double(ncid, varid_lat, coor);
-  if (this->_ncerr != NC_NOERR) {
-    this->_error = MetOceanViewer::Error::NETCDF;
-    delete[] coor;
-    return this->_error;
+  std::vector<double> timeData(time_size);
+  std::vector<double> lonData(station_size);
+  std::vector<double> latData(station_size);
+  if (time_size > 0) {
+    this->_ncerr = nc_get_var_double(ncid, varid_time, timeData.data());
+    if (this->_ncerr != NC_NOERR) {
+      this->_error = MetOceanViewer::Error::NETCDF;
+      return this->_error;
+    }
   }
-  std::copy(coor, coor + station_size, std::back_inserter(this->latitude));
-  delete[] coor;
-
-  // Loop over the stations, reading the data into memory
-  for (size_t i = 0; i < station_size; ++i) {
-    double *tempVar1 = new double[time_size];
-    double *tempVar2 = new double[time_size];
-
-    // Read from netCDF
-    start[0] = 0;
-    start[1] = i;
-    count[0] = time_size;
-    count[1] = 1;
-    this->_ncerr = nc_get_vara(ncid, varid_zeta, start, count, tempVar1);
+  if (station_size > 0) {
+    this->_ncerr = nc_get_var_double(ncid, varid_lon, lonData.data());
+    if (this->_ncerr != NC_NOERR) {
+      this->_error = MetOceanViewer::Error::NETCDF;
+      return this->_error;
+    }
+    this->_ncerr = nc_get_var_double(ncid, varid_lat, latData.data());
     if (this->_ncerr != NC_NOERR) {
-      delete[] tempVar1;
-      delete[] tempVar2;
       this->_error = MetOceanViewer::Error::NETCDF;
       return this->_error;
     }
+  }
 
-    if (isVector) {
-      this->_ncerr = nc_get_vara(ncid, varid_zeta2, start, count, tempVar2);
-      if (this->_ncerr != NC_NOERR) {
-        delete[] tempVar1;
-        delete[] tempVar2;
-        this->_error = MetOceanViewer::Error::NETCDF;
-        return this->_error;
-      }
-      for (size_t j = 0; j < time_size; j++) {
-        if (tempVar1[j] != fillVal) {
-          this->data[i][j] =
-              sqrt(pow(tempVar1[j], 2.0) + pow(tempVar2[j], 2.0));
-        } else {
-          this->data[i][j] = HmdfStation::nullDataValue();
-        }
-      }
-    } else {
-      for (size_t j = 0; j < time_size; ++j) {
-        if (tempVar1[j] != fillVal) {
-          this->data[i][j] = tempVar1[j];
-        } else {
-          this->data[i][j] = HmdfStation::nullDataValue();
-        }
-      }
+  // Size the output variables. The series themselves are read on demand
+  this->nStations = station_size;
+  this->nSnaps = time_size;
+  this->_varid = varid_zeta;
+  this->_varid2 = isVector ? varid_zeta2 : -1;
+  this->_fillVal = fillVal;
+  this->time = QVector<double>::fromStdVector(timeData);
+  this->longitude = QVector<double>::fromStdVector(lonData);
+  this->latitude = QVector<double>::fromStdVector(latData);
+  this->station_name.resize(this->nStations);
+  for (size_t i = 0; i < this->nStations; ++i)
+    this->station_name[i] = tr("Station ") + QString::number(i);
+
+  return 0;
+}
+
+// Reads one station's series for the cache. Dates are shared by every
+// station and were converted in toHmdf
+int AdcircStationOutput::fetch(int index, QVector<qint64> &date,
+                               QVector<double> &data) {
+  if (this->_ncid == -1 || index < 0 ||
+      static_cast<size_t>(index) >= this->nStations)
+    return MetOceanViewer::Error::NETCDF;
+
+  date = this->date;
+  data.resize(static_cast<int>(this->nSnaps));
+  if (this->nSnaps == 0) return NC_NOERR;
+
+  QMutexLocker lock(NetcdfTimeseries::mutex());
+  return this->readNetCDFSlabs(
+      std::vector<size_t>(1, static_cast<size_t>(index)), data.data());
+}
+
+size_t AdcircStationOutput::stationLength(int index) const {
+  Q_UNUSED(index);
+  return this->nSnaps;
+}
+
+// The station variables are (time, station). Reading one station at a
+// time is a strided read that, with the usual time major chunking,
+// decompresses every chunk once per station. Instead the stations, in
+// file order, are grouped by the chunk they fall in and each group is
+// read in chunk aligned slabs of time, then transposed into station major
+// order at out, one column of nSnaps per station
+int AdcircStationOutput::readNetCDFSlabs(const std::vector<size_t> &stations,
+                                         double *out) {
+  const size_t maxSlab = 4194304;
+  const int ncid = this->_ncid;
+  const int varid = this->_varid;
+  const int varid2 = this->_varid2;
+  const size_t nSnaps = this->nSnaps;
+
+  int storage = NC_CONTIGUOUS;
+  size_t chunk[2] = {1, 1};
+  int ierr = nc_inq_var_chunking(ncid, varid, &storage, chunk);
+  if (ierr != NC_NOERR) return ierr;
+
+  size_t chunkTime, chunkStation;
+  if (storage == NC_CHUNKED) {
+    chunkTime = std::max<size_t>(chunk[0], 1);
+    chunkStation = std::max<size_t>(chunk[1], 1);
+  } else {
+    // Contiguous (i.e. netCDF classic) files are time major on disk. A
+    // few stations are cheaper read as columns, many as full rows
+    chunkStation = stations.size() * 8 < this->nStations ? 1 : this->nStations;
+    chunkTime = nSnaps;
+  }
+
+  // Group the stations by chunk, reading only the span that is needed
+  struct StationGroup {
+    size_t first, last;  // station range [first, last] in the file
+    size_t begin, end;   // positions in stations
+  };
+  std::vector<StationGroup> groups;
+  for (size_t k = 0; k < stations.size(); ++k) {
+    const size_t key = stations[k] / chunkStation;
+    if (groups.empty() || groups.back().first / chunkStation != key) {
+      StationGroup g;
+      g.first = stations[k];
+      g.begin = k;
+      groups.push_back(g);
     }
+    groups.back().last = stations[k];
+    groups.back().end = k + 1;
+  }
 
-    delete[] tempVar1;
-    delete[] tempVar2;
+  if (storage == NC_CHUNKED) {
+    // Hold one row of the chunks being read so that a chunk is only
+    // decompressed once while its slabs are read
+    size_t rowBytes =
+        chunkTime * chunkStation * sizeof(double) * groups.size();
+    rowBytes = std::min<size_t>(rowBytes, 256 * 1024 * 1024);
+    nc_set_var_chunk_cache(ncid, varid, rowBytes, 1009, 0.75f);
+    if (varid2 != -1)
+      nc_set_var_chunk_cache(ncid, varid2, rowBytes, 1009, 0.75f);
   }
-  this->_error = nc_close(ncid);
-  if (this->_error != NC_NOERR) {
-    this->_ncerr = this->_error;
-    this->_error = MetOceanViewer::Error::NETCDF;
-    return this->_error;
+
+  std::vector<double> slab, slab2;
+
+  for (const auto &g : groups) {
+    const size_t span = g.last - g.first + 1;
+    const size_t maxRows = std::max<size_t>(maxSlab / span, 1);
+
+    size_t t = 0;
+    while (t < nSnaps) {
+      // Stop at the next chunk boundary, or sooner if the slab is large
+      size_t tEnd = std::min(nSnaps, (t / chunkTime + 1) * chunkTime);
+      tEnd = std::min(tEnd, t + maxRows);
+      const size_t rows = tEnd - t;
+
+      size_t start[2] = {t, g.first};
+      size_t count[2] = {rows, span};
+      slab.resize(rows * span);
+      ierr = nc_get_vara_double(ncid, varid, start, count, slab.data());
+      if (ierr != NC_NOERR) return ierr;
+      if (varid2 != -1) {
+        slab2.resize(rows * span);
+        ierr = nc_get_vara_double(ncid, varid2, start, count, slab2.data());
+        if (ierr != NC_NOERR) return ierr;
+      }
+
+      this->transposeSlab(slab.data(), varid2 != -1 ? slab2.data() : nullptr,
+                          rows, span, g.first, stations, g.begin, g.end, t,
+                          out);
+      t = tEnd;
+    }
   }
 
-  // Finally, name the stations the default names for now. Later
-  // we can get fancy and try to get the ADCIRC written names in
-  // the NetCDF file
-  this->station_name.resize(station_size);
-  for (int i = 0; i < station_size; ++i)
-    this->station_name[i] = tr("Station ") + QString::number(i);
+  return NC_NOERR;
+}
 
-  return 0;
+// Scatters a (rows x span) time major slab into the station major output,
+// one tile at a time so that both sides stay in cache
+void AdcircStationOutput::transposeSlab(const double *slab,
+                                        const double *slab2, size_t rows,
+                                        size_t span, size_t firstStation,
+                                        const std::vector<size_t> &stations,
+                                        size_t begin, size_t end,
+                                        size_t snapOffset, double *out) {
+  const size_t tile = 64;
+  const double nullValue = HmdfStation::nullDataValue();
+  const double fillVal = this->_fillVal;
+  const size_t nSnaps = this->nSnaps;
+
+  for (size_t k0 = begin; k0 < end; k0 += tile) {
+    const size_t k1 = std::min(end, k0 + tile);
+    for (size_t r0 = 0; r0 < rows; r0 += tile) {
+      const size_t r1 = std::min(rows, r0 + tile);
+      for (size_t k = k0; k < k1; ++k) {
+        const size_t col = stations[k] - firstStation;
+        double *o = out + k * nSnaps + snapOffset;
+        for (size_t r = r0; r < r1; ++r) {
+          const double v = slab[r * span + col];
+          if (v == fillVal) {
+            o[r] = nullValue;
+          } else if (slab2 != nullptr) {
+            const double v2 = slab2[r * span + col];
+            o[r] = std::sqrt(v * v + v2 * v2);
+          } else {
+            o[r] = v;
+          }
+        }
+      }
+    }
+  }
 }
 
 int AdcircStationOutput::toHmdf(Hmdf *outputHmdf) {
+  // Every station shares the same output times, so they are converted
+  // once
+  this->date.resize(static_cast<int>(this->nSnaps));
+  const qint64 coldStart = this->coldStartTime.toMSecsSinceEpoch();
+  for (int j = 0; j < this->nSnaps; ++j) {
+    this->date[j] = coldStart + static_cast<qint64>(this->time[j]) * 1000;
+  }
+
+  // Stations of an open netCDF file share ownership of this object, which
+  // serves their series on demand. ASCII stations are columns of the
+  // arena they were parsed into
+  QSharedPointer<HmdfStationCache> cache;
+  if (this->arena.isNull()) {
+    cache = this->sharedFromThis();
+    if (cache.isNull()) return MetOceanViewer::Error::NETCDF;
+  }
+
   for (int i = 0; i < this->nStations; ++i) {
     HmdfStation *tempStation = new HmdfStation(outputHmdf);
     tempStation->setName(this->station_name[i]);
@@ -347,13 +531,15 @@ int AdcircStationOutput::toHmdf(Hmdf *outputHmdf) {
     tempStation->setLongitude(this->longitude[i]);
     tempStation->setLatitude(this->latitude[i]);
     tempStation->setStationIndex(i);
-    for (int j = 0; j < this->nSnaps; ++j) {
-      tempStation->setNext(
-          this->coldStartTime.addSecs(this->time[j]).toMSecsSinceEpoch(),
-          this->data[i][j]);
+    if (cache.isNull()) {
+      std::copy(this->date.begin(), this->date.end(), this->arena->date(i));
+      tempStation->setArena(this->arena, i);
+    } else {
+      tempStation->setCache(cache, i);
     }
     outputHmdf->addStation(tempStation);
   }
+  if (cache.isNull()) outputHmdf->setArena(this->arena);
   outputHmdf->setSuccess(true);
   return 0;
 }
@@ -22,37 +22,66 @@
 
 #include <QDateTime>
 #include <QObject>
+#include <QSharedPointer>
 #include <QVector>
+#include <vector>
 #include "hmdf.h"
+#include "hmdfarena.h"
+#include "hmdfstationcache.h"
 
-class AdcircStationOutput : public QObject {
+//...netCDF station files are read lazily: opening one reads only the
+//   times and station locations, and each station is read the first time
+//   its data is touched. The object must be owned by a QSharedPointer for
+//   the stations to share it. ASCII files are read whole into an arena
+class AdcircStationOutput : public QObject,
+                            public HmdfStationCache,
+                            public QEnableSharedFromThis<AdcircStationOutput> {
   Q_OBJECT
 public:
   explicit AdcircStationOutput(QObject *parent = nullptr);
 
+  ~AdcircStationOutput();
+
   int read(QString AdcircFile, QDateTime coldStart);
   int read(QString AdcircFile, QString AdcircStationFile, QDateTime coldStart);
   QString errorString();
   int error();
   int toHmdf(Hmdf *outputHmdf);
 
+protected:
+  int fetch(int index, QVector<qint64> &date, QVector<double> &data) override;
+  size_t stationLength(int index) const override;
+
 private:
   int readAscii(QString AdcircOutputFile, QString AdcircStationFile);
 
   int readNetCDF(QString AdicrcOutputFile);
 
+  int readNetCDFSlabs(const std::vector<size_t> &stations, double *out);
+
+  void transposeSlab(const double *slab, const double *slab2, size_t rows,
+                     size_t span, size_t firstStation,
+                     const std::vector<size_t> &stations, size_t begin,
+                     size_t end, size_t snapOffset, double *out);
+
   size_t nStations;
   size_t nSnaps;
   int _error;
   int _ncerr;
+  int _ncid;
+  int _varid;
+  int _varid2;
+  double _fillVal;
 
   QDateTime coldStartTime;
 
   QVector<double> latitude;
   QVector<double> longitude;
   QVector<double> time;
+  QVector<qint64> date;
 
-  QVector<QVector<double>> data;
+  //...Station major, one column per station. Only used for ASCII files
+  QSharedPointer<HmdfArena> arena;
 
   QVector<QString> station_name;
 };
@@ -181,7 +181,9 @@ void AddTimeseriesDialog::setItemsByFiletype() {
 
     if (this->dflow->is3d()) {
       this->setVerticalLayerElements(true);
-      ui->spin_layer->setMinimum(1);
+      //...Layer 0 plots the full vertical profile
+      ui->spin_layer->setMinimum(0);
+      ui->spin_layer->setSpecialValueText(tr("All layers"));
       ui->spin_layer->setMaximum(dflow->getNumLayers());
       ui->spin_layer->setValue(this->m_layer);
       ui->label_layerinfo->setText(tr("Layer 1 = bottom\nLayer ") +
@@ -23,12 +23,22 @@
 #include <QtCharts/QChart>
 #include <QtCharts/QLineSeries>
 #include <QtCharts/QSplineSeries>
+#include <QtConcurrent>
+#include <QtGui/QKeyEvent>
 #include <QtGui/QMouseEvent>
 #include <QtGui/QResizeEvent>
 #include <QtWidgets/QGraphicsScene>
 #include <QtWidgets/QGraphicsTextItem>
+#include <algorithm>
+#include "seriesdecimator.h"
 #include "timezone.h"
 
+//...Runs on a worker thread; the return value is only there for mapped()
+static bool buildPyramid(const QSharedPointer<SeriesPyramid> &pyramid) {
+  pyramid->build();
+  return true;
+}
+
 bool ChartView::pointXLessThan(const QPointF &p1, const QPointF &p2) {
   return p1.x() < p2.x();
 }
@@ -46,10 +56,25 @@ ChartView::ChartView(QWidget *parent) : QChartView(new QChart(), parent) {
   this->m_yTraceLine = QLineF();
   this->m_xTraceLine = QLineF();
 
+  //...Sits above the grid and shading but below the axes and legend
+  this->m_rasterItem = new QGraphicsPixmapItem(this->chart());
+  this->m_rasterItem->setZValue(2.5);
+  connect(&this->m_rasterWatcher, SIGNAL(finished()), this,
+          SLOT(updateDecimation()));
+
+  //...Legend labels are updated at most once per frame while the mouse
+  //   moves
+  this->m_legendTimer = new QTimer(this);
+  this->m_legendTimer->setSingleShot(true);
+  this->m_legendTimer->setInterval(16);
+  connect(this->m_legendTimer, SIGNAL(timeout()), this,
+          SLOT(updateLegendLabels()));
+
   this->setDragMode(QChartView::NoDrag);
   this->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
   this->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
   this->setMouseTracking(true);
+  this->setFocusPolicy(Qt::StrongFocus);
   this->setDisplayValues(false);
   this->setRubberBand(QChartView::RectangleRubberBand);
   this->setRenderHint(QPainter::Antialiasing);
@@ -148,6 +173,16 @@ void ChartView::clear() {
   if (this->chart()->series().length() > 0) this->chart()->removeAllSeries();
   this->m_legendNames.clear();
   this->m_series.clear();
+  for (int i = 0; i < this->m_pyramidWatchers.size(); ++i)
+    if (this->m_pyramidWatchers[i]) {
+      this->m_pyramidWatchers[i]->disconnect(this);
+      this->m_pyramidWatchers[i]->deleteLater();
+    }
+  this->m_pyramidWatchers.clear();
+  this->m_pyramids.clear();
+  this->m_sortedSeries.clear();
+  this->m_raster.clear();
+  this->m_rasterItem->setPixmap(QPixmap());
   this->removeTraceLines();
   return;
 }
@@ -172,10 +207,40 @@ void ChartView::initializeLegendMarkers() {
   return;
 }
 
+//...The chart only ever holds a decimated copy of a time series. The full
+//   resolution points are kept in a min/max pyramid, built in the
+//   background, and decimated again whenever the visible range or plot size
+//   changes
 void ChartView::addSeries(QLineSeries *series, QString name) {
   this->m_series.push_back(series);
   this->m_legendNames.push_back(name);
 
+  QVector<QPointF> points = series->pointsVector();
+  if (this->m_style == 1 && SeriesDecimator::isSorted(points) &&
+      !points.isEmpty()) {
+    QSharedPointer<SeriesPyramid> pyramid(new SeriesPyramid(points));
+    series->replace(pyramid->window(points.first().x(), points.last().x(),
+                                    this->decimationBuckets()));
+
+    //...The pyramid is shared with the worker so it outlives a clear()
+    QFutureWatcher<void> *watcher = new QFutureWatcher<void>(this);
+    connect(watcher, SIGNAL(finished()), this, SLOT(updateDecimation()));
+    watcher->setFuture(QtConcurrent::run([pyramid]() { pyramid->build(); }));
+
+    this->m_pyramids.push_back(pyramid);
+    this->m_pyramidWatchers.push_back(watcher);
+    this->m_sortedSeries.push_back(QVector<QPointF>());
+  } else {
+    this->m_pyramids.push_back(QSharedPointer<SeriesPyramid>());
+    this->m_pyramidWatchers.push_back(nullptr);
+    //...Only time series look up values under the cursor
+    if (this->m_style == 1)
+      std::sort(points.begin(), points.end(), ChartView::pointXLessThan);
+    else
+      points.clear();
+    this->m_sortedSeries.push_back(points);
+  }
+
   this->chart()->addSeries(series);
   if (this->xAxis() != nullptr)
     series->attachAxis(this->xAxis());
@@ -186,6 +251,112 @@ void ChartView::addSeries(QLineSeries *series, QString name) {
   return;
 }
 
+//...Adds a series that is drawn into the raster layer rather than as a
+//   chart series. Meant for plots with too many series for QtCharts to
+//   handle; use addLegendSeries to give the legend and axes something to
+//   show
+void ChartView::addRasterSeries(const QVector<QPointF> &points,
+                                const QString &name, const QPen &pen) {
+  if (points.isEmpty()) return;
+  if (SeriesDecimator::isSorted(points)) {
+    this->m_raster.addSeries(points, name, pen);
+  } else {
+    QVector<QPointF> sorted = points;
+    std::sort(sorted.begin(), sorted.end(), ChartView::pointXLessThan);
+    this->m_raster.addSeries(sorted, name, pen);
+  }
+  return;
+}
+
+//...Adds a series that only appears in the legend. It is attached to the
+//   axes but never searched for values under the cursor
+void ChartView::addLegendSeries(QLineSeries *series) {
+  this->chart()->addSeries(series);
+  if (this->xAxis() != nullptr)
+    series->attachAxis(this->xAxis());
+  else
+    series->attachAxis(this->dateAxis());
+  series->attachAxis(this->yAxis());
+  return;
+}
+
+//...Moves every series along the x axis, e.g. for a time zone change
+void ChartView::shiftSeries(qreal dx) {
+  for (int i = 0; i < this->m_series.size(); ++i) {
+    if (this->m_pyramids[i].isNull()) {
+      QVector<QPointF> points = this->m_series[i]->pointsVector();
+      for (int j = 0; j < points.size(); ++j) points[j].rx() += dx;
+      this->m_series[i]->replace(points);
+      QVector<QPointF> &sorted = this->m_sortedSeries[i];
+      for (int j = 0; j < sorted.size(); ++j) sorted[j].rx() += dx;
+    } else {
+      this->m_pyramidWatchers[i]->waitForFinished();
+      this->m_pyramids[i]->shift(dx);
+    }
+  }
+  this->m_rasterWatcher.waitForFinished();
+  this->m_raster.shift(dx);
+  this->updateDecimation();
+  return;
+}
+
+//...About two points per horizontal pixel
+int ChartView::decimationBuckets() {
+  int width = static_cast<int>(this->chart()->plotArea().width());
+  if (width <= 0) width = this->width();
+  return std::max(width, 100);
+}
+
+void ChartView::updateDecimation() {
+  const int nBuckets = this->decimationBuckets();
+  for (int i = 0; i < this->m_series.size(); ++i) {
+    if (this->m_pyramids[i].isNull()) continue;
+    const SeriesPyramid *pyramid = this->m_pyramids[i].data();
+    const QVector<QPointF> &full = pyramid->points();
+
+    qreal xmin = this->current_x_axis_min;
+    qreal xmax = this->current_x_axis_max;
+    if (xmax <= xmin) {
+      xmin = full.first().x();
+      xmax = full.last().x();
+    }
+
+    //...Short series are plotted in full and never need replacing
+    if (full.size() <= 2 * nBuckets &&
+        this->m_series[i]->count() == full.size())
+      continue;
+
+    this->m_series[i]->replace(pyramid->window(xmin, xmax, nBuckets));
+  }
+  this->updateRaster();
+  return;
+}
+
+//...Redraws the raster layer for the visible window. The first call after
+//   the series are added also starts building their pyramids, and the
+//   layer is drawn again once they are done
+void ChartView::updateRaster() {
+  if (this->m_raster.isEmpty()) return;
+
+  if (!this->m_rasterWatcher.isRunning() &&
+      !this->m_raster.pyramids().last()->isReady())
+    this->m_rasterWatcher.setFuture(
+        QtConcurrent::mapped(this->m_raster.pyramids(), buildPyramid));
+
+  if (this->current_x_axis_max <= this->current_x_axis_min ||
+      this->current_y_axis_max <= this->current_y_axis_min)
+    return;
+
+  QRectF area = this->chart()->plotArea();
+  QImage image = this->m_raster.render(
+      area.size().toSize(), this->current_x_axis_min,
+      this->current_x_axis_max, this->current_y_axis_min,
+      this->current_y_axis_max);
+  this->m_rasterItem->setPixmap(QPixmap::fromImage(image));
+  this->m_rasterItem->setPos(area.topLeft());
+  return;
+}
+
 void ChartView::rebuild() {
   this->initializeAxisLimits();
   return;
@@ -205,6 +376,7 @@ void ChartView::resizeEvent(QResizeEvent *event) {
     }
   }
   QChartView::resizeEvent(event);
+  if (this->chart()) this->updateDecimation();
   return;
 }
 
@@ -259,37 +431,51 @@ void ChartView::addTraceLines(QMouseEvent *event) {
   return;
 }
 
+//...Full resolution points of a series in x order. Decimated series share
+//   the points held by their pyramid; the rest keep a sorted copy made when
+//   they were added. Neither is ever written while the mouse moves
+const QVector<QPointF> &ChartView::cursorIndex(int seriesIndex) const {
+  if (this->m_pyramids[seriesIndex].isNull())
+    return this->m_sortedSeries[seriesIndex];
+  return this->m_pyramids[seriesIndex]->points();
+}
+
 bool ChartView::getNearestPointToCursor(qreal cursorXPosition, int seriesIndex,
                                         qreal &x, qreal &y) {
-  QVector<QPointF> pv = this->m_series[seriesIndex]->pointsVector();
-  qreal x_ll = pv.at(0).x();
+  const QVector<QPointF> &pv = this->cursorIndex(seriesIndex);
+  if (pv.isEmpty()) return false;
+  qreal x_ll = pv.first().x();
   qreal x_ul = pv.last().x();
 
   if (cursorXPosition >= x_ll && cursorXPosition <= x_ul) {
     QPointF c = QPointF(cursorXPosition, 0);
-    size_t i_min =
-        std::lower_bound(pv.begin(), pv.end(), c, ChartView::pointXLessThan) -
-        pv.begin();
-    x = pv.at(i_min).x();
-    y = pv.at(i_min).y();
+    QVector<QPointF>::const_iterator it =
+        std::lower_bound(pv.constBegin(), pv.constEnd(), c,
+                         ChartView::pointXLessThan);
+    x = it->x();
+    y = it->y();
     return true;
   } else {
     return false;
   }
 }
 
-void ChartView::addLineValuesToLegend(qreal x) {
+void ChartView::addLineValuesToLegend(qreal x, qreal y) {
   for (int i = 0; i < this->m_series.length(); i++) {
     qreal xv, yv;
     bool found = this->getNearestPointToCursor(x, i, xv, yv);
-    if (found)
-      this->chart()->series().at(i)->setName(this->m_legendNames.at(i) + ": " +
-                                             QString::number(yv));
-    else
-      this->chart()->series().at(i)->setName(this->m_legendNames.at(i));
+    QString name = this->m_legendNames.at(i);
+    if (found) name += ": " + QString::number(yv);
+    if (this->m_series[i]->name() != name) this->m_series[i]->setName(name);
   }
   QDateTime date = QDateTime::fromMSecsSinceEpoch(x);
   QString dateString = QString("Date: ") + date.toString("MM/dd/yyyy hh:mm AP");
+
+  int index;
+  qreal value;
+  if (this->m_raster.hitTest(x, y, index, value))
+    dateString += "     " + this->m_raster.name(index) + ": " +
+                  QString::number(value);
   this->m_coord->setText(dateString);
   return;
 }
@@ -309,25 +495,33 @@ bool ChartView::isOnPlot(qreal x, qreal y) {
 
 void ChartView::makeDynamicLegendLabels(qreal x, qreal y) {
   if (this->m_style == 1) {
-    this->addLineValuesToLegend(x);
+    this->addLineValuesToLegend(x, y);
   } else if (this->m_style == 2) {
     this->addChartPositionToLegend(x, y);
   }
   return;
 }
 
+void ChartView::updateLegendLabels() {
+  this->makeDynamicLegendLabels(this->m_legendPosition.x(),
+                                this->m_legendPosition.y());
+  return;
+}
+
 void ChartView::displayInstructionsOnStatusBar() {
   if (this->m_statusBar)
     this->m_statusBar->showMessage(
         tr("Left click and drag to zoom in, Right click to zoom out, "
-           "Double click to reset zoom"));
+           "Double click to reset zoom, Arrow keys to pan"));
 }
 
 void ChartView::resetPlotLegend() {
+  this->m_legendTimer->stop();
   this->m_coord->setText("");
   if (this->m_statusBar) this->m_statusBar->clearMessage();
   for (int i = 0; i < this->m_series.length(); i++)
-    this->chart()->series().at(i)->setName(this->m_legendNames.at(i));
+    if (this->m_series[i]->name() != this->m_legendNames.at(i))
+      this->m_series[i]->setName(this->m_legendNames.at(i));
   this->removeTraceLines();
 }
 
@@ -338,7 +532,8 @@ void ChartView::mouseMoveEvent(QMouseEvent *event) {
       qreal y = this->chart()->mapToValue(event->pos()).y();
 
       if (this->isOnPlot(x, y)) {
-        this->makeDynamicLegendLabels(x, y);
+        this->m_legendPosition = QPointF(x, y);
+        if (!this->m_legendTimer->isActive()) this->m_legendTimer->start();
         this->addTraceLines(event);
         this->displayInstructionsOnStatusBar();
       } else {
@@ -355,7 +550,30 @@ void ChartView::mouseMoveEvent(QMouseEvent *event) {
 
 void ChartView::mouseReleaseEvent(QMouseEvent *event) {
   QChartView::mouseReleaseEvent(event);
-  if (this->chart()) this->resetAxisLimits();
+  if (this->chart()) {
+    this->resetAxisLimits();
+    this->updateDecimation();
+  }
+  return;
+}
+
+//...Pans by a tenth of the plot width. Only the decimated window is
+//   replaced, so this stays fast for long series
+void ChartView::keyPressEvent(QKeyEvent *event) {
+  if (this->chart() == nullptr) return;
+
+  qreal dx = 0.1 * this->chart()->plotArea().width();
+  if (event->key() == Qt::Key_Left) {
+    this->chart()->scroll(-dx, 0);
+  } else if (event->key() == Qt::Key_Right) {
+    this->chart()->scroll(dx, 0);
+  } else {
+    QChartView::keyPressEvent(event);
+    return;
+  }
+
+  this->resetAxisLimits();
+  this->updateDecimation();
   return;
 }
 
@@ -376,6 +594,7 @@ void ChartView::wheelEvent(QWheelEvent *event) {
   QChartView::wheelEvent(event);
 
   this->resetAxisLimits();
+  this->updateDecimation();
 
   return;
 }
@@ -384,6 +603,7 @@ void ChartView::resetZoom() {
   if (this->chart()) {
     this->chart()->zoomReset();
     this->resetAxisLimits();
+    this->updateDecimation();
   }
   return;
 }
@@ -467,6 +687,7 @@ void ChartView::initializeAxisLimits() {
   this->current_y_axis_max = this->y_axis_max;
   this->current_x_axis_min = this->x_axis_min;
   this->current_y_axis_min = this->y_axis_min;
+  this->updateDecimation();
   return;
 }
 
@@ -22,14 +22,18 @@
 #define CHARTVIEW_H
 #include <QChartView>
 #include <QDateTimeAxis>
+#include <QFutureWatcher>
 #include <QLineF>
 #include <QLineSeries>
+#include <QSharedPointer>
 #include <QValueAxis>
 #include <QtCharts/QChartGlobal>
 #include <QtWidgets>
+#include "seriesraster.h"
 
 QT_BEGIN_NAMESPACE
 class QGraphicsScene;
+class QKeyEvent;
 class QMouseEvent;
 class QResizeEvent;
 QT_END_NAMESPACE
@@ -52,6 +56,10 @@ class ChartView : public QChartView {
   void resetZoom();
   void setStatusBar(QStatusBar *inStatusBar);
   void addSeries(QLineSeries *series, QString name);
+  void addRasterSeries(const QVector<QPointF> &points, const QString &name,
+                       const QPen &pen);
+  void addLegendSeries(QLineSeries *series);
+  void shiftSeries(qreal dx);
   void setDisplayValues(bool value);
   void rebuild();
   void clear();
@@ -90,9 +98,17 @@ class ChartView : public QChartView {
   void mouseDoubleClickEvent(QMouseEvent *event);
   void mouseReleaseEvent(QMouseEvent *event);
   void wheelEvent(QWheelEvent *event);
+  void keyPressEvent(QKeyEvent *event);
+
+ private slots:
+  void updateDecimation();
+  void updateLegendLabels();
 
  private:
   void resetAxisLimits();
+  int decimationBuckets();
+  void updateRaster();
+  const QVector<QPointF> &cursorIndex(int seriesIndex) const;
 
   static bool pointXLessThan(const QPointF &p1, const QPointF &p2);
 
@@ -103,11 +119,19 @@ class ChartView : public QChartView {
   QStatusBar *m_statusBar;
   QVector<QString> m_legendNames;
   QVector<QLineSeries *> m_series;
+  QVector<QSharedPointer<SeriesPyramid>> m_pyramids;
+  QVector<QFutureWatcher<void> *> m_pyramidWatchers;
+  QVector<QVector<QPointF>> m_sortedSeries;
+  SeriesRaster m_raster;
+  QGraphicsPixmapItem *m_rasterItem;
+  QFutureWatcher<bool> m_rasterWatcher;
   QLineF m_yTraceLine;
   QLineF m_xTraceLine;
   QGraphicsItem *m_yTraceLinePtr;
   QGraphicsItem *m_xTraceLinePtr;
   bool m_displayValues;
+  QTimer *m_legendTimer;
+  QPointF m_legendPosition;
 
   QDateTimeAxis *m_dateAxis;
   QValueAxis *m_xAxis, *m_yAxis;
@@ -126,7 +150,7 @@ class ChartView : public QChartView {
   void addXYTraceLine(QMouseEvent *event);
   void removeTraceLines();
 
-  void addLineValuesToLegend(qreal x);
+  void addLineValuesToLegend(qreal x, qreal y);
 
   void addChartPositionToLegend(qreal x, qreal y);
 
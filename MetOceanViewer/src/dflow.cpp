@@ -1,10 +1,35 @@
 #include "dflow.h"
+#include <QFileInfo>
+#include <QMutex>
 #include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 #include "netcdf.h"
 #include "errors.h"
 #include "hmdf.h"
 #include "metoceanviewer.h"
 
+//...Error returned when a component of a derived quantity is missing
+static const int c_missingComponent[3] = {
+    MetOceanViewer::Error::DFLOW_NOXVELOCITY,
+    MetOceanViewer::Error::DFLOW_NOYVELOCITY,
+    MetOceanViewer::Error::DFLOW_NOZVELOCITY};
+
+//...Budget for the variables cached from one file. Variables larger than
+//   this are read one layer at a time instead of being held whole, and
+//   the least recently used are dropped to make room for new ones
+static const size_t c_maxCachedBytes = 256 * 1024 * 1024;
+
+//...Open files, reused while unchanged on disk so the variables already
+//   read from them survive reprocessing
+struct DflowRegistryEntry {
+  QDateTime modified;
+  QSharedPointer<Dflow> dflow;
+};
+static QMutex s_registryMutex;
+static QMap<QString, DflowRegistryEntry> s_registry;
+
 Dflow::Dflow(QString filename, QObject *parent) : QObject(parent) {
   this->_isInitialized = false;
   this->_readError = true;
@@ -14,6 +39,8 @@ Dflow::Dflow(QString filename, QObject *parent) : QObject(parent) {
   this->_nSteps = 0;
   this->_nStations = 0;
   this->_nLayers = 0;
+  this->_ncid = -1;
+  this->_cachedBytes = 0;
 
   int ierr = this->_init();
 
@@ -29,12 +56,56 @@ Dflow::Dflow(QString filename, QObject *parent) : QObject(parent) {
   return;
 }
 
+Dflow::~Dflow() {
+  if (this->_ncid != -1) nc_close(this->_ncid);
+}
+
+QSharedPointer<Dflow> Dflow::open(const QString &filename) {
+  const QDateTime modified = QFileInfo(filename).lastModified();
+  QMutexLocker lock(&s_registryMutex);
+  auto it = s_registry.find(filename);
+  if (it != s_registry.end() && it->modified == modified) return it->dflow;
+
+  DflowRegistryEntry entry;
+  entry.modified = modified;
+  entry.dflow.reset(new Dflow(filename));
+  s_registry[filename] = entry;
+  return entry.dflow;
+}
+
+//...Drops registered files other than those listed
+void Dflow::retain(const QStringList &filenames) {
+  QMutexLocker lock(&s_registryMutex);
+  for (auto it = s_registry.begin(); it != s_registry.end();) {
+    if (filenames.contains(it.key()))
+      ++it;
+    else
+      it = s_registry.erase(it);
+  }
+}
+
+//...The file is opened once and held until this object is destroyed
+int Dflow::_open() {
+  if (this->_ncid != -1) return MetOceanViewer::Error::NOERR;
+  int ierr =
+      nc_open(this->_filename.toStdString().c_str(), NC_NOWRITE, &this->_ncid);
+  if (ierr != NC_NOERR) {
+    this->_ncid = -1;
+    this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
+    this->error->setNcErrorCode(ierr);
+    return MetOceanViewer::Error::NETCDF;
+  }
+  return MetOceanViewer::Error::NOERR;
+}
+
 bool Dflow::is3d() { return this->_is3d; }
 
 QStringList Dflow::getVaribleList() { return QStringList(this->_plotvarnames); }
 
 int Dflow::getNumLayers() { return this->_nLayers; }
 
+int Dflow::getNumStations() { return this->_nStations; }
+
 bool Dflow::variableIs3d(QString variable) {
   if (variable == "velocity_magnitude") {
     if (this->_nDims["x_velocity"] == 3)
@@ -48,207 +119,269 @@ bool Dflow::variableIs3d(QString variable) {
     return false;
 }
 
-int Dflow::_get2DVelocityMagnitude(int layer, QVector<QVector<double>> &data) {
-  int ierr, i, j;
-  QVector<QVector<double>> x_data, y_data;
-
-  ierr = this->_getVar(QStringLiteral("x_velocity"), layer, x_data);
-  if (ierr != MetOceanViewer::Error::NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::DFLOW_NOXVELOCITY);
-    return this->error->errorCode();
-  }
+int Dflow::getVariable(QString variable, int layer, Hmdf *hmdf) {
+  int i, ierr;
 
-  ierr = this->_getVar(QStringLiteral("y_velocity"), layer, y_data);
-  if (ierr != MetOceanViewer::Error::NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::DFLOW_NOYVELOCITY);
-    return this->error->errorCode();
-  }
+  ierr = this->_getTime(this->_time);
+  this->error->setErrorCode(ierr);
+  if (this->error->isError()) return this->error->errorCode();
 
-  data.resize(this->_nStations);
-  for (i = 0; i < this->_nStations; i++) {
-    data[i].resize(this->_nSteps);
-    for (j = 0; j < this->_nSteps; j++) {
-      if (x_data[i][j] == HmdfStation::nullDataValue() ||
-          y_data[i][j] == HmdfStation::nullDataValue())
-        data[i][j] = HmdfStation::nullDataValue();
-      else
-        data[i][j] = qSqrt(qPow(x_data[i][j], 2.0) + qPow(y_data[i][j], 2.0));
-    }
-  }
-  return MetOceanViewer::Error::NOERR;
-}
+  QStringList components;
+  DerivedQuantity quantity;
+  this->_components(variable, components, quantity);
 
-int Dflow::_get2DVelocityDirection(int layer, QVector<QVector<double>> &data) {
-  int ierr, i, j;
-  QVector<QVector<double>> x_data, y_data;
+  QSharedPointer<HmdfArena> arena(new HmdfArena(QVector<size_t>(
+      static_cast<int>(this->_nStations), this->_nSteps)));
 
-  ierr = this->_getVar(QStringLiteral("x_velocity"), layer, x_data);
+  ierr = this->_extract(components, quantity, layer, arena.data());
   if (ierr != MetOceanViewer::Error::NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::DFLOW_NOXVELOCITY);
+    this->error->setErrorCode(ierr);
     return this->error->errorCode();
   }
 
-  ierr = this->_getVar(QStringLiteral("y_velocity"), layer, y_data);
-  if (ierr != MetOceanViewer::Error::NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::DFLOW_NOYVELOCITY);
-    return this->error->errorCode();
-  }
+  hmdf->setSuccess(false);
+  hmdf->setDatum("dflowfm_datum");
+  hmdf->setHeader1("DFlowFM");
+  hmdf->setHeader2("DFlowFM");
+  hmdf->setHeader3("DFlowFM");
 
-  data.resize(this->_nStations);
   for (i = 0; i < this->_nStations; i++) {
-    data[i].resize(this->_nSteps);
-    for (j = 0; j < this->_nSteps; j++)
-      if (x_data[i][j] == HmdfStation::nullDataValue() ||
-          y_data[i][j] == HmdfStation::nullDataValue())
-        data[i][j] = HmdfStation::nullDataValue();
-      else
-        data[i][j] = qAtan2(y_data[i][j], x_data[i][j]) * 180.0 / M_PI;
+    std::copy(this->_time.begin(), this->_time.end(), arena->date(i));
+    HmdfStation *station = new HmdfStation(hmdf);
+    station->setArena(arena, i);
+    station->setLatitude(this->_yCoordinates[i]);
+    station->setLongitude(this->_xCoordinates[i]);
+    station->setStationIndex(i);
+    station->setId(QString::number(i));
+    station->setName(this->_stationNames[i]);
+    hmdf->addStation(station);
   }
+  hmdf->setArena(arena);
+  hmdf->setSuccess(true);
+
   return MetOceanViewer::Error::NOERR;
 }
 
-int Dflow::_get3DVeloctiyMagnitude(int layer, QVector<QVector<double>> &data) {
-  int ierr, i, j;
-  QVector<QVector<double>> x_data, y_data, z_data;
+//...Reads all layers of a variable for the given stations. Stations that
+//   fall in the same or neighbouring chunks are read together in one
+//   hyperslab, so a profile costs about as much as a single layer
+int Dflow::getProfile(QString variable, const QVector<int> &stations,
+                      DflowProfile *profile) {
+  int ierr = this->_getTime(this->_time);
+  this->error->setErrorCode(ierr);
+  if (this->error->isError()) return this->error->errorCode();
 
-  ierr = this->_getVar(QStringLiteral("x_velocity"), layer, x_data);
-  if (ierr != MetOceanViewer::Error::NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::DFLOW_NOXVELOCITY);
-    return this->error->errorCode();
+  for (int i = 0; i < stations.size(); ++i) {
+    if (stations[i] < 0 ||
+        static_cast<size_t>(stations[i]) >= this->_nStations) {
+      this->error->setErrorCode(MetOceanViewer::Error::DFLOW_ILLEGALDIMENSION);
+      return this->error->errorCode();
+    }
   }
 
-  ierr = this->_getVar(QStringLiteral("y_velocity"), layer, y_data);
-  if (ierr != MetOceanViewer::Error::NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::DFLOW_NOYVELOCITY);
-    return this->error->errorCode();
-  }
+  QStringList components;
+  DerivedQuantity quantity;
+  this->_components(variable, components, quantity);
+  const int nc = components.size();
+
+  //...Each component comes either from the cache (time major, all
+  //   stations) or from a slab read here (station major, requested
+  //   stations only)
+  std::vector<double> slabs[3];
+  const double *base[3];
+  size_t stationStride[3], layerStride[3], step[3];
+  bool fromCache[3];
+  size_t nLayers = 1;
+
+  for (int k = 0; k < nc; ++k) {
+    const QString &name = components[k];
+    if (!this->_varnames.contains(name)) {
+      ierr = nc > 1 ? c_missingComponent[k]
+                    : MetOceanViewer::Error::DFLOW_VARNOTFOUND;
+      this->error->setErrorCode(ierr);
+      return ierr;
+    }
 
-  ierr = this->_getVar(QStringLiteral("z_velocity"), layer, z_data);
-  if (ierr != MetOceanViewer::Error::NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::DFLOW_NOZVELOCITY);
-    return this->error->errorCode();
+    size_t nl = 1;
+    if (this->_nDims[name] == 3)
+      nl = this->_nLayers;
+    else if (this->_nDims[name] != 2) {
+      this->error->setErrorCode(MetOceanViewer::Error::DFLOW_ILLEGALDIMENSION);
+      return this->error->errorCode();
+    }
+    nLayers = std::max(nLayers, nl);
+
+    fromCache[k] = this->_variables.contains(name);
+    if (fromCache[k]) {
+      base[k] = this->_variables[name].values.constData();
+      stationStride[k] = nl;
+      layerStride[k] = nl > 1 ? 1 : 0;
+      step[k] = this->_nStations * nl;
+    } else {
+      ierr = this->_readProfile(name, nl, stations, slabs[k]);
+      if (ierr != MetOceanViewer::Error::NOERR) {
+        this->error->setErrorCode(ierr);
+        return ierr;
+      }
+      base[k] = slabs[k].data();
+      stationStride[k] = nl * this->_nSteps;
+      layerStride[k] = nl > 1 ? this->_nSteps : 0;
+      step[k] = 1;
+    }
   }
 
-  data.resize(this->_nStations);
-  for (i = 0; i < this->_nStations; i++) {
-    data[i].resize(this->_nSteps);
-    for (j = 0; j < this->_nSteps; j++) {
-      if (x_data[i][j] == HmdfStation::nullDataValue() ||
-          y_data[i][j] == HmdfStation::nullDataValue() ||
-          z_data[i][j] == HmdfStation::nullDataValue())
-        data[i][j] = HmdfStation::nullDataValue();
-      else
-        data[i][j] = qSqrt(qPow(x_data[i][j], 2.0) + qPow(y_data[i][j], 2.0) +
-                           qPow(z_data[i][j], 2.0));
+  profile->allocate(stations, nLayers, this->_time);
+  profile->m_names.resize(stations.size());
+  profile->m_longitude.resize(stations.size());
+  profile->m_latitude.resize(stations.size());
+
+  for (int i = 0; i < stations.size(); ++i) {
+    profile->m_names[i] = this->_stationNames[stations[i]];
+    profile->m_longitude[i] = this->_xCoordinates[stations[i]];
+    profile->m_latitude[i] = this->_yCoordinates[stations[i]];
+
+    for (size_t l = 0; l < nLayers; ++l) {
+      const double *in[3];
+      for (int k = 0; k < nc; ++k) {
+        const size_t s = fromCache[k] ? stations[i] : i;
+        in[k] = base[k] + s * stationStride[k] + l * layerStride[k];
+      }
+      Dflow::_derive(quantity, nc, in, step, this->_nSteps,
+                     profile->series(i, l));
     }
   }
+
   return MetOceanViewer::Error::NOERR;
 }
 
-int Dflow::_getWindVelocityMagnitude(QVector<QVector<double>> &data) {
-  int ierr, i, j;
-  QVector<QVector<double>> x_data, y_data;
-
-  ierr = this->_getVar(QStringLiteral("windx"), 0, x_data);
-  if (ierr != MetOceanViewer::Error::NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::DFLOW_NOXVELOCITY);
-    return this->error->errorCode();
-  }
-  ierr = this->_getVar(QStringLiteral("windy"), 0, y_data);
-  if (ierr != MetOceanViewer::Error::NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::DFLOW_NOYVELOCITY);
-    return this->error->errorCode();
-  }
-  data.resize(this->_nStations);
-  for (i = 0; i < this->_nStations; i++) {
-    data[i].resize(this->_nSteps);
-    for (j = 0; j < this->_nSteps; j++) {
-      if (x_data[i][j] == HmdfStation::nullDataValue() ||
-          y_data[i][j] == HmdfStation::nullDataValue())
-        data[i][j] = HmdfStation::nullDataValue();
-      else
-        data[i][j] = qSqrt(qPow(x_data[i][j], 2.0) + qPow(y_data[i][j], 2.0));
-    }
+//...Maps a plotting variable to the file variables it is computed from
+void Dflow::_components(const QString &variable, QStringList &components,
+                        DerivedQuantity &quantity) {
+  //...Check for derrived data or just retrieve the
+  //   requested variable
+  quantity = Value;
+  if (variable == QStringLiteral("2D_current_speed")) {
+    components << QStringLiteral("x_velocity") << QStringLiteral("y_velocity");
+    quantity = Magnitude;
+  } else if (variable == QStringLiteral("2D_current_direction")) {
+    components << QStringLiteral("x_velocity") << QStringLiteral("y_velocity");
+    quantity = Direction;
+  } else if (variable == QStringLiteral("3D_current_speed")) {
+    components << QStringLiteral("x_velocity") << QStringLiteral("y_velocity")
+               << QStringLiteral("z_velocity");
+    quantity = Magnitude;
+  } else if (variable == QStringLiteral("wind_speed")) {
+    components << QStringLiteral("windx") << QStringLiteral("windy");
+    quantity = Magnitude;
+  } else if (variable == QStringLiteral("wind_direction")) {
+    components << QStringLiteral("windx") << QStringLiteral("windy");
+    quantity = Direction;
+  } else {
+    components << variable;
   }
-  return MetOceanViewer::Error::NOERR;
 }
 
-int Dflow::_getWindDirection(QVector<QVector<double>> &data) {
-  int ierr, i, j;
-  QVector<QVector<double>> x_data, y_data;
-
-  ierr = this->_getVar(QStringLiteral("windx"), 0, x_data);
-  if (ierr != MetOceanViewer::Error::NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::DFLOW_NOXVELOCITY);
-    return this->error->errorCode();
-  }
-  ierr = this->_getVar(QStringLiteral("windy"), 0, y_data);
-  if (ierr != MetOceanViewer::Error::NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::DFLOW_NOYVELOCITY);
-    return this->error->errorCode();
+//...Reads every component (all layers of 3D variables) once and computes
+//   the requested quantity in a single pass, straight into the arena.
+//   Components stay cached, within the file's budget, so that another
+//   variable or layer from the same file doesn't go back to disk, unless
+//   they are too large to hold, in which case only the requested layer is
+//   read
+int Dflow::_extract(const QStringList &components, DerivedQuantity quantity,
+                    int layer, HmdfArena *arena) {
+  const int nc = components.size();
+  const double *values[3];
+  size_t stride[3];
+  size_t offset[3];
+  size_t step[3];
+  std::vector<double> slabs[3];
+  QVector<double> held[3];
+  for (int k = 0; k < nc; ++k) {
+    size_t nLayers;
+    int ierr = this->_variableLayers(components[k], nLayers);
+    if (ierr != MetOceanViewer::Error::NOERR) {
+      if (nc > 1 && ierr == MetOceanViewer::Error::DFLOW_VARNOTFOUND)
+        return c_missingComponent[k];
+      return ierr;
+    }
+    if (nLayers > 1 && (layer < 1 || static_cast<size_t>(layer) > nLayers))
+      return MetOceanViewer::Error::DFLOW_ILLEGALDIMENSION;
+
+    if (this->_cacheable(nLayers)) {
+      ierr = this->_readVariable(components[k]);
+      if (ierr != MetOceanViewer::Error::NOERR) return ierr;
+      //...Reading a later component may evict this one, so a shared copy
+      //   is held until the values have been used
+      const DflowVariable &v = this->_variables[components[k]];
+      held[k] = v.values;
+      values[k] = held[k].constData();
+      stride[k] = v.nLayers;
+      offset[k] = v.nLayers > 1 ? layer - 1 : 0;
+      step[k] = this->_nStations * v.nLayers;
+    } else {
+      ierr = this->_readLayer(components[k], nLayers, layer, slabs[k]);
+      if (ierr != MetOceanViewer::Error::NOERR) return ierr;
+      values[k] = slabs[k].data();
+      stride[k] = 1;
+      offset[k] = 0;
+      step[k] = this->_nStations;
+    }
   }
-  data.resize(this->_nStations);
-  for (i = 0; i < this->_nStations; i++) {
-    data[i].resize(this->_nSteps);
-    for (j = 0; j < this->_nSteps; j++)
-      if (x_data[i][j] == HmdfStation::nullDataValue() ||
-          y_data[i][j] == HmdfStation::nullDataValue())
-        data[i][j] = HmdfStation::nullDataValue();
-      else
-        data[i][j] = qAtan2(y_data[i][j], x_data[i][j]) * 180.0 / M_PI;
+
+  for (size_t j = 0; j < this->_nStations; ++j) {
+    const double *in[3];
+    for (int k = 0; k < nc; ++k) in[k] = values[k] + j * stride[k] + offset[k];
+    Dflow::_derive(quantity, nc, in, step, this->_nSteps,
+                   arena->data(static_cast<int>(j)));
   }
+
   return MetOceanViewer::Error::NOERR;
 }
 
-int Dflow::getVariable(QString variable, int layer, Hmdf *hmdf) {
-  int i, ierr;
-  QVector<qint64> time;
-  QVector<QVector<double>> data;
-
-  ierr = this->_getTime(time);
-  this->error->setErrorCode(ierr);
-  if (this->error->isError()) return this->error->errorCode();
-
-  //...Check for derrived data or just retrieve the
-  //   requested variable
-  if (variable == QStringLiteral("2D_current_speed"))
-    ierr = this->_get2DVelocityMagnitude(layer, data);
-  else if (variable == QStringLiteral("2D_current_direction"))
-    ierr = this->_get2DVelocityDirection(layer, data);
-  else if (variable == QStringLiteral("3D_current_speed"))
-    ierr = this->_get3DVeloctiyMagnitude(layer, data);
-  else if (variable == QStringLiteral("wind_speed"))
-    ierr = this->_getWindVelocityMagnitude(data);
-  else if (variable == QStringLiteral("wind_direction"))
-    ierr = this->_getWindDirection(data);
-  else
-    ierr = this->_getVar(variable, layer, data);
-
-  if (ierr != MetOceanViewer::Error::NOERR) {
-    this->error->setErrorCode(ierr);
-    return this->error->errorCode();
+//...Combines strided component series value by value. A fill value in any
+//   component gives a null result
+void Dflow::_derive(DerivedQuantity quantity, int nComponents,
+                    const double *const *in, const size_t *step, size_t n,
+                    double *out) {
+  const double fill = -999.0;
+  const double null = HmdfStation::nullDataValue();
+  const double *x = in[0];
+  const size_t sx = step[0];
+
+  if (quantity == Value) {
+    for (size_t i = 0; i < n; ++i) {
+      const double a = x[i * sx];
+      out[i] = a == fill ? null : a;
+    }
+    return;
   }
 
-  hmdf->setSuccess(false);
-  hmdf->setDatum("dflowfm_datum");
-  hmdf->setHeader1("DFlowFM");
-  hmdf->setHeader2("DFlowFM");
-  hmdf->setHeader3("DFlowFM");
-
-  for (i = 0; i < this->_nStations; i++) {
-    HmdfStation *station = new HmdfStation(hmdf);
-    station->setDate(time);
-    station->setData(data[i]);
-    station->setLatitude(this->_yCoordinates[i]);
-    station->setLongitude(this->_xCoordinates[i]);
-    station->setStationIndex(i);
-    station->setId(QString::number(i));
-    station->setName(this->_stationNames[i]);
-    hmdf->addStation(station);
+  const double *y = in[1];
+  const size_t sy = step[1];
+  if (quantity == Direction) {
+    for (size_t i = 0; i < n; ++i) {
+      const double a = x[i * sx];
+      const double b = y[i * sy];
+      out[i] = a == fill || b == fill ? null : qAtan2(b, a) * 180.0 / M_PI;
+    }
+  } else if (nComponents == 2) {
+    for (size_t i = 0; i < n; ++i) {
+      const double a = x[i * sx];
+      const double b = y[i * sy];
+      const double m = std::sqrt(a * a + b * b);
+      out[i] = a == fill || b == fill ? null : m;
+    }
+  } else {
+    const double *z = in[2];
+    const size_t sz = step[2];
+    for (size_t i = 0; i < n; ++i) {
+      const double a = x[i * sx];
+      const double b = y[i * sy];
+      const double c = z[i * sz];
+      const double m = std::sqrt(a * a + b * b + c * c);
+      out[i] = a == fill || b == fill || c == fill ? null : m;
+    }
   }
-  hmdf->setSuccess(true);
-
-  return MetOceanViewer::Error::NOERR;
 }
 
 int Dflow::_init() {
@@ -270,7 +403,7 @@ int Dflow::_init() {
 }
 
 int Dflow::_get3d() {
-  int ierr, ncid;
+  int ierr;
   size_t nLayers;
 
   if (this->_dimnames.contains("laydimw"))
@@ -280,21 +413,10 @@ int Dflow::_get3d() {
     return MetOceanViewer::Error::NOERR;
   }
 
-  ierr = nc_open(this->_filename.toStdString().c_str(), NC_NOWRITE, &ncid);
-  if (ierr != NC_NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
-    this->error->setNcErrorCode(ierr);
-    return MetOceanViewer::Error::NETCDF;
-  }
-
-  ierr = nc_inq_dimlen(ncid, this->_dimnames["laydim"], &nLayers);
-  if (ierr != NC_NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
-    this->error->setNcErrorCode(ierr);
-    return MetOceanViewer::Error::NETCDF;
-  }
+  ierr = this->_open();
+  if (ierr != MetOceanViewer::Error::NOERR) return ierr;
 
-  ierr = nc_close(ncid);
+  ierr = nc_inq_dimlen(this->_ncid, this->_dimnames["laydim"], &nLayers);
   if (ierr != NC_NOERR) {
     this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
     this->error->setNcErrorCode(ierr);
@@ -307,23 +429,19 @@ int Dflow::_get3d() {
 }
 
 int Dflow::_getPlottingVariables() {
-  int ncid, nvar, ndim;
+  int nvar, ndim;
   int nd;
   int i, ierr;
   QString sname;
 
-  ierr = nc_open(this->_filename.toStdString().c_str(), NC_NOWRITE, &ncid);
-  this->error->setNcErrorCode(ierr);
-  if (this->error->isNcError()) {
-    this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
-    return this->error->errorCode();
-  }
+  ierr = this->_open();
+  if (ierr != MetOceanViewer::Error::NOERR) return ierr;
+  int ncid = this->_ncid;
 
   ierr = nc_inq_nvars(ncid, &nvar);
   this->error->setNcErrorCode(ierr);
   if (this->error->isNcError()) {
     this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
-    ierr = nc_close(ncid);
     return this->error->errorCode();
   }
 
@@ -331,7 +449,6 @@ int Dflow::_getPlottingVariables() {
   this->error->setNcErrorCode(ierr);
   if (this->error->isNcError()) {
     this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
-    ierr = nc_close(ncid);
     return this->error->errorCode();
   }
 
@@ -345,7 +462,6 @@ int Dflow::_getPlottingVariables() {
       delete[] dims;
       this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
       this->error->setNcErrorCode(ierr);
-      ierr = nc_close(ncid);
       return MetOceanViewer::Error::NETCDF;
     }
     sname = QString(varname);
@@ -359,7 +475,6 @@ int Dflow::_getPlottingVariables() {
       delete[] dims;
       this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
       this->error->setNcErrorCode(ierr);
-      ierr = nc_close(ncid);
       return MetOceanViewer::Error::NETCDF;
     }
     sname = QString(varname);
@@ -370,7 +485,6 @@ int Dflow::_getPlottingVariables() {
       delete[] dims;
       this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
       this->error->setNcErrorCode(ierr);
-      ierr = nc_close(ncid);
       return MetOceanViewer::Error::NETCDF;
     }
 
@@ -382,7 +496,6 @@ int Dflow::_getPlottingVariables() {
       delete[] dims;
       this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
       this->error->setNcErrorCode(ierr);
-      ierr = nc_close(ncid);
       return MetOceanViewer::Error::NETCDF;
     }
 
@@ -406,13 +519,6 @@ int Dflow::_getPlottingVariables() {
   delete[] varname;
   delete[] dims;
 
-  ierr = nc_close(ncid);
-  if (ierr != NC_NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
-    this->error->setNcErrorCode(ierr);
-    return MetOceanViewer::Error::NETCDF;
-  }
-
   ierr = this->_get3d();
   if (ierr != MetOceanViewer::Error::NOERR)
     return MetOceanViewer::Error::DFLOW_3DVARS;
@@ -442,12 +548,13 @@ int Dflow::_getPlottingVariables() {
 int Dflow::_getStations() {
   size_t nstation, name_len;
 
-  int ncid, varid_xcoor, varid_ycoor, varid_namevar;
+  int varid_xcoor, varid_ycoor, varid_namevar;
   int dimid_nsta, dimid_namelen;
-  int ierr = nc_open(this->_filename.toStdString().c_str(), NC_NOWRITE, &ncid);
+  int ierr = this->_open();
   if (ierr != 0) {
     return MetOceanViewer::Error::CANNOT_OPEN_FILE;
   }
+  int ncid = this->_ncid;
 
   ierr += nc_inq_dimid(ncid, "stations", &dimid_nsta);
   ierr += nc_inq_dimid(ncid, "name_len", &dimid_namelen);
@@ -502,8 +609,6 @@ int Dflow::_getStations() {
     this->_yCoordinates[i] = ycoor[i];
   }
 
-  nc_close(ncid);
-
   delete[] xcoor;
   delete[] ycoor;
   delete[] stationName;
@@ -512,7 +617,9 @@ int Dflow::_getStations() {
 }
 
 int Dflow::_getTime(QVector<qint64> &timeList) {
-  int i, ierr, ncid;
+  if (!timeList.isEmpty()) return MetOceanViewer::Error::NOERR;
+
+  int i, ierr;
   size_t nsteps, unitsLen;
   double *time;
   int varid_time = this->_varnames["time"];
@@ -520,13 +627,12 @@ int Dflow::_getTime(QVector<qint64> &timeList) {
   char *units = strdup("units");
   QString refString;
 
-  ierr = nc_open(this->_filename.toStdString().c_str(), NC_NOWRITE, &ncid);
-  if (ierr != NC_NOERR) {
-    delete[] units;
-    this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
-    this->error->setNcErrorCode(ierr);
-    return MetOceanViewer::Error::NETCDF;
+  ierr = this->_open();
+  if (ierr != MetOceanViewer::Error::NOERR) {
+    free(units);
+    return ierr;
   }
+  int ncid = this->_ncid;
 
   ierr = nc_inq_dimlen(ncid, dimid_time, &nsteps);
   if (ierr != NC_NOERR) {
@@ -585,123 +691,159 @@ int Dflow::_getTime(QVector<qint64> &timeList) {
   return MetOceanViewer::Error::NOERR;
 }
 
-int Dflow::_getVar(QString variable, int layer,
-                   QVector<QVector<double>> &data) {
-  if (this->_nDims[variable] == 2)
-    return this->_getVar2D(variable, data);
-  else if (this->_nDims[variable] == 3)
-    return this->_getVar3D(variable, layer, data);
-  else
+//...Layers in a file variable, one for 2D variables
+int Dflow::_variableLayers(const QString &variable, size_t &nLayers) {
+  if (!this->_varnames.contains(variable))
+    return MetOceanViewer::Error::DFLOW_VARNOTFOUND;
+  nLayers = 1;
+  if (this->_nDims[variable] == 3)
+    nLayers = this->_nLayers;
+  else if (this->_nDims[variable] != 2)
     return MetOceanViewer::Error::DFLOW_ILLEGALDIMENSION;
+  return MetOceanViewer::Error::NOERR;
 }
 
-int Dflow::_getVar2D(QString variable, QVector<QVector<double>> &data) {
-  int ierr, ncid, varid;
-  double *d = new double[this->_nSteps * this->_nStations];
-  size_t *start = new size_t[2];
-  size_t *count = new size_t[2];
-
-  data.resize(this->_nStations);
-  for (size_t i = 0; i < this->_nStations; i++) data[i].resize(this->_nSteps);
-
-  varid = this->_varnames[variable];
-  ierr = nc_open(this->_filename.toStdString().c_str(), NC_NOWRITE, &ncid);
-  if (ierr != NC_NOERR) {
-    delete[] start;
-    delete[] count;
-    delete[] d;
-    this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
-    this->error->setNcErrorCode(ierr);
-    return MetOceanViewer::Error::NETCDF;
-  }
+//...Whether a whole variable with this many layers fits the cache budget.
+//   Checked by division so the size can't overflow
+bool Dflow::_cacheable(size_t nLayers) const {
+  const size_t maxValues = c_maxCachedBytes / sizeof(double);
+  if (this->_nSteps == 0 || this->_nStations == 0) return true;
+  return nLayers <= maxValues / this->_nSteps / this->_nStations;
+}
 
-  start[0] = 0;
-  start[1] = 0;
-  count[0] = this->_nSteps;
-  count[1] = this->_nStations;
-  ierr = nc_get_vara_double(ncid, varid, start, count, d);
-  if (ierr != NC_NOERR) {
-    delete[] start;
-    delete[] count;
-    delete[] d;
-    this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
-    this->error->setNcErrorCode(ierr);
-    return MetOceanViewer::Error::NETCDF;
+//...Reads a whole variable, all time steps, stations and layers, in one
+//   call. Callers check that it fits with _cacheable first
+int Dflow::_readVariable(const QString &variable) {
+  if (this->_variables.contains(variable)) {
+    this->_variableOrder.removeOne(variable);
+    this->_variableOrder.append(variable);
+    return MetOceanViewer::Error::NOERR;
   }
 
-  for (size_t i = 0; i < this->_nSteps; i++)
-    for (size_t j = 0; j < this->_nStations; j++) {
-      if (d[i * this->_nStations + j] == -999.0)
-        data[j][i] = HmdfStation::nullDataValue();
-      else
-        data[j][i] = d[i * this->_nStations + j];
-    }
+  size_t nLayers;
+  int ierr = this->_variableLayers(variable, nLayers);
+  if (ierr != MetOceanViewer::Error::NOERR) return ierr;
+  if (!this->_cacheable(nLayers))
+    return MetOceanViewer::Error::DFLOW_ILLEGALDIMENSION;
 
-  delete[] start;
-  delete[] count;
-  delete[] d;
+  ierr = this->_open();
+  if (ierr != MetOceanViewer::Error::NOERR) return ierr;
 
-  ierr = nc_close(ncid);
-  if (ierr != NC_NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
-    this->error->setNcErrorCode(ierr);
-    return MetOceanViewer::Error::NETCDF;
+  DflowVariable v;
+  v.nLayers = nLayers;
+  v.values.resize(static_cast<int>(this->_nSteps * this->_nStations * nLayers));
+  if (!v.values.isEmpty()) {
+    ierr = nc_get_var_double(this->_ncid, this->_varnames[variable],
+                             v.values.data());
+    if (ierr != NC_NOERR) {
+      this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
+      this->error->setNcErrorCode(ierr);
+      return MetOceanViewer::Error::NETCDF;
+    }
   }
+  this->_cacheVariable(variable, v);
 
   return MetOceanViewer::Error::NOERR;
 }
 
-int Dflow::_getVar3D(QString variable, int layer,
-                     QVector<QVector<double>> &data) {
-  int ierr, ncid, varid;
-  double *d = new double[this->_nSteps * this->_nStations];
-  size_t *start = new size_t[3];
-  size_t *count = new size_t[3];
+//...Adds a variable as the most recently used, dropping the least
+//   recently used until the file is back within its budget. Callers
+//   holding a copy of a dropped variable's values keep them alive
+void Dflow::_cacheVariable(const QString &variable, const DflowVariable &v) {
+  const size_t bytes = v.values.size() * sizeof(double);
+  while (!this->_variableOrder.isEmpty() &&
+         this->_cachedBytes + bytes > c_maxCachedBytes) {
+    const QString oldest = this->_variableOrder.takeFirst();
+    const QVector<double> &values = this->_variables[oldest].values;
+    this->_cachedBytes -= values.size() * sizeof(double);
+    this->_variables.remove(oldest);
+  }
+  this->_variables[variable] = v;
+  this->_variableOrder.append(variable);
+  this->_cachedBytes += bytes;
+}
 
-  data.resize(this->_nStations);
-  for (size_t i = 0; i < this->_nStations; i++) data[i].resize(this->_nSteps);
+//...Reads one layer of a variable, all time steps and stations, as a
+//   time major [time][station] hyperslab
+int Dflow::_readLayer(const QString &variable, size_t nLayers, int layer,
+                      std::vector<double> &out) {
+  int ierr = this->_open();
+  if (ierr != MetOceanViewer::Error::NOERR) return ierr;
 
-  varid = this->_varnames[variable];
-  ierr = nc_open(this->_filename.toStdString().c_str(), NC_NOWRITE, &ncid);
-  if (ierr != NC_NOERR) {
-    delete[] start;
-    delete[] count;
-    delete[] d;
-    this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
-    this->error->setNcErrorCode(ierr);
-    return MetOceanViewer::Error::NETCDF;
-  }
+  out.resize(this->_nSteps * this->_nStations);
+  if (out.empty()) return MetOceanViewer::Error::NOERR;
 
-  start[0] = 0;
-  start[1] = 0;
-  start[2] = layer - 1;
-  count[0] = this->_nSteps;
-  count[1] = this->_nStations;
-  count[2] = 1;
-  ierr = nc_get_vara_double(ncid, varid, start, count, d);
+  size_t start[3] = {0, 0, nLayers > 1 ? static_cast<size_t>(layer - 1) : 0};
+  size_t count[3] = {this->_nSteps, this->_nStations, 1};
+  ierr = nc_get_vara_double(this->_ncid, this->_varnames[variable], start,
+                            count, out.data());
   if (ierr != NC_NOERR) {
     this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
     this->error->setNcErrorCode(ierr);
     return MetOceanViewer::Error::NETCDF;
   }
+  return MetOceanViewer::Error::NOERR;
+}
 
-  for (size_t i = 0; i < this->_nSteps; i++)
-    for (size_t j = 0; j < this->_nStations; j++) {
-      if (d[i * this->_nStations + j] == -999.0)
-        data[j][i] = HmdfStation::nullDataValue();
-      else
-        data[j][i] = d[i * this->_nStations + j];
+//...Reads all layers of a variable for a set of stations into a station
+//   major [station][layer][time] block. Stations are visited in file order
+//   and those in the same or the next chunk share one hyperslab
+int Dflow::_readProfile(const QString &variable, size_t nLayers,
+                        const QVector<int> &stations,
+                        std::vector<double> &out) {
+  int ierr = this->_open();
+  if (ierr != MetOceanViewer::Error::NOERR) return ierr;
+
+  const int varid = this->_varnames[variable];
+  const size_t nSteps = this->_nSteps;
+
+  size_t stationChunk = 1;
+  int storage;
+  size_t chunks[3];
+  if (nc_inq_var_chunking(this->_ncid, varid, &storage, chunks) == NC_NOERR &&
+      storage == NC_CHUNKED)
+    stationChunk = std::max(chunks[1], static_cast<size_t>(1));
+
+  QVector<int> order(stations.size());
+  for (int i = 0; i < order.size(); ++i) order[i] = i;
+  std::sort(order.begin(), order.end(),
+            [&](int a, int b) { return stations[a] < stations[b]; });
+
+  out.resize(stations.size() * nLayers * nSteps);
+  std::vector<double> slab;
+
+  int i = 0;
+  while (i < order.size()) {
+    int j = i;
+    while (j + 1 < order.size() &&
+           stations[order[j + 1]] / stationChunk <=
+               stations[order[j]] / stationChunk + 1)
+      ++j;
+
+    const size_t first = stations[order[i]];
+    const size_t count = stations[order[j]] - first + 1;
+    size_t start[3] = {0, first, 0};
+    size_t size[3] = {nSteps, count, nLayers};
+    slab.resize(nSteps * count * nLayers);
+
+    if (!slab.empty()) {
+      ierr = nc_get_vara_double(this->_ncid, varid, start, size, slab.data());
+      if (ierr != NC_NOERR) {
+        this->error->setNcErrorCode(ierr);
+        return MetOceanViewer::Error::NETCDF;
+      }
     }
 
-  delete[] start;
-  delete[] count;
-  delete[] d;
-
-  ierr = nc_close(ncid);
-  if (ierr != NC_NOERR) {
-    this->error->setErrorCode(MetOceanViewer::Error::NETCDF);
-    this->error->setNcErrorCode(ierr);
-    return MetOceanViewer::Error::NETCDF;
+    const size_t stride = count * nLayers;
+    for (int m = i; m <= j; ++m) {
+      const size_t pos = order[m];
+      const double *src = slab.data() + (stations[pos] - first) * nLayers;
+      for (size_t l = 0; l < nLayers; ++l) {
+        double *dst = out.data() + (pos * nLayers + l) * nSteps;
+        for (size_t t = 0; t < nSteps; ++t) dst[t] = src[t * stride + l];
+      }
+    }
+    i = j + 1;
   }
 
   return MetOceanViewer::Error::NOERR;
@@ -5,15 +5,25 @@
 #include <QList>
 #include <QMap>
 #include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
 #include <QVector>
+#include <vector>
 #include "errors.h"
 #include "hmdf.h"
+#include "dflowprofile.h"
+#include "hmdfarena.h"
 
 class Dflow : public QObject {
   Q_OBJECT
  public:
   explicit Dflow(QString filename, QObject *parent = nullptr);
 
+  ~Dflow();
+
+  static QSharedPointer<Dflow> open(const QString &filename);
+  static void retain(const QStringList &filenames);
+
   QStringList getVaribleList();
 
   int dflowToImeds(QString variable);
@@ -22,8 +32,13 @@ class Dflow : public QObject {
 
   int getVariable(QString variable, int layer, Hmdf *hmdf);
 
+  int getProfile(QString variable, const QVector<int> &stations,
+                 DflowProfile *profile);
+
   int getNumLayers();
 
+  int getNumStations();
+
   bool is3d();
 
   bool variableIs3d(QString variable);
@@ -31,23 +46,41 @@ class Dflow : public QObject {
   Errors *error;
 
  private:
+  friend class DflowProfileCache;
+
+  enum DerivedQuantity { Value, Magnitude, Direction };
+
+  struct DflowVariable {
+    QVector<double> values;
+    size_t nLayers;
+  };
+
   int _init();
+  int _open();
   int _getPlottingVariables();
   int _getStations();
   int _get3d();
   int _getTime(QVector<qint64> &timeList);
-  int _getVar(QString variable, int layer, QVector<QVector<double>> &data);
-  int _getVar2D(QString variable, QVector<QVector<double>> &data);
-  int _getVar3D(QString variable, int layer, QVector<QVector<double>> &data);
-  int _get2DVelocityMagnitude(int layer, QVector<QVector<double>> &data);
-  int _get2DVelocityDirection(int layer, QVector<QVector<double>> &data);
-  int _get3DVeloctiyMagnitude(int layer, QVector<QVector<double>> &data);
-  int _getWindVelocityMagnitude(QVector<QVector<double>> &data);
-  int _getWindDirection(QVector<QVector<double>> &data);
+  int _variableLayers(const QString &variable, size_t &nLayers);
+  bool _cacheable(size_t nLayers) const;
+  int _readVariable(const QString &variable);
+  void _cacheVariable(const QString &variable, const DflowVariable &v);
+  int _readLayer(const QString &variable, size_t nLayers, int layer,
+                 std::vector<double> &out);
+  int _readProfile(const QString &variable, size_t nLayers,
+                   const QVector<int> &stations, std::vector<double> &out);
+  void _components(const QString &variable, QStringList &components,
+                   DerivedQuantity &quantity);
+  int _extract(const QStringList &components, DerivedQuantity quantity,
+               int layer, HmdfArena *arena);
+  static void _derive(DerivedQuantity quantity, int nComponents,
+                      const double *const *in, const size_t *step, size_t n,
+                      double *out);
 
   bool _isInitialized;
   bool _readError;
   bool _is3d;
+  int _ncid;
   size_t _nStations;
   size_t _nSteps;
   size_t _nLayers;
@@ -60,6 +93,10 @@ class Dflow : public QObject {
   QVector<double> _yCoordinates;
   QVector<QString> _stationNames;
   QDateTime _refTime;
+  QVector<qint64> _time;
+  QMap<QString, DflowVariable> _variables;
+  QList<QString> _variableOrder;
+  size_t _cachedBytes;
 };
 
 #endif  // DFLOW_H
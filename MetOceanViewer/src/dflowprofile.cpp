@@ -0,0 +1,98 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#include "dflowprofile.h"
+#include <QDateTime>
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+#include "metoceanviewer.h"
+
+DflowProfile::DflowProfile() : m_nLayers(0) {}
+
+size_t DflowProfile::nStations() const { return this->m_stations.size(); }
+
+size_t DflowProfile::nLayers() const { return this->m_nLayers; }
+
+size_t DflowProfile::nSteps() const { return this->m_time.size(); }
+
+const QVector<int> &DflowProfile::stations() const { return this->m_stations; }
+
+const QVector<qint64> &DflowProfile::time() const { return this->m_time; }
+
+double DflowProfile::value(size_t station, size_t layer, size_t step) const {
+  return this->series(station, layer)[step];
+}
+
+const double *DflowProfile::series(size_t station, size_t layer) const {
+  return this->m_arena->data(
+      static_cast<int>(station * this->m_nLayers + layer));
+}
+
+double *DflowProfile::series(size_t station, size_t layer) {
+  return this->m_arena->data(
+      static_cast<int>(station * this->m_nLayers + layer));
+}
+
+QSharedPointer<HmdfArena> DflowProfile::arena() const { return this->m_arena; }
+
+void DflowProfile::allocate(const QVector<int> &stations, size_t nLayers,
+                            const QVector<qint64> &time) {
+  this->m_stations = stations;
+  this->m_nLayers = nLayers;
+  this->m_time = time;
+
+  const int nColumns = static_cast<int>(stations.size() * nLayers);
+  this->m_arena.reset(new HmdfArena(
+      QVector<size_t>(nColumns, static_cast<size_t>(time.size()))));
+  for (int i = 0; i < nColumns; ++i)
+    std::copy(time.begin(), time.end(), this->m_arena->date(i));
+}
+
+//...Writes the time/depth section of one station as csv, one column per
+//   layer from the bottom up
+int DflowProfile::write(const QString &filename, size_t station) const {
+  if (station >= this->nStations())
+    return MetOceanViewer::Error::DFLOW_ILLEGALDIMENSION;
+
+  QFile file(filename);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    return MetOceanViewer::Error::CANNOT_OPEN_FILE;
+
+  QTextStream out(&file);
+  out << "# Station: " << this->m_names[static_cast<int>(station)] << "\n";
+  out << "Date";
+  for (size_t l = 0; l < this->m_nLayers; ++l) out << ",Layer " << l + 1;
+  out << "\n";
+
+  QVector<const double *> layers(static_cast<int>(this->m_nLayers));
+  for (size_t l = 0; l < this->m_nLayers; ++l)
+    layers[static_cast<int>(l)] = this->series(station, l);
+
+  for (int i = 0; i < this->m_time.size(); ++i) {
+    out << QDateTime::fromMSecsSinceEpoch(this->m_time[i], Qt::UTC)
+               .toString(QStringLiteral("yyyy-MM-dd hh:mm:ss"));
+    for (size_t l = 0; l < this->m_nLayers; ++l)
+      out << "," << QString::number(layers[static_cast<int>(l)][i], 'f', 6);
+    out << "\n";
+  }
+
+  file.close();
+  return MetOceanViewer::Error::NOERR;
+}
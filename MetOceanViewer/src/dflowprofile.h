@@ -0,0 +1,65 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#ifndef DFLOWPROFILE_H
+#define DFLOWPROFILE_H
+
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include "hmdfarena.h"
+
+//...Station x layer x time block of a Dflow variable. Each station/layer
+//   pair is one column of the arena. Layer 0 is the bottom of the water
+//   column
+class DflowProfile {
+ public:
+  DflowProfile();
+
+  size_t nStations() const;
+  size_t nLayers() const;
+  size_t nSteps() const;
+
+  const QVector<int> &stations() const;
+  const QVector<qint64> &time() const;
+
+  double value(size_t station, size_t layer, size_t step) const;
+  const double *series(size_t station, size_t layer) const;
+
+  QSharedPointer<HmdfArena> arena() const;
+
+  int write(const QString &filename, size_t station) const;
+
+ private:
+  friend class Dflow;
+
+  void allocate(const QVector<int> &stations, size_t nLayers,
+                const QVector<qint64> &time);
+  double *series(size_t station, size_t layer);
+
+  size_t m_nLayers;
+  QVector<int> m_stations;
+  QVector<qint64> m_time;
+  QVector<QString> m_names;
+  QVector<double> m_longitude;
+  QVector<double> m_latitude;
+  QSharedPointer<HmdfArena> m_arena;
+};
+
+#endif  // DFLOWPROFILE_H
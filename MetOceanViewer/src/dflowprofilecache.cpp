@@ -0,0 +1,111 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#include "dflowprofilecache.h"
+#include <algorithm>
+#include "dflow.h"
+#include "metoceanviewer.h"
+#include "netcdftimeseries.h"
+
+DflowProfileCache::DflowProfileCache(QSharedPointer<Dflow> dflow,
+                                     const QString &variable)
+    : m_dflow(dflow), m_variable(variable), m_nLayers(0), m_nSteps(0) {}
+
+//...Reads the first station to learn the layer count and time steps of
+//   the variable and to check that it can be read at all
+int DflowProfileCache::init() {
+  if (this->m_dflow->getNumStations() == 0)
+    return MetOceanViewer::Error::DFLOW_ILLEGALDIMENSION;
+  QMutexLocker lock(&this->m_lastMutex);
+  int ierr = this->readStation(0);
+  if (ierr != MetOceanViewer::Error::NOERR) return ierr;
+  this->m_nLayers = this->m_last.nLayers();
+  this->m_nSteps = this->m_last.nSteps();
+  return MetOceanViewer::Error::NOERR;
+}
+
+size_t DflowProfileCache::nLayers() const { return this->m_nLayers; }
+
+//...Every layer of one station, shared with the last station read
+int DflowProfileCache::profile(int station, DflowProfile *profile) {
+  QMutexLocker lock(&this->m_lastMutex);
+  int ierr = this->readStation(station);
+  if (ierr != MetOceanViewer::Error::NOERR) return ierr;
+  *profile = this->m_last;
+  return MetOceanViewer::Error::NOERR;
+}
+
+//...Called with m_lastMutex held
+int DflowProfileCache::readStation(int station) {
+  if (this->m_last.nStations() == 1 && this->m_last.stations()[0] == station)
+    return MetOceanViewer::Error::NOERR;
+  QMutexLocker lock(NetcdfTimeseries::mutex());
+  return this->m_dflow->getProfile(this->m_variable, QVector<int>{station},
+                                   &this->m_last);
+}
+
+int DflowProfileCache::fetch(int index, QVector<qint64> &date,
+                             QVector<double> &data) {
+  if (this->m_nLayers == 0) return 1;
+  const int station = index / static_cast<int>(this->m_nLayers);
+  const size_t layer = index % this->m_nLayers;
+
+  QMutexLocker lock(&this->m_lastMutex);
+  int ierr = this->readStation(station);
+  if (ierr != MetOceanViewer::Error::NOERR) return ierr;
+
+  const DflowProfile &last = this->m_last;
+  const double *series = last.series(0, layer);
+  date = last.time();
+  data.resize(static_cast<int>(this->m_nSteps));
+  std::copy(series, series + this->m_nSteps, data.begin());
+  return MetOceanViewer::Error::NOERR;
+}
+
+size_t DflowProfileCache::stationLength(int index) const {
+  Q_UNUSED(index);
+  return this->m_nSteps;
+}
+
+//...Adds one layer of every station to the Hmdf. Nothing is read until a
+//   station's data is touched
+int DflowProfileCache::toHmdf(size_t layer, Hmdf *hmdf) {
+  QSharedPointer<HmdfStationCache> cache = this->sharedFromThis();
+  if (cache.isNull() || layer >= this->m_nLayers) return 1;
+
+  hmdf->setSuccess(false);
+  hmdf->setDatum("dflowfm_datum");
+  hmdf->setHeader1("DFlowFM");
+  hmdf->setHeader2("DFlowFM");
+  hmdf->setHeader3("DFlowFM");
+
+  const int nStations = this->m_dflow->getNumStations();
+  for (int i = 0; i < nStations; ++i) {
+    HmdfStation *station = new HmdfStation(hmdf);
+    station->setCache(cache, static_cast<int>(i * this->m_nLayers + layer));
+    station->setLatitude(this->m_dflow->_yCoordinates[i]);
+    station->setLongitude(this->m_dflow->_xCoordinates[i]);
+    station->setStationIndex(i);
+    station->setId(QString::number(i));
+    station->setName(this->m_dflow->_stationNames[i]);
+    hmdf->addStation(station);
+  }
+  hmdf->setSuccess(true);
+  return 0;
+}
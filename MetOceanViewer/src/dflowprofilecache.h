@@ -0,0 +1,64 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#ifndef DFLOWPROFILECACHE_H
+#define DFLOWPROFILECACHE_H
+
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include "dflowprofile.h"
+#include "hmdf.h"
+#include "hmdfstationcache.h"
+
+class Dflow;
+
+//...Serves the layers of a Dflow profile one station at a time. Each
+//   station/layer pair is one cache index, station major. A station's
+//   layers are read together and the last station read is kept, so
+//   plotting every layer of a marker costs one read
+class DflowProfileCache : public HmdfStationCache,
+                          public QEnableSharedFromThis<DflowProfileCache> {
+ public:
+  DflowProfileCache(QSharedPointer<Dflow> dflow, const QString &variable);
+
+  int init();
+
+  size_t nLayers() const;
+
+  int profile(int station, DflowProfile *profile);
+
+  int toHmdf(size_t layer, Hmdf *hmdf);
+
+ protected:
+  int fetch(int index, QVector<qint64> &date, QVector<double> &data) override;
+  size_t stationLength(int index) const override;
+
+ private:
+  int readStation(int station);
+
+  QSharedPointer<Dflow> m_dflow;
+  QString m_variable;
+  size_t m_nLayers;
+  size_t m_nSteps;
+  QMutex m_lastMutex;
+  DflowProfile m_last;
+};
+
+#endif  // DFLOWPROFILECACHE_H
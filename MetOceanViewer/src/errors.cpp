@@ -51,7 +51,8 @@ static QMap<int, QString> _errorTable = {
     {MetOceanViewer::Error::BUILDREVISEDIMEDS,
      QObject::tr("Error building final internal IMEDS structure")},
     {MetOceanViewer::Error::PROJECTSTATIONS, QObject::tr("Error from Proj4 station projections.")},
-    {MetOceanViewer::Error::MARKERSELECTION, QObject::tr("Error selecting markers on map.")}};
+    {MetOceanViewer::Error::MARKERSELECTION, QObject::tr("Error selecting markers on map.")},
+    {MetOceanViewer::Error::LOADCANCELED, QObject::tr("Loading was canceled.")}};
 
 Errors::Errors(QObject *parent) : QObject(parent) {
   this->_ncerr = NC_NOERR;
@@ -24,8 +24,6 @@
 #include <QObject>
 #include "metoceanviewer.h"
 
-#define MAX_NUM_DISPLAYED_STATIONS 250
-
 class Errors : public QObject {
   Q_OBJECT
 public:
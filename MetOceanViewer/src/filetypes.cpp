@@ -2,6 +2,7 @@
 #include <QFileInfo>
 #include <QMap>
 #include "netcdf.h"
+#include "netcdftimeseries.h"
 
 static QMap<QString, int> filetypeMapString = {
     {QStringLiteral("NETCDF-ADCIRC"), MetOceanViewer::FileType::NETCDF_ADCIRC},
@@ -50,6 +51,7 @@ QString Filetypes::getStringFiletype(QString filename) {
 }
 
 bool Filetypes::_checkNetcdfAdcirc(QString filename) {
+  QMutexLocker lock(NetcdfTimeseries::mutex());
   int ncid, ierr;
   size_t attlen;
   char *attname = strdup("model");
@@ -90,6 +92,7 @@ bool Filetypes::_checkNetcdfAdcirc(QString filename) {
 }
 
 bool Filetypes::_checkNetcdfDflow(QString filename) {
+  QMutexLocker lock(NetcdfTimeseries::mutex());
   int ierr, ncid;
   int varid_stationx, varid_stationy;
   char *varname_stationx = strdup("station_x_coordinate");
@@ -139,6 +142,7 @@ bool Filetypes::_checkASCIIImeds(QString filename) {
 }
 
 bool Filetypes::_checkNetcdfGeneric(QString filename) {
+  QMutexLocker lock(NetcdfTimeseries::mutex());
   int ierr, ncid, varid;
   ierr = nc_open(filename.toStdString().c_str(), NC_NOWRITE, &ncid);
   if (ierr != 0) return false;
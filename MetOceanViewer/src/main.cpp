@@ -19,8 +19,10 @@
 //-----------------------------------------------------------------------*/
 
 #include <QApplication>
+#include <QtQml>
 #include "generic.h"
 #include "mainwindow.h"
+#include "stationmarkerlayer.h"
 
 int main(int argc, char *argv[]) {
   QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
@@ -45,6 +47,10 @@ int main(int argc, char *argv[]) {
 
   Q_INIT_RESOURCE(resource_files);
 
+  //...Types used by the QML map views
+  qmlRegisterType<StationMarkerLayer>("MetOceanViewer", 1, 0,
+                                      "StationMarkerLayer");
+
   //...Display the splash screen
   QPixmap pixmap(":/rsc/img/logo_full.png");
   QSplashScreen splash(pixmap);
@@ -813,17 +813,6 @@ void MainWindow::on_button_hwmDisplayValues_toggled(bool checked) {
   ui->graphics_hwm->setDisplayValues(checked);
 }
 
-void MainWindow::stationDisplayWarning(int n) {
-  if (n > MAX_NUM_DISPLAYED_STATIONS) {
-    QMessageBox::critical(this, "Error",
-                          QString::number(n) +
-                              " stations in current view (max: " +
-                              QString::number(MAX_NUM_DISPLAYED_STATIONS) +
-                              "). Zoom in and try again.");
-  }
-  return;
-}
-
 void MainWindow::on_combo_hwmMaptype_currentIndexChanged(int index) {
   Q_UNUSED(index);
   this->changeHwmMaptype();
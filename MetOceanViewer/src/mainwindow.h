@@ -72,6 +72,8 @@ class MainWindow : public QMainWindow {
 
   void throwErrorMessageBox(QString);
 
+  void userTimeseriesProcessed(int ierr);
+
   void setupMetOceanViewerUI();
 
   void on_Button_FetchData_clicked();
@@ -84,6 +86,8 @@ class MainWindow : public QMainWindow {
 
   void on_button_saveTimeseriesImage_clicked();
 
+  void on_button_saveTimeseriesProfile_clicked();
+
   void on_check_TimeseriesYauto_toggled(bool checked);
 
   void on_browse_hwm_clicked();
@@ -338,8 +342,6 @@ class MainWindow : public QMainWindow {
 
   void plotXTideStation();
 
-  void stationDisplayWarning(int n);
-
   void setTimeseriesTableRow(int row, AddTimeseriesDialog *dialog);
 
   void resetMapSource(MapFunctions::MapSource source);
@@ -102,7 +102,6 @@ bool isBetween(T start, T end, T rangeStart, T rangeEnd) {
 int MapFunctions::refreshMarkers(StationModel *model, QQuickWidget *map,
                                  QVector<Station> &locations, QDateTime &start,
                                  QDateTime &end) {
-  model->clear();
   QVector<Station> visibleMarkers;
   for (size_t i = 0; i < locations.size(); ++i) {
     if (isBetween<QDateTime>(locations[i].startValidDate(),
@@ -110,16 +109,26 @@ int MapFunctions::refreshMarkers(StationModel *model, QQuickWidget *map,
       visibleMarkers.push_back(locations[i]);
     }
   }
-  model->addMarkers(visibleMarkers);
+  model->setMarkers(visibleMarkers);
   return visibleMarkers.length();
 }
 
+//...Indexes are built the first time a catalog is shown and rebuilt only
+//   if the catalog vector is replaced
+StationIndex *MapFunctions::stationIndex(const QVector<Station> &locations,
+                                         bool activeOnly) {
+  QPair<const QVector<Station> *, bool> key(&locations, activeOnly);
+  std::shared_ptr<StationIndex> &index = this->m_stationIndexes[key];
+  if (!index || !index->matches(locations))
+    index.reset(new StationIndex(locations, activeOnly));
+  return index.get();
+}
+
 int MapFunctions::refreshMarkers(StationModel *model, QQuickWidget *map,
                                  QVector<Station> &locations, bool filter,
                                  bool activeOnly) {
-  //...Clear current markers
-  model->clear();
-
+  //...The model only applies what changed, so markers that stay in view
+  //   keep their map items
   if (filter) {
     //...Get the bounding area
     QVariant var;
@@ -128,6 +137,10 @@ int MapFunctions::refreshMarkers(StationModel *model, QQuickWidget *map,
     QGeoShape visibleRegion = qvariant_cast<QGeoShape>(var);
     QGeoRectangle boundingBox = visibleRegion.boundingGeoRectangle();
 
+    QVariant zoom;
+    QMetaObject::invokeMethod(map->rootObject(), "getZoomLevel",
+                              Q_RETURN_ARG(QVariant, zoom));
+
     //...Get coordinates
     double x1 = boundingBox.topLeft().longitude();
     double y1 = boundingBox.topLeft().latitude();
@@ -143,31 +156,32 @@ int MapFunctions::refreshMarkers(StationModel *model, QQuickWidget *map,
     double yb = std::min(y1, y2);
     double yt = std::max(y1, y2);
 
-    QVector<Station> visibleMarkers;
-
-    //...Get the objects inside the viewport
-    for (int i = 0; i < locations.size(); i++) {
-      double x = locations.at(i).coordinate().longitude();
-      double y = locations.at(i).coordinate().latitude();
-
-      if (x < 0.0) x = x + 360.0;
+    //...Get the objects inside the viewport. Where stations are too dense
+    //   to be told apart at this zoom, one marker stands in for the group
+    QVector<StationIndex::Marker> markers =
+        this->stationIndex(locations, activeOnly)
+            ->query(xl, xr, yb, yt, zoom.toDouble());
 
-      if (x <= xr && x >= xl && y <= yt && y >= yb) {
-        if (activeOnly) {
-          if (locations.at(i).active()) {
-            visibleMarkers.push_back(locations.at(i));
-          }
-        } else
-          visibleMarkers.push_back(locations.at(i));
-      }
+    QVector<Station> visibleMarkers;
+    QVector<int> clusterSizes;
+    int nVisible = 0;
+    visibleMarkers.reserve(markers.size());
+    clusterSizes.reserve(markers.size());
+    for (int i = 0; i < markers.size(); i++) {
+      if (markers[i].station >= 0)
+        visibleMarkers.push_back(locations.at(markers[i].station));
+      else
+        visibleMarkers.push_back(
+            Station(markers[i].coordinate, QString(),
+                    tr("%1 stations").arg(markers[i].count)));
+      clusterSizes.push_back(markers[i].count);
+      nVisible += markers[i].count;
     }
 
-    if (visibleMarkers.length() <= MAX_NUM_DISPLAYED_STATIONS) {
-      model->addMarkers(visibleMarkers);
-    }
-    return visibleMarkers.length();
+    model->setMarkers(visibleMarkers, clusterSizes);
+    return nVisible;
   } else {
-    model->addMarkers(locations);
+    model->setMarkers(locations);
     return locations.length();
   }
 }
@@ -21,9 +21,12 @@
 #define MAPFUNCTIONS_H
 
 #include <QComboBox>
+#include <QMap>
 #include <QObject>
+#include <QPair>
 #include <memory>
 #include "station.h"
+#include "stationindex.h"
 #include "stationmodel.h"
 
 class MapFunctions : public QObject {
@@ -63,10 +66,15 @@ class MapFunctions : public QObject {
   void setMapType(int index, QQuickWidget *map);
 
  private:
+  StationIndex *stationIndex(const QVector<Station> &locations,
+                             bool activeOnly);
+
   int m_mapSource;
   int m_defaultMapIndex;
   QString m_configDirectory;
   QString m_mapboxApiKey;
+  QMap<QPair<const QVector<Station> *, bool>, std::shared_ptr<StationIndex>>
+      m_stationIndexes;
 };
 
 #endif  // MAPFUNCTIONS_H
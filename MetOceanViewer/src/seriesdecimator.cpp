@@ -0,0 +1,190 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#include "seriesdecimator.h"
+#include <algorithm>
+
+bool SeriesDecimator::isSorted(const QVector<QPointF> &points) {
+  for (int i = 1; i < points.size(); ++i)
+    if (points[i].x() < points[i - 1].x()) return false;
+  return true;
+}
+
+//...Points between xmin and xmax, plus one either side so the line runs
+//   to the edge of the plot, in at most 2 * nBuckets points
+QVector<QPointF> SeriesDecimator::minMax(const QVector<QPointF> &points,
+                                         qreal xmin, qreal xmax,
+                                         int nBuckets) {
+  QVector<QPointF>::const_iterator lo = std::lower_bound(
+      points.constBegin(), points.constEnd(), xmin,
+      [](const QPointF &p, qreal x) { return p.x() < x; });
+  QVector<QPointF>::const_iterator hi = std::upper_bound(
+      points.constBegin(), points.constEnd(), xmax,
+      [](qreal x, const QPointF &p) { return x < p.x(); });
+  if (lo != points.constBegin()) --lo;
+  if (hi != points.constEnd()) ++hi;
+
+  const int first = static_cast<int>(lo - points.constBegin());
+  const int n = static_cast<int>(hi - lo);
+  if (nBuckets < 1 || n <= 2 * nBuckets) return points.mid(first, n);
+
+  const qreal x0 = lo->x();
+  const qreal width = ((hi - 1)->x() - x0) / nBuckets;
+  if (width <= 0.0) return points.mid(first, n);
+
+  //...The end points are always kept so the line reaches the plot edges
+  QVector<QPointF> out;
+  out.reserve(2 * nBuckets + 2);
+  out.push_back(*lo);
+
+  QVector<QPointF>::const_iterator it = lo + 1;
+  --hi;
+  while (it != hi) {
+    const int bucket =
+        std::min(nBuckets - 1, static_cast<int>((it->x() - x0) / width));
+    const bool last = bucket == nBuckets - 1;
+    const qreal bucketEnd = x0 + (bucket + 1) * width;
+
+    QVector<QPointF>::const_iterator low = it, high = it;
+    for (++it; it != hi && (last || it->x() < bucketEnd); ++it) {
+      if (it->y() < low->y()) low = it;
+      if (it->y() > high->y()) high = it;
+    }
+
+    if (low == high) {
+      out.push_back(*low);
+    } else if (low < high) {
+      out.push_back(*low);
+      out.push_back(*high);
+    } else {
+      out.push_back(*high);
+      out.push_back(*low);
+    }
+  }
+  out.push_back(*hi);
+  return out;
+}
+
+SeriesPyramid::SeriesPyramid(const QVector<QPointF> &points)
+    : m_points(points), m_ready(0) {}
+
+bool SeriesPyramid::isReady() const {
+  return this->m_ready.loadAcquire() != 0;
+}
+
+const QVector<QPointF> &SeriesPyramid::points() const { return this->m_points; }
+
+//...Lowest and highest of n points, in x order
+void SeriesPyramid::appendMinMax(const QPointF *p, int n,
+                                 QVector<QPointF> &out) {
+  int low = 0, high = 0;
+  for (int i = 1; i < n; ++i) {
+    if (p[i].y() < p[low].y()) low = i;
+    if (p[i].y() > p[high].y()) high = i;
+  }
+  out.push_back(p[std::min(low, high)]);
+  out.push_back(p[std::max(low, high)]);
+}
+
+//...Each level holds two points per complete block. Level 1 is built from
+//   the raw points and every further level from the one below it
+void SeriesPyramid::build() {
+  int nBlocks = this->m_points.size() / blockFactor;
+  const QPointF *below = this->m_points.constData();
+  int perBlock = blockFactor;
+
+  while (nBlocks > 0) {
+    QVector<QPointF> level;
+    level.reserve(2 * nBlocks);
+    for (int b = 0; b < nBlocks; ++b)
+      SeriesPyramid::appendMinMax(below + b * perBlock, perBlock, level);
+    this->m_levels.push_back(level);
+
+    below = this->m_levels.last().constData();
+    perBlock = 2 * blockFactor;
+    nBlocks /= blockFactor;
+  }
+  this->m_ready.storeRelease(1);
+}
+
+//...Covers the visible range with the largest aligned blocks no coarser
+//   than needed for the plot width, then reduces to two points per bucket
+QVector<QPointF> SeriesPyramid::window(qreal xmin, qreal xmax,
+                                       int nBuckets) const {
+  if (!this->isReady())
+    return SeriesDecimator::minMax(this->m_points, xmin, xmax, nBuckets);
+
+  QVector<QPointF>::const_iterator lo = std::lower_bound(
+      this->m_points.constBegin(), this->m_points.constEnd(), xmin,
+      [](const QPointF &p, qreal x) { return p.x() < x; });
+  QVector<QPointF>::const_iterator hi = std::upper_bound(
+      this->m_points.constBegin(), this->m_points.constEnd(), xmax,
+      [](qreal x, const QPointF &p) { return x < p.x(); });
+  if (lo != this->m_points.constBegin()) --lo;
+  if (hi != this->m_points.constEnd()) ++hi;
+
+  const int i0 = static_cast<int>(lo - this->m_points.constBegin());
+  const int i1 = static_cast<int>(hi - this->m_points.constBegin());
+  if (nBuckets < 1 || i1 - i0 <= 2 * nBuckets)
+    return this->m_points.mid(i0, i1 - i0);
+
+  int level = 0;
+  qint64 size = 1;
+  while (level < this->m_levels.size() &&
+         (i1 - i0) / size > 2 * nBuckets) {
+    size *= blockFactor;
+    level++;
+  }
+
+  QVector<QPointF> coarse;
+  coarse.reserve(4 * nBuckets + 8 * blockFactor * (level + 1));
+
+  //...The end points are kept as is, like in SeriesDecimator::minMax
+  coarse.push_back(this->m_points[i0]);
+  const int end = i1 - 1;
+  int pos = i0 + 1;
+  while (pos < end) {
+    int k = level;
+    qint64 block = size;
+    while (k > 0 && (pos % block != 0 || pos + block > end)) {
+      block /= blockFactor;
+      k--;
+    }
+    if (k == 0) {
+      coarse.push_back(this->m_points[pos]);
+      pos++;
+    } else {
+      const QVector<QPointF> &l = this->m_levels[k - 1];
+      const int b = static_cast<int>(pos / block);
+      coarse.push_back(l[2 * b]);
+      coarse.push_back(l[2 * b + 1]);
+      pos += static_cast<int>(block);
+    }
+  }
+  coarse.push_back(this->m_points[end]);
+
+  return SeriesDecimator::minMax(coarse, xmin, xmax, nBuckets);
+}
+
+void SeriesPyramid::shift(qreal dx) {
+  for (int i = 0; i < this->m_points.size(); ++i) this->m_points[i].rx() += dx;
+  for (int k = 0; k < this->m_levels.size(); ++k)
+    for (int i = 0; i < this->m_levels[k].size(); ++i)
+      this->m_levels[k][i].rx() += dx;
+}
@@ -0,0 +1,66 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#ifndef SERIESDECIMATOR_H
+#define SERIESDECIMATOR_H
+
+#include <QAtomicInt>
+#include <QPointF>
+#include <QVector>
+
+//...Reduces a time ordered series to what can be seen at a given plot
+//   width. Each bucket keeps its smallest and largest value, so peaks
+//   survive exactly
+class SeriesDecimator {
+ public:
+  static bool isSorted(const QVector<QPointF> &points);
+
+  static QVector<QPointF> minMax(const QVector<QPointF> &points, qreal xmin,
+                                 qreal xmax, int nBuckets);
+};
+
+//...Min/max level of detail pyramid over a time ordered series. Level k
+//   keeps the lowest and highest point of every block of 4^k points, so a
+//   window of any size is reduced in time proportional to its pixel width.
+//   build() is meant to run on a worker thread; until it finishes,
+//   window() falls back to scanning the full series
+class SeriesPyramid {
+ public:
+  explicit SeriesPyramid(const QVector<QPointF> &points);
+
+  void build();
+  bool isReady() const;
+
+  const QVector<QPointF> &points() const;
+
+  QVector<QPointF> window(qreal xmin, qreal xmax, int nBuckets) const;
+
+  void shift(qreal dx);
+
+ private:
+  static const int blockFactor = 4;
+
+  static void appendMinMax(const QPointF *p, int n, QVector<QPointF> &out);
+
+  QVector<QPointF> m_points;
+  QVector<QVector<QPointF>> m_levels;
+  QAtomicInt m_ready;
+};
+
+#endif  // SERIESDECIMATOR_H
@@ -0,0 +1,260 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#include "seriesraster.h"
+#include <QPainter>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+
+//...Reduces one series to the plot width and converts it to pixels
+class SeriesRaster::WindowBuilder {
+ public:
+  explicit WindowBuilder(SeriesRaster *raster) : m_raster(raster) {}
+
+  void operator()(const int &index) {
+    const SeriesRaster *r = this->m_raster;
+    QVector<QPointF> w = r->m_pyramids.at(index)->window(
+        r->m_xmin, r->m_xmax, r->m_size.width());
+
+    const qreal sx = r->m_size.width() / (r->m_xmax - r->m_xmin);
+    const qreal sy = r->m_size.height() / (r->m_ymax - r->m_ymin);
+    for (int i = 0; i < w.size(); ++i) {
+      w[i].rx() = (w[i].x() - r->m_xmin) * sx;
+      w[i].ry() = (r->m_ymax - w[i].y()) * sy;
+    }
+
+    //...The vector was detached before the workers started, so each
+    //   worker only ever touches its own element
+    this->m_raster->m_windows.data()[index] = w;
+  }
+
+ private:
+  SeriesRaster *m_raster;
+};
+
+class SeriesRaster::TileRenderer {
+ public:
+  explicit TileRenderer(SeriesRaster *raster) : m_raster(raster) {}
+
+  void operator()(Tile &tile) { this->m_raster->paintTile(tile); }
+
+ private:
+  SeriesRaster *m_raster;
+};
+
+SeriesRaster::SeriesRaster()
+    : m_xmin(0.0), m_xmax(0.0), m_ymin(0.0), m_ymax(0.0) {}
+
+void SeriesRaster::addSeries(const QVector<QPointF> &points,
+                             const QString &name, const QPen &pen) {
+  this->m_pyramids.push_back(
+      QSharedPointer<SeriesPyramid>(new SeriesPyramid(points)));
+  this->m_names.push_back(name);
+  this->m_pens.push_back(pen);
+}
+
+void SeriesRaster::clear() {
+  this->m_pyramids.clear();
+  this->m_names.clear();
+  this->m_pens.clear();
+  this->m_windows.clear();
+  this->m_columns.clear();
+  this->m_size = QSize();
+}
+
+//...The pyramids must not be building while this runs
+void SeriesRaster::shift(qreal dx) {
+  for (int i = 0; i < this->m_pyramids.size(); ++i)
+    this->m_pyramids[i]->shift(dx);
+}
+
+bool SeriesRaster::isEmpty() const { return this->m_pyramids.isEmpty(); }
+
+int SeriesRaster::size() const { return this->m_pyramids.size(); }
+
+QString SeriesRaster::name(int index) const { return this->m_names.at(index); }
+
+const QVector<QSharedPointer<SeriesPyramid>> &SeriesRaster::pyramids() const {
+  return this->m_pyramids;
+}
+
+//...Returns a transparent image of the given size with every series drawn
+//   for the given window. Decimation and painting are both spread over the
+//   global thread pool; the call returns once the image is complete
+QImage SeriesRaster::render(const QSize &size, qreal xmin, qreal xmax,
+                            qreal ymin, qreal ymax) {
+  this->m_size = size;
+  this->m_xmin = xmin;
+  this->m_xmax = xmax;
+  this->m_ymin = ymin;
+  this->m_ymax = ymax;
+  this->m_windows.clear();
+  this->m_columns.clear();
+
+  if (this->isEmpty() || size.isEmpty() || xmax <= xmin || ymax <= ymin)
+    return QImage();
+
+  QVector<int> series(this->m_pyramids.size());
+  for (int i = 0; i < series.size(); ++i) series[i] = i;
+  this->m_windows.resize(series.size());
+  this->m_windows.data();
+  QtConcurrent::blockingMap(series, WindowBuilder(this));
+
+  QVector<Tile> tiles;
+  for (int first = 0; first < size.width(); first += tileWidth) {
+    Tile tile;
+    tile.first = first;
+    tile.last = std::min(first + tileWidth, size.width());
+    tiles.push_back(tile);
+  }
+  this->m_columns.resize(size.width());
+  this->m_columns.data();
+  QtConcurrent::blockingMap(tiles, TileRenderer(this));
+
+  QImage image(size, QImage::Format_ARGB32_Premultiplied);
+  image.fill(Qt::transparent);
+  QPainter painter(&image);
+  for (int i = 0; i < tiles.size(); ++i)
+    painter.drawImage(tiles[i].first, 0, tiles[i].image);
+  painter.end();
+
+  return image;
+}
+
+//...Paints the pixel columns [first, last) of every series. Points just
+//   outside the tile are included so that lines and pen caps crossing the
+//   tile edge are drawn the same as in a single pass
+void SeriesRaster::paintTile(Tile &tile) {
+  tile.image = QImage(tile.last - tile.first, this->m_size.height(),
+                      QImage::Format_ARGB32_Premultiplied);
+  tile.image.fill(Qt::transparent);
+
+  QPainter painter(&tile.image);
+  painter.setRenderHint(QPainter::Antialiasing);
+  painter.translate(-tile.first, 0);
+
+  for (int s = 0; s < this->m_windows.size(); ++s) {
+    const QVector<QPointF> &w = this->m_windows.at(s);
+    const QPen &pen = this->m_pens.at(s);
+    if (w.isEmpty() || pen.style() == Qt::NoPen) continue;
+
+    const qreal pad = std::max<qreal>(pen.widthF(), 1.0);
+    QVector<QPointF>::const_iterator lo = std::lower_bound(
+        w.constBegin(), w.constEnd(), tile.first - pad,
+        [](const QPointF &p, qreal x) { return p.x() < x; });
+    QVector<QPointF>::const_iterator hi = std::upper_bound(
+        w.constBegin(), w.constEnd(), tile.last + pad,
+        [](qreal x, const QPointF &p) { return x < p.x(); });
+    if (lo != w.constBegin()) --lo;
+    if (hi != w.constEnd()) ++hi;
+
+    const int a = static_cast<int>(lo - w.constBegin());
+    const int b = static_cast<int>(hi - w.constBegin());
+    if (b - a < 1) continue;
+
+    painter.setPen(pen);
+    if (b - a == 1) {
+      painter.drawPoint(w[a]);
+      this->indexSegment(w[a], w[a], s, tile.first, tile.last);
+    } else {
+      painter.drawPolyline(w.constData() + a, b - a);
+      for (int j = a; j < b - 1; ++j)
+        this->indexSegment(w[j], w[j + 1], s, tile.first, tile.last);
+    }
+  }
+  painter.end();
+}
+
+//...Records the vertical extent of a line segment in each pixel column it
+//   crosses, limited to the columns [first, last) owned by the caller
+void SeriesRaster::indexSegment(const QPointF &p, const QPointF &q,
+                                int series, int first, int last) {
+  const int c0 =
+      static_cast<int>(std::max<qreal>(first, std::floor(p.x())));
+  const int c1 =
+      static_cast<int>(std::min<qreal>(last - 1, std::floor(q.x())));
+  QVector<Span> *columns = this->m_columns.data();
+
+  for (int c = c0; c <= c1; ++c) {
+    qreal y0 = p.y(), y1 = q.y();
+    if (q.x() > p.x()) {
+      const qreal slope = (q.y() - p.y()) / (q.x() - p.x());
+      y0 = p.y() + (std::max<qreal>(p.x(), c) - p.x()) * slope;
+      y1 = p.y() + (std::min<qreal>(q.x(), c + 1) - p.x()) * slope;
+    }
+    const float low = static_cast<float>(std::min(y0, y1));
+    const float high = static_cast<float>(std::max(y0, y1));
+
+    QVector<Span> &column = columns[c];
+    if (!column.isEmpty() && column.last().series == series) {
+      column.last().low = std::min(column.last().low, low);
+      column.last().high = std::max(column.last().high, high);
+    } else {
+      Span span;
+      span.series = series;
+      span.low = low;
+      span.high = high;
+      column.push_back(span);
+    }
+  }
+}
+
+//...Finds the series drawn closest to (x, y), within a few pixels, in the
+//   last rendered image. The value returned is taken from the full
+//   resolution series at x
+bool SeriesRaster::hitTest(qreal x, qreal y, int &index, qreal &value) const {
+  if (this->m_columns.isEmpty()) return false;
+
+  const qreal px =
+      (x - this->m_xmin) * this->m_size.width() / (this->m_xmax - this->m_xmin);
+  const qreal py = (this->m_ymax - y) * this->m_size.height() /
+                   (this->m_ymax - this->m_ymin);
+  const int c = static_cast<int>(std::floor(px));
+
+  int best = -1;
+  qreal bestDistance = hitRadius + 1;
+  for (int dc = -hitRadius; dc <= hitRadius; ++dc) {
+    if (c + dc < 0 || c + dc >= this->m_columns.size()) continue;
+    const QVector<Span> &column = this->m_columns.at(c + dc);
+    for (int i = 0; i < column.size(); ++i) {
+      qreal dy = 0.0;
+      if (py < column[i].low)
+        dy = column[i].low - py;
+      else if (py > column[i].high)
+        dy = py - column[i].high;
+      const qreal distance = dy + std::abs(dc);
+      if (distance < bestDistance) {
+        bestDistance = distance;
+        best = column[i].series;
+      }
+    }
+  }
+  if (best < 0) return false;
+
+  const QVector<QPointF> &points = this->m_pyramids.at(best)->points();
+  QVector<QPointF>::const_iterator it = std::lower_bound(
+      points.constBegin(), points.constEnd(), x,
+      [](const QPointF &p, qreal v) { return p.x() < v; });
+  if (it == points.constEnd()) --it;
+
+  index = best;
+  value = it->y();
+  return true;
+}
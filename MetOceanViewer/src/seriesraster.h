@@ -0,0 +1,92 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#ifndef SERIESRASTER_H
+#define SERIESRASTER_H
+
+#include <QImage>
+#include <QPen>
+#include <QPointF>
+#include <QSharedPointer>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include "seriesdecimator.h"
+
+//...Draws a large number of time series into one image instead of giving
+//   each its own chart series. The plot is split into vertical tiles that
+//   are painted on worker threads with the raster paint engine, so no
+//   display or GPU is needed. While painting, each tile records which
+//   series pass through each of its pixel columns, which is what hitTest()
+//   uses to find the series under the cursor
+class SeriesRaster {
+ public:
+  SeriesRaster();
+
+  void addSeries(const QVector<QPointF> &points, const QString &name,
+                 const QPen &pen);
+  void clear();
+  void shift(qreal dx);
+
+  bool isEmpty() const;
+  int size() const;
+  QString name(int index) const;
+
+  const QVector<QSharedPointer<SeriesPyramid>> &pyramids() const;
+
+  QImage render(const QSize &size, qreal xmin, qreal xmax, qreal ymin,
+                qreal ymax);
+
+  bool hitTest(qreal x, qreal y, int &index, qreal &value) const;
+
+ private:
+  static const int tileWidth = 128;
+  static const int hitRadius = 6;
+
+  struct Span {
+    int series;
+    float low;
+    float high;
+  };
+
+  struct Tile {
+    int first;
+    int last;
+    QImage image;
+  };
+
+  class TileRenderer;
+  class WindowBuilder;
+
+  void paintTile(Tile &tile);
+  void indexSegment(const QPointF &p, const QPointF &q, int series,
+                    int first, int last);
+
+  QVector<QSharedPointer<SeriesPyramid>> m_pyramids;
+  QVector<QString> m_names;
+  QVector<QPen> m_pens;
+
+  //...Pixel coordinates and column index from the last render
+  QVector<QVector<QPointF>> m_windows;
+  QVector<QVector<Span>> m_columns;
+  QSize m_size;
+  qreal m_xmin, m_xmax, m_ymin, m_ymax;
+};
+
+#endif  // SERIESRASTER_H
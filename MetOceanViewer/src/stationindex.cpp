@@ -0,0 +1,206 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#include "stationindex.h"
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+StationIndex::StationIndex(const QVector<Station> &stations, bool activeOnly)
+    : m_data(stations.constData()),
+      m_size(stations.size()),
+      m_positions(stations.size()),
+      m_levels(maxClusterZoom + 1) {
+  //...Finest level first. Clusters hold coordinate sums until every level
+  //   has been merged
+  const double scale = static_cast<double>(1 << maxClusterZoom) / cellSize;
+  Level &leaf = this->m_levels[maxClusterZoom];
+  for (int i = 0; i < stations.size(); ++i) {
+    if (activeOnly && !stations[i].active()) continue;
+
+    QPointF p = StationIndex::project(stations[i].coordinate().longitude(),
+                                      stations[i].coordinate().latitude());
+    this->m_positions[i] = p;
+
+    qint64 key =
+        StationIndex::cellKey(static_cast<int>(std::floor(p.x() * scale)),
+                              static_cast<int>(std::floor(p.y() * scale)));
+    this->m_cells[key].push_back(i);
+
+    Level::iterator it = leaf.find(key);
+    if (it == leaf.end()) {
+      Cluster c = {p.x(), p.y(), 1, i};
+      leaf.insert(key, c);
+    } else {
+      it->x += p.x();
+      it->y += p.y();
+      it->count++;
+    }
+  }
+
+  for (int z = maxClusterZoom - 1; z >= 0; --z) {
+    const Level &below = this->m_levels[z + 1];
+    Level &level = this->m_levels[z];
+    for (Level::const_iterator c = below.constBegin(); c != below.constEnd();
+         ++c) {
+      int cx = static_cast<int>(c.key() >> 32);
+      int cy = static_cast<int>(c.key() & 0xffffffff);
+      qint64 key = StationIndex::cellKey(cx >> 1, cy >> 1);
+      Level::iterator it = level.find(key);
+      if (it == level.end()) {
+        level.insert(key, c.value());
+      } else {
+        it->x += c.value().x;
+        it->y += c.value().y;
+        it->count += c.value().count;
+      }
+    }
+  }
+
+  for (int z = 0; z <= maxClusterZoom; ++z) {
+    for (Level::iterator it = this->m_levels[z].begin();
+         it != this->m_levels[z].end(); ++it) {
+      it->x /= it->count;
+      it->y /= it->count;
+    }
+  }
+}
+
+//...The index refers into the catalog it was built from, so it is only
+//   usable while that vector is unchanged
+bool StationIndex::matches(const QVector<Station> &stations) const {
+  return stations.constData() == this->m_data &&
+         stations.size() == this->m_size;
+}
+
+//...Web mercator at zoom 0, a 256 unit square. Longitudes run 0 to 360,
+//   like the viewport box used by MapFunctions
+QPointF StationIndex::project(double longitude, double latitude) {
+  if (longitude < 0.0) longitude += 360.0;
+  latitude = std::max(-85.05112878, std::min(85.05112878, latitude));
+  double s = std::sin(qDegreesToRadians(latitude));
+  return QPointF(longitude / 360.0 * 256.0,
+                 (0.5 - std::log((1.0 + s) / (1.0 - s)) / (4.0 * M_PI)) *
+                     256.0);
+}
+
+QGeoCoordinate StationIndex::unproject(double x, double y) {
+  double longitude = x / 256.0 * 360.0;
+  if (longitude > 180.0) longitude -= 360.0;
+  double n = M_PI - 2.0 * M_PI * y / 256.0;
+  return QGeoCoordinate(qRadiansToDegrees(std::atan(std::sinh(n))),
+                        longitude);
+}
+
+qint64 StationIndex::cellKey(int cx, int cy) {
+  return (static_cast<qint64>(cx) << 32) | static_cast<quint32>(cy);
+}
+
+void StationIndex::appendCluster(const Cluster &cluster,
+                                 QVector<Marker> &markers) const {
+  Marker m;
+  if (cluster.count == 1) {
+    m.coordinate = this->m_data[cluster.station].coordinate();
+    m.station = cluster.station;
+  } else {
+    m.coordinate = StationIndex::unproject(cluster.x, cluster.y);
+    m.station = -1;
+  }
+  m.count = cluster.count;
+  markers.push_back(m);
+}
+
+//...Stations of one finest level cell that fall inside the box
+void StationIndex::appendStations(const QVector<int> &cell,
+                                  const QPointF &topLeft,
+                                  const QPointF &bottomRight,
+                                  QVector<Marker> &markers) const {
+  for (int i = 0; i < cell.size(); ++i) {
+    const int s = cell[i];
+    const QPointF &p = this->m_positions[s];
+    if (p.x() < topLeft.x() || p.x() > bottomRight.x() ||
+        p.y() < topLeft.y() || p.y() > bottomRight.y())
+      continue;
+    Marker m = {this->m_data[s].coordinate(), 1, s};
+    markers.push_back(m);
+  }
+}
+
+//...Markers for the box [xl, xr] x [yb, yt] (longitudes 0 to 360) at the
+//   given map zoom. Past maxClusterZoom every station in view is returned
+//   on its own; below it, a marker may stand for a whole cell, in which
+//   case station is -1 and count is the number of stations it holds
+QVector<StationIndex::Marker> StationIndex::query(double xl, double xr,
+                                                  double yb, double yt,
+                                                  double zoom) const {
+  QVector<Marker> markers;
+  QPointF topLeft = StationIndex::project(xl, yt);
+  QPointF bottomRight = StationIndex::project(xr, yb);
+  if (xr >= 360.0) bottomRight.setX(256.0);
+
+  const int level = std::max(
+      0, std::min(maxClusterZoom, static_cast<int>(std::floor(zoom))));
+  const double scale = static_cast<double>(1 << level) / cellSize;
+  const int cx0 = static_cast<int>(std::floor(topLeft.x() * scale));
+  const int cx1 = static_cast<int>(std::floor(bottomRight.x() * scale));
+  const int cy0 = static_cast<int>(std::floor(topLeft.y() * scale));
+  const int cy1 = static_cast<int>(std::floor(bottomRight.y() * scale));
+  const qint64 nCells = static_cast<qint64>(cx1 - cx0 + 1) * (cy1 - cy0 + 1);
+
+  //...When the view holds more cells than are occupied, walking the
+  //   occupied cells is cheaper
+  if (zoom >= maxClusterZoom + 1) {
+    if (nCells > this->m_cells.size()) {
+      for (QHash<qint64, QVector<int>>::const_iterator it =
+               this->m_cells.constBegin();
+           it != this->m_cells.constEnd(); ++it)
+        this->appendStations(it.value(), topLeft, bottomRight, markers);
+    } else {
+      for (int cx = cx0; cx <= cx1; ++cx) {
+        for (int cy = cy0; cy <= cy1; ++cy) {
+          QHash<qint64, QVector<int>>::const_iterator it =
+              this->m_cells.find(StationIndex::cellKey(cx, cy));
+          if (it != this->m_cells.constEnd())
+            this->appendStations(it.value(), topLeft, bottomRight, markers);
+        }
+      }
+    }
+    return markers;
+  }
+
+  const Level &clusters = this->m_levels[level];
+  if (nCells > clusters.size()) {
+    for (Level::const_iterator it = clusters.constBegin();
+         it != clusters.constEnd(); ++it) {
+      int cx = static_cast<int>(it.key() >> 32);
+      int cy = static_cast<int>(it.key() & 0xffffffff);
+      if (cx >= cx0 && cx <= cx1 && cy >= cy0 && cy <= cy1)
+        this->appendCluster(it.value(), markers);
+    }
+  } else {
+    for (int cx = cx0; cx <= cx1; ++cx) {
+      for (int cy = cy0; cy <= cy1; ++cy) {
+        Level::const_iterator it =
+            clusters.find(StationIndex::cellKey(cx, cy));
+        if (it != clusters.constEnd()) this->appendCluster(it.value(), markers);
+      }
+    }
+  }
+  return markers;
+}
@@ -0,0 +1,80 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#ifndef STATIONINDEX_H
+#define STATIONINDEX_H
+
+#include <QGeoCoordinate>
+#include <QHash>
+#include <QPointF>
+#include <QVector>
+#include "station.h"
+
+//...Viewport index and zoom dependent clustering over a station catalog.
+//   Stations are placed on the web mercator plane and binned into square
+//   cells of cellSize pixels at every zoom level up to maxClusterZoom,
+//   each level built by merging 2x2 cells of the one below. A query only
+//   visits the cells in view, so its cost follows the number of markers
+//   shown rather than the size of the catalog
+class StationIndex {
+ public:
+  struct Marker {
+    QGeoCoordinate coordinate;
+    int count;
+    int station;
+  };
+
+  StationIndex(const QVector<Station> &stations, bool activeOnly);
+
+  bool matches(const QVector<Station> &stations) const;
+
+  QVector<Marker> query(double xl, double xr, double yb, double yt,
+                        double zoom) const;
+
+  static QPointF project(double longitude, double latitude);
+
+ private:
+  static const int cellSize = 64;
+  static const int maxClusterZoom = 16;
+
+  struct Cluster {
+    double x;
+    double y;
+    int count;
+    int station;
+  };
+
+  typedef QHash<qint64, Cluster> Level;
+
+  static QGeoCoordinate unproject(double x, double y);
+  static qint64 cellKey(int cx, int cy);
+
+  void appendCluster(const Cluster &cluster, QVector<Marker> &markers) const;
+  void appendStations(const QVector<int> &cell, const QPointF &topLeft,
+                      const QPointF &bottomRight,
+                      QVector<Marker> &markers) const;
+
+  const Station *m_data;
+  int m_size;
+  QVector<QPointF> m_positions;
+  QVector<Level> m_levels;
+  QHash<qint64, QVector<int>> m_cells;
+};
+
+#endif  // STATIONINDEX_H
@@ -0,0 +1,477 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#include "stationmarkerlayer.h"
+#include <QCursor>
+#include <QPainter>
+#include <QQuickWindow>
+#include <QSGGeometryNode>
+#include <QSGImageNode>
+#include <QSGRendererInterface>
+#include <QSGVertexColorMaterial>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include "stationindex.h"
+
+//...Same colors as the marker images used for each category
+static const QColor c_categoryColors[] = {
+    QColor(128, 0, 128),   QColor(0, 0, 139),   QColor(173, 216, 230),
+    QColor(0, 100, 0),     QColor(144, 238, 144), QColor(255, 255, 0),
+    QColor(255, 140, 0),   QColor(255, 0, 0)};
+static const int c_nCategoryColors = 8;
+static const QColor c_clusterColor(31, 110, 67, 204);
+static const QColor c_outlineColor(40, 40, 40);
+static const QColor c_selectedColor(255, 0, 0);
+
+StationMarkerLayer::StationMarkerLayer(QQuickItem *parent)
+    : QQuickItem(parent),
+      m_zoomLevel(0.0),
+      m_mode(0),
+      m_hoveredRow(-1),
+      m_pressedRow(-1),
+      m_reloadPending(false),
+      m_hovering(false) {
+  this->setFlag(QQuickItem::ItemHasContents, true);
+  this->setAcceptedMouseButtons(Qt::AllButtons);
+  this->setAcceptHoverEvents(true);
+}
+
+QObject *StationMarkerLayer::model() const { return this->m_model.data(); }
+
+void StationMarkerLayer::setModel(QObject *model) {
+  QAbstractItemModel *m = qobject_cast<QAbstractItemModel *>(model);
+  if (m == this->m_model) return;
+
+  if (this->m_model) this->m_model->disconnect(this);
+  this->m_model = m;
+  if (m) {
+    connect(m, SIGNAL(modelReset()), this, SLOT(scheduleReload()));
+    connect(m, SIGNAL(layoutChanged()), this, SLOT(scheduleReload()));
+    connect(m, SIGNAL(rowsInserted(QModelIndex, int, int)), this,
+            SLOT(scheduleReload()));
+    connect(m, SIGNAL(rowsRemoved(QModelIndex, int, int)), this,
+            SLOT(scheduleReload()));
+    connect(m, SIGNAL(dataChanged(QModelIndex, QModelIndex, QVector<int>)),
+            this, SLOT(scheduleReload()));
+  }
+  emit modelChanged();
+  this->reloadModel();
+}
+
+QGeoCoordinate StationMarkerLayer::center() const { return this->m_center; }
+
+void StationMarkerLayer::setCenter(const QGeoCoordinate &center) {
+  if (center == this->m_center) return;
+  this->m_center = center;
+  emit centerChanged();
+  this->reproject();
+}
+
+qreal StationMarkerLayer::zoomLevel() const { return this->m_zoomLevel; }
+
+void StationMarkerLayer::setZoomLevel(qreal zoomLevel) {
+  if (zoomLevel == this->m_zoomLevel) return;
+  this->m_zoomLevel = zoomLevel;
+  emit zoomLevelChanged();
+  this->reproject();
+}
+
+int StationMarkerLayer::mode() const { return this->m_mode; }
+
+void StationMarkerLayer::setMode(int mode) {
+  if (mode == this->m_mode) return;
+  this->m_mode = mode;
+  emit modeChanged();
+  this->reloadModel();
+}
+
+int StationMarkerLayer::hoveredRow() const { return this->m_hoveredRow; }
+
+void StationMarkerLayer::setHoveredRow(int row) {
+  if (row == this->m_hoveredRow) return;
+  this->m_hoveredRow = row;
+  this->setCursor(row >= 0 ? Qt::PointingHandCursor : Qt::ArrowCursor);
+  emit hoveredRowChanged();
+}
+
+QColor StationMarkerLayer::markerColor(int category, bool active,
+                                       double modeled) const {
+  if (this->m_mode == 2) {
+    if (modeled < -900.0) return QColor(Qt::white);
+    category = std::max(0, std::min(c_nCategoryColors - 1, category));
+    return c_categoryColors[category];
+  } else if (this->m_mode == 3) {
+    return active ? c_categoryColors[3] : c_categoryColors[6];
+  }
+  return c_categoryColors[3];
+}
+
+//...Model changes only mark the layer, and the rows are read once in the
+//   polish pass before the next frame. A pan that swaps markers through
+//   many inserts and removals then costs one read instead of one a signal
+void StationMarkerLayer::scheduleReload() {
+  this->m_reloadPending = true;
+  this->polish();
+}
+
+void StationMarkerLayer::updatePolish() {
+  if (this->m_reloadPending) this->reloadModel();
+}
+
+//...Rows are read once per model change and kept in mercator units, so
+//   panning and zooming only redo the screen transform
+void StationMarkerLayer::reloadModel() {
+  this->m_reloadPending = false;
+  this->m_markers.clear();
+
+  if (this->m_model) {
+    QHash<int, QByteArray> roles = this->m_model->roleNames();
+    const int position = roles.key("position", -1);
+    const int id = roles.key("id", -1);
+    const int category = roles.key("category", -1);
+    const int active = roles.key("active", -1);
+    const int modeled = roles.key("modeled", -1);
+    const int clusterCount = roles.key("clusterCount", -1);
+
+    const int nRows = this->m_model->rowCount();
+    this->m_markers.reserve(nRows);
+    for (int row = 0; row < nRows; ++row) {
+      QModelIndex index = this->m_model->index(row, 0);
+      QGeoCoordinate c = index.data(position).value<QGeoCoordinate>();
+
+      Marker m;
+      m.world = StationIndex::project(c.longitude(), c.latitude());
+      m.id = index.data(id).toString();
+      m.clusterSize =
+          clusterCount < 0 ? 1 : std::max(1, index.data(clusterCount).toInt());
+      m.color = m.clusterSize > 1
+                    ? c_clusterColor
+                    : this->markerColor(
+                          index.data(category).toInt(),
+                          active < 0 ? true : index.data(active).toBool(),
+                          modeled < 0 ? 0.0 : index.data(modeled).toDouble());
+      this->m_markers.push_back(m);
+    }
+  }
+
+  //...Rows may have moved, so the hover is found again at the pointer
+  this->m_pressedRow = -1;
+  this->reproject();
+  this->setHoveredRow(this->m_hovering
+                          ? this->markerAt(this->m_hoverPosition.x(),
+                                           this->m_hoverPosition.y())
+                          : -1);
+}
+
+qint64 StationMarkerLayer::cellKey(int cx, int cy) {
+  return (static_cast<qint64>(cx) << 32) | static_cast<quint32>(cy);
+}
+
+//...Screen positions from the map center and zoom, assuming 256 pixel
+//   tiles as the QtLocation map does, and the hit test grid for the
+//   markers that land on screen
+void StationMarkerLayer::reproject() {
+  this->m_grid.clear();
+
+  const QPointF c = StationIndex::project(this->m_center.longitude(),
+                                          this->m_center.latitude());
+  const qreal scale = std::pow(2.0, this->m_zoomLevel);
+  const qreal margin = 2 * cellSize;
+
+  for (int i = 0; i < this->m_markers.size(); ++i) {
+    Marker &m = this->m_markers[i];
+    qreal dx = m.world.x() - c.x();
+    if (dx > 128.0)
+      dx -= 256.0;
+    else if (dx < -128.0)
+      dx += 256.0;
+    m.position = QPointF(dx * scale + this->width() / 2.0,
+                         (m.world.y() - c.y()) * scale + this->height() / 2.0);
+
+    if (m.position.x() < -margin || m.position.y() < -margin ||
+        m.position.x() > this->width() + margin ||
+        m.position.y() > this->height() + margin)
+      continue;
+    this->m_grid[StationMarkerLayer::cellKey(
+                     static_cast<int>(std::floor(m.position.x() / cellSize)),
+                     static_cast<int>(std::floor(m.position.y() / cellSize)))]
+        .push_back(i);
+  }
+  this->update();
+}
+
+qreal StationMarkerLayer::radius(const Marker &marker) const {
+  if (marker.clusterSize <= 1) return markerRadius;
+  return std::min(24.0, 10.0 + 4.0 * std::log10(marker.clusterSize));
+}
+
+//...Markers on screen, with the selected ones last so they are drawn on
+//   top
+QVector<int> StationMarkerLayer::drawOrder() const {
+  QVector<int> order, selected;
+  for (QHash<qint64, QVector<int>>::const_iterator it = this->m_grid.begin();
+       it != this->m_grid.end(); ++it) {
+    for (int i = 0; i < it->size(); ++i) {
+      const Marker &m = this->m_markers[it->at(i)];
+      if (m.clusterSize <= 1 && this->m_selected.contains(m.id))
+        selected.push_back(it->at(i));
+      else
+        order.push_back(it->at(i));
+    }
+  }
+  std::sort(order.begin(), order.end());
+  std::sort(selected.begin(), selected.end());
+  return order + selected;
+}
+
+//...Row of the marker closest to (x, y) within its radius, or -1
+int StationMarkerLayer::markerAt(qreal x, qreal y) const {
+  const int cx = static_cast<int>(std::floor(x / cellSize));
+  const int cy = static_cast<int>(std::floor(y / cellSize));
+
+  int best = -1;
+  qreal bestDistance = 0.0;
+  for (int i = cx - 1; i <= cx + 1; ++i) {
+    for (int j = cy - 1; j <= cy + 1; ++j) {
+      QHash<qint64, QVector<int>>::const_iterator it =
+          this->m_grid.find(StationMarkerLayer::cellKey(i, j));
+      if (it == this->m_grid.end()) continue;
+      for (int k = 0; k < it->size(); ++k) {
+        const Marker &m = this->m_markers[it->at(k)];
+        const qreal d = std::hypot(m.position.x() - x, m.position.y() - y);
+        if (d > this->radius(m) + 2.0) continue;
+        if (best < 0 || d < bestDistance) {
+          best = it->at(k);
+          bestDistance = d;
+        }
+      }
+    }
+  }
+  return best;
+}
+
+//...All roles of a row by name, for the info window
+QVariantMap StationMarkerLayer::rowData(int row) const {
+  QVariantMap data;
+  if (!this->m_model || row < 0 || row >= this->m_model->rowCount())
+    return data;
+
+  QModelIndex index = this->m_model->index(row, 0);
+  QHash<int, QByteArray> roles = this->m_model->roleNames();
+  for (QHash<int, QByteArray>::const_iterator it = roles.begin();
+       it != roles.end(); ++it)
+    data.insert(QString::fromUtf8(it.value()), index.data(it.key()));
+  return data;
+}
+
+void StationMarkerLayer::select(const QString &id) {
+  if (id.isEmpty()) return;
+  this->m_selected.insert(id);
+  this->update();
+}
+
+void StationMarkerLayer::deselect(const QString &id) {
+  this->m_selected.remove(id);
+  this->update();
+}
+
+void StationMarkerLayer::deselectAll() {
+  this->m_selected.clear();
+  this->update();
+}
+
+bool StationMarkerLayer::isSelected(const QString &id) const {
+  return this->m_selected.contains(id);
+}
+
+QStringList StationMarkerLayer::selectedIds() const {
+  QStringList ids = this->m_selected.toList();
+  ids.sort();
+  return ids;
+}
+
+//...Used for the whole layer by the software scene graph, and for the
+//   cluster counts only when the markers themselves are geometry
+void StationMarkerLayer::paintMarkers(QPainter *painter,
+                                      bool labelsOnly) const {
+  painter->setRenderHint(QPainter::Antialiasing);
+  QFont font = painter->font();
+  font.setBold(true);
+  font.setPixelSize(11);
+  painter->setFont(font);
+
+  QVector<int> order = this->drawOrder();
+  for (int i = 0; i < order.size(); ++i) {
+    const Marker &m = this->m_markers[order[i]];
+    const qreal r = this->radius(m);
+    const QRectF box(m.position.x() - r, m.position.y() - r, 2 * r, 2 * r);
+
+    if (m.clusterSize > 1) {
+      if (!labelsOnly) {
+        painter->setPen(QPen(Qt::white, 2));
+        painter->setBrush(m.color);
+        painter->drawEllipse(box);
+      }
+      painter->setPen(Qt::white);
+      painter->drawText(box, Qt::AlignCenter, QString::number(m.clusterSize));
+    } else if (!labelsOnly) {
+      const bool selected = this->m_selected.contains(m.id);
+      if (selected && this->m_mode == 2) {
+        painter->setPen(QPen(c_selectedColor, 3));
+        painter->setBrush(m.color);
+      } else {
+        painter->setPen(QPen(c_outlineColor, 1.5));
+        painter->setBrush(selected ? c_selectedColor : m.color);
+      }
+      painter->drawEllipse(box);
+    }
+  }
+}
+
+//...One triangle list for every marker on screen: an outline disc and a
+//   fill disc, each an octagon fan
+QSGGeometryNode *StationMarkerLayer::buildGeometry() const {
+  static const int nSides = 8;
+  static const int verticesPerDisc = 3 * nSides;
+
+  QVector<int> order = this->drawOrder();
+  QSGGeometry *geometry =
+      new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(),
+                      2 * verticesPerDisc * order.size());
+  geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+  QSGGeometry::ColoredPoint2D *v = geometry->vertexDataAsColoredPoint2D();
+
+  auto disc = [&v](const QPointF &p, qreal r, const QColor &color) {
+    const uchar a = static_cast<uchar>(color.alpha());
+    const uchar red = static_cast<uchar>(color.red() * a / 255);
+    const uchar green = static_cast<uchar>(color.green() * a / 255);
+    const uchar blue = static_cast<uchar>(color.blue() * a / 255);
+    for (int k = 0; k < nSides; ++k) {
+      const qreal a0 = 2.0 * M_PI * k / nSides;
+      const qreal a1 = 2.0 * M_PI * (k + 1) / nSides;
+      (v++)->set(p.x(), p.y(), red, green, blue, a);
+      (v++)->set(p.x() + r * std::cos(a0), p.y() + r * std::sin(a0), red,
+                 green, blue, a);
+      (v++)->set(p.x() + r * std::cos(a1), p.y() + r * std::sin(a1), red,
+                 green, blue, a);
+    }
+  };
+
+  for (int i = 0; i < order.size(); ++i) {
+    const Marker &m = this->m_markers[order[i]];
+    const qreal r = this->radius(m);
+    const bool selected =
+        m.clusterSize <= 1 && this->m_selected.contains(m.id);
+
+    QColor outline = m.clusterSize > 1 ? QColor(Qt::white) : c_outlineColor;
+    QColor fill = m.color;
+    if (selected && this->m_mode == 2)
+      outline = c_selectedColor;
+    else if (selected)
+      fill = c_selectedColor;
+
+    disc(m.position, r + (selected && this->m_mode == 2 ? 3.0 : 1.5),
+         outline);
+    disc(m.position, r, fill);
+  }
+
+  QSGGeometryNode *node = new QSGGeometryNode;
+  node->setGeometry(geometry);
+  node->setFlag(QSGNode::OwnsGeometry);
+  node->setMaterial(new QSGVertexColorMaterial);
+  node->setFlag(QSGNode::OwnsMaterial);
+  return node;
+}
+
+QSGNode *StationMarkerLayer::updatePaintNode(QSGNode *oldNode,
+                                             UpdatePaintNodeData *data) {
+  Q_UNUSED(data);
+  QSGNode *root = oldNode ? oldNode : new QSGNode;
+  while (QSGNode *child = root->firstChild()) {
+    root->removeChildNode(child);
+    delete child;
+  }
+  if (this->m_grid.isEmpty() || this->width() <= 0 || this->height() <= 0)
+    return root;
+
+  const bool software = this->window()->rendererInterface()->graphicsApi() ==
+                        QSGRendererInterface::Software;
+  if (!software) root->appendChildNode(this->buildGeometry());
+
+  bool hasClusters = false;
+  for (int i = 0; i < this->m_markers.size() && !hasClusters; ++i)
+    hasClusters = this->m_markers[i].clusterSize > 1;
+
+  if (software || hasClusters) {
+    const qreal dpr = this->window()->effectiveDevicePixelRatio();
+    QImage image(qCeil(this->width() * dpr), qCeil(this->height() * dpr),
+                 QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(dpr);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    this->paintMarkers(&painter, !software);
+    painter.end();
+
+    QSGImageNode *node = this->window()->createImageNode();
+    node->setTexture(this->window()->createTextureFromImage(image));
+    node->setOwnsTexture(true);
+    node->setRect(this->boundingRect());
+    root->appendChildNode(node);
+  }
+  return root;
+}
+
+void StationMarkerLayer::geometryChanged(const QRectF &newGeometry,
+                                         const QRectF &oldGeometry) {
+  QQuickItem::geometryChanged(newGeometry, oldGeometry);
+  this->reproject();
+}
+
+//...Presses away from a marker are left to the map so it can still pan
+void StationMarkerLayer::mousePressEvent(QMouseEvent *event) {
+  this->m_pressedRow = this->markerAt(event->localPos().x(),
+                                      event->localPos().y());
+  if (this->m_pressedRow < 0) {
+    event->ignore();
+    return;
+  }
+  event->accept();
+}
+
+void StationMarkerLayer::mouseReleaseEvent(QMouseEvent *event) {
+  int row = this->markerAt(event->localPos().x(), event->localPos().y());
+  if (row >= 0 && row == this->m_pressedRow)
+    emit markerClicked(row, static_cast<int>(event->button()),
+                       static_cast<int>(event->modifiers()));
+  this->m_pressedRow = -1;
+}
+
+void StationMarkerLayer::hoverMoveEvent(QHoverEvent *event) {
+  this->m_hovering = true;
+  this->m_hoverPosition = event->posF();
+  this->setHoveredRow(this->markerAt(event->posF().x(), event->posF().y()));
+  QQuickItem::hoverMoveEvent(event);
+}
+
+void StationMarkerLayer::hoverLeaveEvent(QHoverEvent *event) {
+  this->m_hovering = false;
+  this->setHoveredRow(-1);
+  QQuickItem::hoverLeaveEvent(event);
+}
@@ -0,0 +1,139 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#ifndef STATIONMARKERLAYER_H
+#define STATIONMARKERLAYER_H
+
+#include <QAbstractItemModel>
+#include <QColor>
+#include <QGeoCoordinate>
+#include <QHash>
+#include <QPointer>
+#include <QQuickItem>
+#include <QSet>
+#include <QStringList>
+#include <QVariantMap>
+#include <QVector>
+
+class QPainter;
+class QSGGeometryNode;
+
+//...Draws every row of a StationModel as a map marker in one scene graph
+//   item. With an OpenGL scene graph the markers are a single vertex
+//   coloured geometry node; with the software backend (including offscreen
+//   rendering) they are painted into one image node. Markers are placed on
+//   the web mercator plane from the map center and zoom level, which the
+//   map binds to this item, and found again for clicks and hover through a
+//   screen space grid
+class StationMarkerLayer : public QQuickItem {
+  Q_OBJECT
+  Q_PROPERTY(QObject *model READ model WRITE setModel NOTIFY modelChanged)
+  Q_PROPERTY(QGeoCoordinate center READ center WRITE setCenter NOTIFY
+                 centerChanged)
+  Q_PROPERTY(qreal zoomLevel READ zoomLevel WRITE setZoomLevel NOTIFY
+                 zoomLevelChanged)
+  Q_PROPERTY(int mode READ mode WRITE setMode NOTIFY modeChanged)
+  Q_PROPERTY(int hoveredRow READ hoveredRow NOTIFY hoveredRowChanged)
+
+ public:
+  explicit StationMarkerLayer(QQuickItem *parent = nullptr);
+
+  QObject *model() const;
+  void setModel(QObject *model);
+
+  QGeoCoordinate center() const;
+  void setCenter(const QGeoCoordinate &center);
+
+  qreal zoomLevel() const;
+  void setZoomLevel(qreal zoomLevel);
+
+  int mode() const;
+  void setMode(int mode);
+
+  int hoveredRow() const;
+
+  Q_INVOKABLE int markerAt(qreal x, qreal y) const;
+  Q_INVOKABLE QVariantMap rowData(int row) const;
+
+  Q_INVOKABLE void select(const QString &id);
+  Q_INVOKABLE void deselect(const QString &id);
+  Q_INVOKABLE void deselectAll();
+  Q_INVOKABLE bool isSelected(const QString &id) const;
+  Q_INVOKABLE QStringList selectedIds() const;
+
+ signals:
+  void modelChanged();
+  void centerChanged();
+  void zoomLevelChanged();
+  void modeChanged();
+  void hoveredRowChanged();
+  void markerClicked(int row, int button, int modifiers);
+
+ protected:
+  QSGNode *updatePaintNode(QSGNode *oldNode,
+                           UpdatePaintNodeData *data) override;
+  void geometryChanged(const QRectF &newGeometry,
+                       const QRectF &oldGeometry) override;
+  void updatePolish() override;
+  void mousePressEvent(QMouseEvent *event) override;
+  void mouseReleaseEvent(QMouseEvent *event) override;
+  void hoverMoveEvent(QHoverEvent *event) override;
+  void hoverLeaveEvent(QHoverEvent *event) override;
+
+ private slots:
+  void scheduleReload();
+  void reloadModel();
+
+ private:
+  static const int markerRadius = 6;
+  static const int cellSize = 32;
+
+  struct Marker {
+    QPointF world;
+    QPointF position;
+    QString id;
+    QColor color;
+    int clusterSize;
+  };
+
+  void reproject();
+  void setHoveredRow(int row);
+  QColor markerColor(int category, bool active, double modeled) const;
+  qreal radius(const Marker &marker) const;
+  QVector<int> drawOrder() const;
+  void paintMarkers(QPainter *painter, bool labelsOnly) const;
+  QSGGeometryNode *buildGeometry() const;
+  static qint64 cellKey(int cx, int cy);
+
+  QPointer<QAbstractItemModel> m_model;
+  QGeoCoordinate m_center;
+  qreal m_zoomLevel;
+  int m_mode;
+  int m_hoveredRow;
+  int m_pressedRow;
+  bool m_reloadPending;
+  bool m_hovering;
+  QPointF m_hoverPosition;
+
+  QVector<Marker> m_markers;
+  QHash<qint64, QVector<int>> m_grid;
+  QSet<QString> m_selected;
+};
+
+#endif  // STATIONMARKERLAYER_H
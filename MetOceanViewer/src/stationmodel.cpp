@@ -37,12 +37,15 @@ void StationModel::buildRoles() {
   this->m_roles[startDateRole] = "startDate";
   this->m_roles[endDateRole] = "endDate";
   this->m_roles[activeRole] = "active";
+  this->m_roles[clusterSizeRole] = "clusterCount";
   return;
 }
 
 void StationModel::addMarker(Station &station) {
   this->beginInsertRows(QModelIndex(), rowCount(), rowCount());
   this->m_stations.append(station);
+  this->m_clusterSizes.append(1);
+  this->m_keys.append(StationModel::rowKey(station, 1));
   this->m_stationMap[station.id()] =
       this->m_stations.at(this->m_stations.length() - 1);
   this->m_stationLocationMap[station.id()] = this->m_stations.length() - 1;
@@ -50,9 +53,92 @@ void StationModel::addMarker(Station &station) {
 }
 
 void StationModel::addMarkers(QVector<Station> &stations) {
+  if (stations.isEmpty()) return;
+  this->beginInsertRows(QModelIndex(), rowCount(),
+                        rowCount() + stations.size() - 1);
   for (int i = 0; i < stations.size(); i++) {
-    this->addMarker(stations[i]);
+    this->m_stations.append(stations[i]);
+    this->m_clusterSizes.append(1);
+    this->m_keys.append(StationModel::rowKey(stations[i], 1));
+    this->m_stationMap[stations[i].id()] = stations[i];
+    this->m_stationLocationMap[stations[i].id()] =
+        this->m_stations.length() - 1;
   }
+  this->endInsertRows();
+  return;
+}
+
+//...Stations are identified by id. A cluster has no id, so it is
+//   identified by where it is and how many stations it holds
+QString StationModel::rowKey(const Station &station, int clusterSize) {
+  if (clusterSize <= 1) return station.id();
+  return QStringLiteral("#%1,%2,%3")
+      .arg(station.coordinate().latitude(), 0, 'f', 6)
+      .arg(station.coordinate().longitude(), 0, 'f', 6)
+      .arg(clusterSize);
+}
+
+//...Makes the model hold exactly the given stations. Rows that are already
+//   present keep their place (and their delegates in the map), rows that
+//   are no longer wanted are removed in contiguous runs and the new ones
+//   are appended in one insertion. clusterSizes, if given, runs parallel
+//   to stations and marks entries standing in for more than one station;
+//   those have no id and cannot be selected
+void StationModel::setMarkers(const QVector<Station> &stations,
+                              const QVector<int> &clusterSizes) {
+  QVector<QString> keys(stations.size());
+  QHash<QString, int> incoming;
+  incoming.reserve(stations.size());
+  for (int i = 0; i < stations.size(); i++) {
+    int size = clusterSizes.isEmpty() ? 1 : clusterSizes[i];
+    keys[i] = StationModel::rowKey(stations[i], size);
+    incoming.insert(keys[i], size);
+  }
+
+  //...Removals, from the back so row numbers ahead stay valid
+  int row = this->m_stations.size() - 1;
+  while (row >= 0) {
+    if (incoming.remove(this->m_keys[row]) > 0) {
+      row--;
+      continue;
+    }
+    int last = row;
+    while (row >= 0 && !incoming.contains(this->m_keys[row])) row--;
+    int first = row + 1;
+
+    this->beginRemoveRows(QModelIndex(), first, last);
+    for (int r = first; r <= last; r++)
+      if (this->m_clusterSizes[r] <= 1)
+        this->m_stationMap.remove(this->m_stations[r].id());
+    this->m_stations.erase(this->m_stations.begin() + first,
+                           this->m_stations.begin() + last + 1);
+    this->m_clusterSizes.erase(this->m_clusterSizes.begin() + first,
+                               this->m_clusterSizes.begin() + last + 1);
+    this->m_keys.erase(this->m_keys.begin() + first,
+                       this->m_keys.begin() + last + 1);
+    this->endRemoveRows();
+  }
+
+  //...Whatever is left in incoming is new
+  if (!incoming.isEmpty()) {
+    this->beginInsertRows(QModelIndex(), rowCount(),
+                          rowCount() + incoming.size() - 1);
+    for (int i = 0; i < stations.size(); i++) {
+      QHash<QString, int>::iterator it = incoming.find(keys[i]);
+      if (it == incoming.end()) continue;
+      this->m_stations.append(stations[i]);
+      this->m_clusterSizes.append(it.value());
+      this->m_keys.append(keys[i]);
+      if (it.value() <= 1) this->m_stationMap[stations[i].id()] = stations[i];
+      incoming.erase(it);
+    }
+    this->endInsertRows();
+  }
+
+  this->m_stationLocationMap.clear();
+  for (int r = 0; r < this->m_stations.size(); r++)
+    if (this->m_clusterSizes[r] <= 1)
+      this->m_stationLocationMap[this->m_stations[r].id()] = r;
   return;
 }
 
@@ -95,6 +181,8 @@ QVariant StationModel::data(const QModelIndex &index, int role) const {
         this->m_stations[index.row()].endValidDate().toString("MM/dd/yyyy"));
   } else if (role == StationModel::activeRole) {
     return QVariant::fromValue(this->m_stations[index.row()].active());
+  } else if (role == StationModel::clusterSizeRole) {
+    return QVariant::fromValue(this->m_clusterSizes[index.row()]);
   } else {
     return QVariant();
   }
@@ -201,14 +289,20 @@ void StationModel::fitMarkers(QQuickWidget *quickWidget, StationModel *model,
 void StationModel::clear() {
   this->beginResetModel();
   this->m_stations.clear();
+  this->m_clusterSizes.clear();
+  this->m_keys.clear();
   this->m_stationMap.clear();
+  this->m_stationLocationMap.clear();
   this->endResetModel();
 }
 
 bool StationModel::removeRows(int row, int count, const QModelIndex &parent) {
   beginRemoveRows(parent, row, count - 1);
   this->m_stations.clear();
+  this->m_clusterSizes.clear();
+  this->m_keys.clear();
   this->m_stationMap.clear();
+  this->m_stationLocationMap.clear();
   endRemoveRows();
   return true;
 }
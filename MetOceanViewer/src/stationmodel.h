@@ -48,7 +48,8 @@ class StationModel : public QAbstractListModel {
     selectedRole,
     startDateRole,
     endDateRole,
-    activeRole
+    activeRole,
+    clusterSizeRole
   };
 
   StationModel(QObject *parent = Q_NULLPTR);
@@ -57,6 +58,9 @@ class StationModel : public QAbstractListModel {
 
   void addMarkers(QVector<Station> &stations);
 
+  void setMarkers(const QVector<Station> &stations,
+                  const QVector<int> &clusterSizes = QVector<int>());
+
   int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 
   QVariant data(const QModelIndex &index,
@@ -82,10 +86,14 @@ class StationModel : public QAbstractListModel {
  private:
   void buildRoles();
 
+  static QString rowKey(const Station &station, int clusterSize);
+
   bool removeRows(int row, int count,
                   const QModelIndex &parent = QModelIndex());
 
   QList<Station> m_stations;
+  QList<int> m_clusterSizes;
+  QList<QString> m_keys;
   QHash<QString, Station> m_stationMap;
   QHash<QString, int> m_stationLocationMap;
   QHash<int, QByteArray> m_roles;
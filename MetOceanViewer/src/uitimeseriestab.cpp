@@ -42,6 +42,27 @@ void MainWindow::on_button_saveTimeseriesImage_clicked() {
 }
 //-------------------------------------------//
 
+//-------------------------------------------//
+// Called when the user tries to save the
+// Dflow profile of the selected station
+//-------------------------------------------//
+void MainWindow::on_button_saveTimeseriesProfile_clicked() {
+  if (this->m_userTimeseries == nullptr) return;
+
+  QString Filename;
+  QString TempString = QFileDialog::getSaveFileName(
+      this, tr("Save as..."), this->previousDirectory, "CSV (*.csv)");
+
+  if (TempString == QString()) return;
+
+  Generic::splitPath(TempString, Filename, this->previousDirectory);
+
+  if (this->m_userTimeseries->saveProfile(TempString) != 0)
+    QMessageBox::critical(this, tr("ERROR"),
+                          this->m_userTimeseries->getErrorString());
+}
+//-------------------------------------------//
+
 //-------------------------------------------//
 // Called when the user checks the timeseries
 // auto y axis box
@@ -253,8 +274,16 @@ void MainWindow::on_button_TimeseriesEditRow_clicked() {
 void MainWindow::on_button_processTimeseriesData_clicked() {
   int ierr;
 
+  //...Files are read in the background, so a second click while they
+  //   load cancels the load
+  if (this->m_userTimeseries != nullptr &&
+      this->m_userTimeseries->isProcessing()) {
+    this->m_userTimeseries->cancelProcessing();
+    return;
+  }
+
   // Change the mouse pointer
-  QApplication::setOverrideCursor(Qt::WaitCursor);
+  QApplication::setOverrideCursor(Qt::BusyCursor);
 
   if (this->m_userTimeseries != nullptr) delete this->m_userTimeseries;
 
@@ -269,9 +298,32 @@ void MainWindow::on_button_processTimeseriesData_clicked() {
       &this->userSelectedStations, this);
   connect(this->m_userTimeseries, SIGNAL(timeseriesError(QString)), this,
           SLOT(throwErrorMessageBox(QString)));
+  connect(this->m_userTimeseries, SIGNAL(processingFinished(int)), this,
+          SLOT(userTimeseriesProcessed(int)));
 
   ierr = this->m_userTimeseries->processData();
-  if (ierr != 0)
+  if (ierr != 0) {
+    QMessageBox::critical(this, tr("ERROR"),
+                          this->m_userTimeseries->getErrorString());
+    QApplication::restoreOverrideCursor();
+    return;
+  }
+
+  ui->button_processTimeseriesData->setText(tr("Cancel"));
+}
+//-------------------------------------------//
+
+//-------------------------------------------//
+// Called once the background load of the
+// time series files has finished
+//-------------------------------------------//
+void MainWindow::userTimeseriesProcessed(int ierr) {
+  ui->button_processTimeseriesData->setText(tr("Process Data"));
+
+  if (ierr == MetOceanViewer::Error::LOADCANCELED) {
+    QApplication::restoreOverrideCursor();
+    return;
+  } else if (ierr != 0)
     QMessageBox::critical(this, tr("ERROR"),
                           this->m_userTimeseries->getErrorString());
   else {
@@ -304,6 +356,7 @@ void MainWindow::on_check_TimeseriesAllData_toggled(bool checked) {
 // key is pressed
 //-------------------------------------------//
 void MainWindow::on_button_plotTimeseriesStation_clicked() {
+  if (this->m_userTimeseries->isProcessing()) return;
   this->m_userTimeseries->plot();
   return;
 }
@@ -18,6 +18,13 @@
 //
 //-----------------------------------------------------------------------*/
 #include "usertimeseries.h"
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
 #include "adcircstationoutput.h"
 #include "dflow.h"
 #include "errors.h"
@@ -26,6 +33,7 @@
 #include "generic.h"
 #include "metoceanviewer.h"
 #include "netcdf.h"
+#include "netcdftimeseries.h"
 
 UserTimeseries::UserTimeseries(
     QTableWidget *inTable, QCheckBox *inXAxisCheck, QCheckBox *inYAxisCheck,
@@ -50,11 +58,22 @@ UserTimeseries::UserTimeseries(
   this->m_statusBar = inStatusBar;
   this->m_randomColorList = inRandomColorList;
   this->m_markerId = 0;
+  this->m_rasterPlot = false;
   this->m_stationmodel = inStationModel;
   this->m_currentStation = inSelectedStation;
+
+  connect(&this->m_loadWatcher, SIGNAL(finished()), this,
+          SLOT(filesLoaded()));
+  connect(&this->m_loadWatcher, SIGNAL(progressValueChanged(int)), this,
+          SLOT(loadProgress(int)));
 }
 
-UserTimeseries::~UserTimeseries() {}
+UserTimeseries::~UserTimeseries() {
+  if (this->m_loadWatcher.isRunning()) {
+    this->m_loadWatcher.cancel();
+    this->m_loadWatcher.waitForFinished();
+  }
+}
 
 int UserTimeseries::getDataBounds(double &ymin, double &ymax,
                                   QDateTime &minDateOut, QDateTime &maxDateOut,
@@ -141,6 +160,42 @@ int UserTimeseries::saveImage(QString filename, QString filter) {
   return MetOceanViewer::Error::NOERR;
 }
 
+//...Writes the selected station's section from each Dflow profile row.
+//   With more than one profile row the row number is added to the name
+int UserTimeseries::saveProfile(QString filename) {
+  if (this->m_profiles.isEmpty() || this->m_fileDataUnique.isEmpty()) {
+    this->m_errorString = tr("No Dflow profile has been processed");
+    return MetOceanViewer::Error::NO_VARIABLE_FOUND;
+  }
+
+  QFileInfo info(filename);
+  for (auto it = this->m_profiles.begin(); it != this->m_profiles.end();
+       ++it) {
+    HmdfStation *st =
+        this->m_fileDataUnique[it.key()]->station(this->m_markerId);
+    if (st->isNull()) continue;
+
+    DflowProfile profile;
+    int ierr = it.value()->profile(st->stationIndex(), &profile);
+    if (ierr != MetOceanViewer::Error::NOERR) {
+      this->m_errorString = tr("Error reading the Dflow profile");
+      return ierr;
+    }
+
+    QString name = filename;
+    if (this->m_profiles.size() > 1)
+      name = info.path() + "/" + info.completeBaseName() +
+             QString("_%1.").arg(it.key() + 1) + info.suffix();
+
+    ierr = profile.write(name, 0);
+    if (ierr != MetOceanViewer::Error::NOERR) {
+      this->m_errorString = tr("Error writing file: ") + name;
+      return ierr;
+    }
+  }
+  return MetOceanViewer::Error::NOERR;
+}
+
 int UserTimeseries::getCurrentMarkerID() { return this->m_markerId; }
 
 int UserTimeseries::getClickedMarkerID() {
@@ -188,6 +243,89 @@ Qt::PenStyle UserTimeseries::setPenStyle(const int penIndex) {
   }
 }
 
+//...Unit conversion, time shift (hours) and value shift from the table
+HmdfTransform UserTimeseries::seriesTransform(int index) {
+  double unitConversion = m_checkedSeries[index][3]->text().toDouble();
+  qint64 addX = static_cast<qint64>(
+      m_checkedSeries[index][4]->text().toDouble() * 3.6e+6);
+  double addY = m_checkedSeries[index][5]->text().toDouble();
+  return HmdfTransform(unitConversion, addY, addX);
+}
+
+//...Appends the windowed, transformed data of one station to a series
+int UserTimeseries::appendStationToSeries(HmdfStation *station, int index,
+                                          QVector<QPointF> &points,
+                                          qint64 startDate, qint64 endDate,
+                                          qint64 offset, qint64 &minDate,
+                                          qint64 &maxDate, double &minVal,
+                                          double &maxVal) {
+  HmdfStationView view(station, this->seriesTransform(index));
+  QVector<qint64> date;
+  QVector<double> data;
+  view.series(startDate, endDate, date, data);
+  points.reserve(points.size() + date.size());
+  for (int j = 0; j < date.size(); j++) {
+    const qint64 x = date[j] - offset;
+    maxDate = std::max(x, maxDate);
+    minDate = std::min(x, minDate);
+    maxVal = std::max(data[j], maxVal);
+    minVal = std::min(data[j], minVal);
+    points.push_back(QPointF(x, data[j]));
+  }
+  return date.size();
+}
+
+//...Hands a finished series to the chart, either as its own line series or,
+//   when too many series are selected for QtCharts, to the raster layer
+bool UserTimeseries::addPointsToPlot(const QVector<QPointF> &points,
+                                     const QString &name, const QPen &pen,
+                                     QVector<QLineSeries *> &series) {
+  if (points.isEmpty()) return false;
+
+  if (this->m_rasterPlot) {
+    this->m_chartView->addRasterSeries(points, name, pen);
+    return true;
+  }
+
+  series.push_back(new QLineSeries(this->m_chartView->chart()));
+  QLineSeries *s = series.last();
+  s->setName(name);
+  s->setPen(pen);
+  s->replace(points);
+  this->m_chartView->addSeries(s, s->name());
+  return true;
+}
+
+//...Plots every layer of a Dflow profile row as its own series. The colour
+//   goes from dark at the bottom layer to the series colour at the top
+int UserTimeseries::addProfileToPlot(int index, int stationIndex,
+                                     const QString &name, const QColor &color,
+                                     Qt::PenStyle lineStyle,
+                                     QVector<QLineSeries *> &series,
+                                     qint64 startDate, qint64 endDate,
+                                     qint64 offset, qint64 &minDate,
+                                     qint64 &maxDate, double &minVal,
+                                     double &maxVal) {
+  const QVector<QSharedPointer<Hmdf>> &layers = this->m_profileLayers[index];
+  const int nLayers = layers.size();
+  int nPlotted = 0;
+
+  for (int l = 0; l < nLayers; ++l) {
+    QColor layerColor = color.darker(100 + (200 * (nLayers - 1 - l)) / nLayers);
+    QVector<QPointF> points;
+    this->appendStationToSeries(layers[l]->station(stationIndex), index, points,
+                                startDate, endDate, offset, minDate, maxDate,
+                                minVal, maxVal);
+
+    if (this->addPointsToPlot(
+            points, name + tr(" (layer %1)").arg(l + 1),
+            QPen(layerColor, 3, lineStyle, Qt::RoundCap, Qt::RoundJoin),
+            series))
+      nPlotted++;
+  }
+  return nPlotted;
+}
+
 void UserTimeseries::addSingleStationToPlot(Hmdf *h, int &plottedSeriesCounter,
                                             int &seriesCounter,
                                             QVector<QLineSeries *> &series,
@@ -196,40 +334,35 @@ void UserTimeseries::addSingleStationToPlot(Hmdf *h, int &plottedSeriesCounter,
                                             qint64 &maxDate, double &minVal,
                                             double &maxVal) {
   seriesCounter++;
-  series.push_back(new QLineSeries(this->m_chartView->chart()));
-  QLineSeries *s = series.last();
   QColor seriesColor;
 
-  s->setName(m_checkedSeries[seriesCounter - 1][1]->text());
+  QString name = m_checkedSeries[seriesCounter - 1][1]->text();
 
   seriesColor.setNamedColor(m_checkedSeries[seriesCounter - 1][2]->text());
   Qt::PenStyle lineStyle =
       setPenStyle(m_checkedSeries[seriesCounter - 1][14]->text().toInt());
-  s->setPen(QPen(seriesColor, 3, lineStyle, Qt::RoundCap, Qt::RoundJoin));
-
-  double unitConversion =
-      m_checkedSeries[seriesCounter - 1][3]->text().toDouble();
-  qint64 addX = static_cast<qint64>(
-      m_checkedSeries[seriesCounter - 1][4]->text().toDouble() * 3.6e+6);
-  double addY = m_checkedSeries[seriesCounter - 1][5]->text().toDouble();
 
   HmdfStation *st = h->station(this->m_markerId);
-  for (size_t j = 0; j < h->station(this->m_markerId)->numSnaps(); j++) {
-    if (std::abs(st->data(j) - st->nullValue()) > 0.0001 &&
-        st->date(j) >= startDate && st->date(j) <= endDate) {
-      maxDate = std::max(st->date(j) + addX - offset, maxDate);
-      minDate = std::min(st->date(j) + addX - offset, minDate);
-      maxVal = std::max(st->data(j) * unitConversion + addY, maxVal);
-      minVal = std::min(st->data(j) * unitConversion + addY, minVal);
-      s->append(st->date(j) + addX - offset,
-                st->data(j) * unitConversion + addY);
-    }
+  if (this->m_profileLayers.contains(seriesCounter - 1)) {
+    if (!st->isNull() &&
+        this->addProfileToPlot(seriesCounter - 1, st->stationIndex(), name,
+                               seriesColor, lineStyle, series, startDate,
+                               endDate, offset, minDate, maxDate, minVal,
+                               maxVal) > 0)
+      plottedSeriesCounter++;
+    return;
   }
 
-  if (s->points().size() > 0) {
+  QVector<QPointF> points;
+  this->appendStationToSeries(st, seriesCounter - 1, points, startDate,
+                              endDate, offset, minDate, maxDate, minVal,
+                              maxVal);
+
+  if (this->addPointsToPlot(
+          points, name,
+          QPen(seriesColor, 3, lineStyle, Qt::RoundCap, Qt::RoundJoin),
+          series))
     plottedSeriesCounter++;
-    this->m_chartView->addSeries(s, s->name());
-  }
   return;
 }
 
@@ -247,42 +380,50 @@ void UserTimeseries::addMultipleStationsToPlot(
       //...Loop the colors
       if (colorCounter >= this->m_randomColorList.length()) colorCounter = 0;
 
-      series.push_back(new QLineSeries(this->m_chartView->chart()));
-      QLineSeries *s = series.last();
-
-      s->setName(st->name() + QStringLiteral(": ") +
-                 m_checkedSeries[index][1]->text());
+      QString name =
+          st->name() + QStringLiteral(": ") + m_checkedSeries[index][1]->text();
       QColor seriesColor = this->m_randomColorList[colorCounter];
 
       Qt::PenStyle lineStyle =
           setPenStyle(m_checkedSeries[index][14]->text().toInt());
-      s->setPen(QPen(seriesColor, 3, lineStyle, Qt::RoundCap, Qt::RoundJoin));
-
-      double unitConversion = m_checkedSeries[index][3]->text().toDouble();
-      qint64 addX = static_cast<qint64>(
-          m_checkedSeries[index][4]->text().toDouble() * 3.6e+6);
-      double addY = m_checkedSeries[index][5]->text().toDouble();
-
-      for (size_t j = 0; j < st->numSnaps(); j++) {
-        if (std::abs(st->data(j) - st->nullValue()) > 0.0001 &&
-            st->date(j) >= startDate && st->date(j) <= endDate) {
-          maxDate = std::max(st->date(j) + addX - offset, maxDate);
-          minDate = std::min(st->date(j) + addX - offset, minDate);
-          maxVal = std::max(st->data(j) * unitConversion + addY, maxVal);
-          minVal = std::min(st->data(j) * unitConversion + addY, minVal);
-          s->append(st->date(j) + addX - offset,
-                    st->data(j) * unitConversion + addY);
-        }
-      }
 
-      if (s->points().size() > 0) {
-        this->m_chartView->addSeries(s, s->name());
+      if (this->m_profileLayers.contains(index)) {
+        this->addProfileToPlot(index, st->stationIndex(), name, seriesColor,
+                               lineStyle, series, startDate, endDate, offset,
+                               minDate, maxDate, minVal, maxVal);
+        continue;
       }
+
+      QVector<QPointF> points;
+      this->appendStationToSeries(st, index, points, startDate, endDate,
+                                  offset, minDate, maxDate, minVal, maxVal);
+      this->addPointsToPlot(
+          points, name,
+          QPen(seriesColor, 3, lineStyle, Qt::RoundCap, Qt::RoundJoin),
+          series);
     }
   }
   return;
 }
 
+//...Gives the legend one entry per file when the series themselves are
+//   drawn into the raster layer
+void UserTimeseries::addRasterLegend() {
+  for (int i = 0; i < this->m_fileDataUnique.length(); i++) {
+    QLineSeries *s = new QLineSeries(this->m_chartView->chart());
+    QColor seriesColor;
+    seriesColor.setNamedColor(m_checkedSeries[i][2]->text());
+    s->setName(tr("%1 (%2 stations)")
+                   .arg(m_checkedSeries[i][1]->text())
+                   .arg(this->m_selectedStations.length()));
+    s->setPen(QPen(seriesColor, 3,
+                   setPenStyle(m_checkedSeries[i][14]->text().toInt()),
+                   Qt::RoundCap, Qt::RoundJoin));
+    this->m_chartView->addLegendSeries(s);
+  }
+  return;
+}
+
 void UserTimeseries::plot() {
   int ierr, colorCounter;
   QVector<QLineSeries *> series;
@@ -313,6 +454,12 @@ void UserTimeseries::plot() {
   int seriesCounter = 0;
   int plottedSeriesCounter = 0;
 
+  //...QtCharts slows to a crawl with hundreds of line series, so past a
+  //   limit every series is drawn into a single image instead
+  this->m_rasterPlot = this->m_selectedStations.length() *
+                           this->m_fileDataUnique.length() >
+                       this->m_maxChartSeries;
+
   for (int i = 0; i < this->m_fileDataUnique.length(); i++) {
     if (this->m_selectedStations.length() == 1) {
       this->addSingleStationToPlot(
@@ -325,6 +472,8 @@ void UserTimeseries::plot() {
     }
   }
 
+  if (this->m_rasterPlot) this->addRasterLegend();
+
   QDateTime minDate = QDateTime::fromMSecsSinceEpoch(xmin);
   QDateTime maxDate = QDateTime::fromMSecsSinceEpoch(xmax);
 
@@ -363,91 +512,114 @@ void UserTimeseries::plot() {
 
 QString UserTimeseries::getErrorString() { return this->m_errorString; }
 
-int UserTimeseries::processImedsData(int tableIndex, Hmdf *data) {
-  QString tempFile = this->m_table->item(tableIndex, 6)->text();
-
-  int ierr = data->readImeds(tempFile);
+int UserTimeseries::processImedsData(const LoadJob &job, LoadResult &result) {
+  int ierr = result.data->readImeds(job.filename);
 
   if (ierr != MetOceanViewer::Error::NOERR) {
-    this->m_errorString = tr("Error reading file: ") + tempFile;
+    result.errorString = tr("Error reading file: ") + job.filename;
     return MetOceanViewer::Error::IMEDS_FILEREADERROR;
   }
 
-  data->setSuccess(true);
+  result.data->setSuccess(true);
 
   return MetOceanViewer::Error::NOERR;
 }
 
-int UserTimeseries::processAdcircNetcdfData(int tableIndex, Hmdf *data) {
-  QString tempFile = this->m_table->item(tableIndex, 6)->text();
-  QDateTime coldStart = QDateTime::fromString(
-      this->m_table->item(tableIndex, 7)->text(), "yyyy-MM-dd hh:mm:ss");
-  AdcircStationOutput *adcircData = new AdcircStationOutput(this);
-  int ierr = adcircData->read(tempFile, coldStart);
+//...Only the times and station locations are read here. The stations
+//   share the reader, which reads each one's series the first time it is
+//   plotted
+int UserTimeseries::processAdcircNetcdfData(const LoadJob &job,
+                                            LoadResult &result) {
+  QSharedPointer<AdcircStationOutput> adcircData(new AdcircStationOutput());
+  int ierr = adcircData->read(job.filename, job.coldStart);
   if (ierr != MetOceanViewer::Error::NOERR) {
-    this->m_errorString = tr("Error reading file: ") + tempFile;
+    result.errorString = tr("Error reading file: ") + job.filename;
     return MetOceanViewer::Error::ADCIRC_NETCDFREADERROR;
   }
 
-  ierr = adcircData->toHmdf(data);
-  if (ierr != MetOceanViewer::Error::NOERR) {
-    delete adcircData;
-    return ierr;
-  }
-  delete adcircData;
+  ierr = adcircData->toHmdf(result.data.data());
+  if (ierr != MetOceanViewer::Error::NOERR) return ierr;
 
-  if (!data->success()) return MetOceanViewer::Error::ADCIRC_NETCDFTOIMEDS;
+  if (!result.data->success())
+    return MetOceanViewer::Error::ADCIRC_NETCDFTOIMEDS;
   return MetOceanViewer::Error::NOERR;
 }
 
-int UserTimeseries::processAdcircAsciiData(int tableIndex, Hmdf *data) {
-  QString tempFile = this->m_table->item(tableIndex, 6)->text();
-  QDateTime coldStart = QDateTime::fromString(
-      this->m_table->item(tableIndex, 7)->text(), "yyyy-MM-dd hh:mm:ss");
-  QString tempStationFile = this->m_table->item(tableIndex, 10)->text();
-  AdcircStationOutput *adcircData = new AdcircStationOutput(this);
+int UserTimeseries::processAdcircAsciiData(const LoadJob &job,
+                                           LoadResult &result) {
+  AdcircStationOutput *adcircData = new AdcircStationOutput();
 
-  int ierr = adcircData->read(tempFile, tempStationFile, coldStart);
+  int ierr = adcircData->read(job.filename, job.stationFile, job.coldStart);
 
   if (ierr != MetOceanViewer::Error::NOERR) {
-    this->m_errorString = tr("Error reading file: ") + tempFile;
+    delete adcircData;
+    result.errorString = tr("Error reading file: ") + job.filename;
     return MetOceanViewer::Error::ADCIRC_ASCIIREADERROR;
   }
 
-  ierr = adcircData->toHmdf(data);
+  ierr = adcircData->toHmdf(result.data.data());
   delete adcircData;
   if (ierr != MetOceanViewer::Error::NOERR) {
     return ierr;
   }
 
-  if (!data->success()) return MetOceanViewer::Error::ADCIRC_ASCIITOIMEDS;
+  if (!result.data->success())
+    return MetOceanViewer::Error::ADCIRC_ASCIITOIMEDS;
   return MetOceanViewer::Error::NOERR;
 }
 
-int UserTimeseries::processDflowData(int tableIndex, Hmdf *data) {
-  QString tempFile = this->m_table->item(tableIndex, 6)->text();
+int UserTimeseries::processDflowData(const LoadJob &job, LoadResult &result) {
+  //...Rows that share a history file share its open handle and the
+  //   variables already read from it, kept across reprocessing
+  QSharedPointer<Dflow> dflow = this->m_dflowFiles.value(job.filename);
 
-  Dflow *dflow = new Dflow(tempFile, this);
-  QString dflowVar = this->m_table->item(tableIndex, 12)->text();
-  int dflowLayer = this->m_table->item(tableIndex, 13)->text().toInt();
-  int ierr = dflow->getVariable(dflowVar, dflowLayer, data);
+  if (job.dflowLayer == 0 && dflow->is3d())
+    return this->processDflowProfile(dflow, job, result);
+
+  int ierr = dflow->getVariable(job.dflowVariable, job.dflowLayer,
+                               result.data.data());
 
   if (ierr != MetOceanViewer::Error::NOERR) {
-    this->m_errorString =
+    result.errorString =
         tr("Error processing DFlow: ") + dflow->error->toString();
-    delete dflow;
     return MetOceanViewer::Error::DFLOW_FILEREADERROR;
   }
-  delete dflow;
   return MetOceanViewer::Error::NOERR;
 }
 
-int UserTimeseries::processGenericNetcdfData(int tableIndex, Hmdf *data) {
-  QString tempFile = this->m_table->item(tableIndex, 6)->text();
+//...Only the first station is read here. The row itself carries the top
+//   layer so that station matching works as usual, and each layer is kept
+//   for plotting. Every layer's stations are served by the profile cache,
+//   which reads all layers of a station together the first time a marker
+//   needs it, and is kept with the layers for saving
+int UserTimeseries::processDflowProfile(const QSharedPointer<Dflow> &dflow,
+                                        const LoadJob &job,
+                                        LoadResult &result) {
+  QSharedPointer<DflowProfileCache> profile(
+      new DflowProfileCache(dflow, job.dflowVariable));
+  int ierr = profile->init();
+  if (ierr != MetOceanViewer::Error::NOERR) {
+    result.errorString =
+        tr("Error processing DFlow: ") + dflow->error->toString();
+    return MetOceanViewer::Error::DFLOW_FILEREADERROR;
+  }
 
-  int ierr = data->readNetcdf(tempFile);
+  for (size_t l = 0; l < profile->nLayers(); ++l) {
+    QSharedPointer<Hmdf> layer(new Hmdf());
+    profile->toHmdf(l, layer.data());
+    result.layers.push_back(layer);
+  }
+  profile->toHmdf(profile->nLayers() - 1, result.data.data());
+  result.profile = profile;
+
+  return MetOceanViewer::Error::NOERR;
+}
+
+int UserTimeseries::processGenericNetcdfData(const LoadJob &job,
+                                             LoadResult &result) {
+  int ierr = result.data->readNetcdfLazy(job.filename);
   if (ierr != 0) {
-    this->m_errorString = "Error processing generic netcdf file.";
+    result.errorString = "Error processing generic netcdf file.";
     return MetOceanViewer::Error::GENERICNETCDFERROR;
   }
   return MetOceanViewer::Error::NOERR;
@@ -460,55 +632,151 @@ QVector<QTableWidgetItem *> grabTableRow(QTableWidget *table, int row) {
   return rowItems;
 }
 
-int UserTimeseries::processDataFiles() {
-  int ierr;
+//...Runs on a worker thread. Only the job is read from, and the results
+//   are handed back to the GUI thread before returning. netCDF files are
+//   read one at a time under the library's lock while text formats load
+//   alongside them
+UserTimeseries::LoadResult UserTimeseries::loadFile(const LoadJob &job) {
+  LoadResult result;
+  result.series = job.series;
+  result.data.reset(new Hmdf());
+
+  switch (job.fileType) {
+    case MetOceanViewer::FileType::ASCII_IMEDS:
+      result.ierr = this->processImedsData(job, result);
+      break;
+    case MetOceanViewer::FileType::ASCII_ADCIRC:
+      result.ierr = this->processAdcircAsciiData(job, result);
+      break;
+    case MetOceanViewer::FileType::NETCDF_ADCIRC: {
+      QMutexLocker lock(NetcdfTimeseries::mutex());
+      result.ierr = this->processAdcircNetcdfData(job, result);
+      break;
+    }
+    case MetOceanViewer::FileType::NETCDF_DFLOW: {
+      QMutexLocker lock(NetcdfTimeseries::mutex());
+      result.ierr = this->processDflowData(job, result);
+      break;
+    }
+    case MetOceanViewer::FileType::NETCDF_GENERIC: {
+      QMutexLocker lock(NetcdfTimeseries::mutex());
+      result.ierr = this->processGenericNetcdfData(job, result);
+      break;
+    }
+  }
+
+  //...Regularly sampled series don't need a stored time for each value
+  if (result.ierr == MetOceanViewer::Error::NOERR && result.data->success())
+    result.data->compact();
+
+  result.data->moveToThread(this->thread());
+  for (int i = 0; i < result.layers.size(); ++i)
+    result.layers[i]->moveToThread(this->thread());
+
+  return result;
+}
+
+//...Copies what the loaders need out of the table, since the widgets may
+//   only be touched from the GUI thread
+int UserTimeseries::buildLoadJobs() {
+  this->m_loadJobs.clear();
+
+  //...Files no longer in the table don't need to stay open
+  QStringList tableFiles;
+  for (int i = 0; i < this->m_table->rowCount(); i++)
+    tableFiles.push_back(this->m_table->item(i, 6)->text());
+  Dflow::retain(tableFiles);
 
   for (int i = 0; i < this->m_table->rowCount(); i++) {
     if (this->m_table->item(i, 0)->checkState() == Qt::Unchecked) continue;
 
     this->m_checkedSeries.push_back(grabTableRow(this->m_table, i));
-
-    int inputFileType =
-        Filetypes::getIntegerFiletype(this->m_table->item(i, 6)->text());
     this->m_epsg.push_back(this->m_table->item(i, 11)->text().toInt());
 
-    Hmdf *stationData = new Hmdf(this);
-
-    switch (inputFileType) {
+    LoadJob job;
+    job.series = this->m_checkedSeries.size() - 1;
+    job.filename = this->m_table->item(i, 6)->text();
+    job.fileType = Filetypes::getIntegerFiletype(job.filename);
+    job.coldStart = QDateTime::fromString(this->m_table->item(i, 7)->text(),
+                                          "yyyy-MM-dd hh:mm:ss");
+    job.stationFile = this->m_table->item(i, 10)->text();
+    job.dflowVariable = this->m_table->item(i, 12)->text();
+    job.dflowLayer = this->m_table->item(i, 13)->text().toInt();
+
+    switch (job.fileType) {
       case MetOceanViewer::FileType::ASCII_IMEDS:
-        ierr = this->processImedsData(i, stationData);
-        this->m_allFileData.push_back(stationData);
-        break;
-      case MetOceanViewer::FileType::NETCDF_ADCIRC:
-        ierr = this->processAdcircNetcdfData(i, stationData);
-        this->m_allFileData.push_back(stationData);
-        break;
       case MetOceanViewer::FileType::ASCII_ADCIRC:
-        ierr = this->processAdcircAsciiData(i, stationData);
-        this->m_allFileData.push_back(stationData);
+      case MetOceanViewer::FileType::NETCDF_ADCIRC:
+      case MetOceanViewer::FileType::NETCDF_GENERIC:
         break;
       case MetOceanViewer::FileType::NETCDF_DFLOW:
-        ierr = this->processDflowData(i, stationData);
-        this->m_allFileData.push_back(stationData);
-        break;
-      case MetOceanViewer::FileType::NETCDF_GENERIC:
-        ierr = this->processGenericNetcdfData(i, stationData);
-        this->m_allFileData.push_back(stationData);
+        if (!this->m_dflowFiles.contains(job.filename))
+          this->m_dflowFiles[job.filename] = Dflow::open(job.filename);
         break;
       default:
         this->m_errorString = QStringLiteral("Invalid file format");
         return MetOceanViewer::Error::INVALIDFILEFORMAT;
     }
 
-    if (!this->m_allFileData.last()->success() ||
-        ierr != MetOceanViewer::Error::NOERR) {
-      this->m_allFileData.pop_back();
-      return MetOceanViewer::Error::GENERICFILEREADERROR;
-    }
+    this->m_loadJobs.push_back(job);
   }
   return MetOceanViewer::Error::NOERR;
 }
 
+//...Back on the GUI thread once every file has been read (or the load was
+//   cancelled). Results are merged in table order
+void UserTimeseries::filesLoaded() {
+  QFuture<LoadResult> future = this->m_loadWatcher.future();
+  QList<LoadResult> results = future.results();
+
+  if (future.isCanceled()) {
+    this->m_statusBar->showMessage(tr("Loading canceled"), 4000);
+    this->m_errorString = tr("Loading canceled");
+    emit processingFinished(MetOceanViewer::Error::LOADCANCELED);
+    return;
+  }
+
+  std::sort(results.begin(), results.end(),
+            [](const LoadResult &a, const LoadResult &b) {
+              return a.series < b.series;
+            });
+
+  for (int i = 0; i < results.size(); ++i) {
+    if (results[i].ierr != MetOceanViewer::Error::NOERR ||
+        !results[i].data->success()) {
+      if (!results[i].errorString.isEmpty())
+        this->m_errorString = results[i].errorString;
+      this->m_statusBar->clearMessage();
+      emit processingFinished(MetOceanViewer::Error::GENERICFILEREADERROR);
+      return;
+    }
+  }
+
+  for (int i = 0; i < results.size(); ++i) {
+    this->m_loadedData.push_back(results[i].data);
+    this->m_allFileData.push_back(results[i].data.data());
+    if (!results[i].layers.isEmpty()) {
+      this->m_profileLayers[results[i].series] = results[i].layers;
+      this->m_profiles[results[i].series] = results[i].profile;
+    }
+  }
+
+  this->m_statusBar->clearMessage();
+  emit processingFinished(this->processLoadedData());
+}
+
+void UserTimeseries::loadProgress(int value) {
+  this->m_statusBar->showMessage(tr("Loaded %1 of %2 files")
+                                     .arg(value)
+                                     .arg(this->m_loadJobs.size()));
+}
+
+bool UserTimeseries::isProcessing() const {
+  return this->m_loadWatcher.isRunning();
+}
+
+void UserTimeseries::cancelProcessing() { this->m_loadWatcher.cancel(); }
+
 int UserTimeseries::processStationLocations() {
   //...Build a unique set of timeseries data
   if (this->m_allFileData.length() == 1) {
@@ -569,15 +837,26 @@ int UserTimeseries::addMarkersToMap() {
   return MetOceanViewer::Error::NOERR;
 }
 
+//...Starts reading the checked files on the worker pool. Returns an error
+//   right away if the table can't be processed, otherwise the result is
+//   reported through processingFinished()
 int UserTimeseries::processData() {
-  //...Process the data files
-  int ierr = this->processDataFiles();
+  int ierr = this->buildLoadJobs();
   if (ierr != MetOceanViewer::Error::NOERR) {
     return ierr;
   }
 
+  this->m_statusBar->showMessage(
+      tr("Loaded 0 of %1 files").arg(this->m_loadJobs.size()));
+  this->m_loadWatcher.setFuture(
+      QtConcurrent::mapped(this->m_loadJobs, FileLoader(this)));
+
+  return MetOceanViewer::Error::NOERR;
+}
+
+int UserTimeseries::processLoadedData() {
   //...Project the data to WGS84
-  ierr = this->projectStations(this->m_epsg, this->m_allFileData);
+  int ierr = this->projectStations(this->m_epsg, this->m_allFileData);
   if (ierr != 0) {
     this->m_errorString = tr("Error projecting the station locations");
     return MetOceanViewer::Error::PROJECTSTATIONS;
@@ -598,6 +877,58 @@ int UserTimeseries::processData() {
   return MetOceanViewer::Error::NOERR;
 }
 
+namespace {
+//...Uniform grid over station locations. Cells are as wide as the
+//   duplicate tolerance, so a match can only sit in the 3x3 block of
+//   cells around a point
+class StationGrid {
+ public:
+  explicit StationGrid(double tolerance) : m_tolerance(tolerance) {}
+
+  void insert(double x, double y, int index) {
+    if (!std::isfinite(x) || !std::isfinite(y)) return;
+    this->m_cells[qMakePair(this->cell(x), this->cell(y))].push_back(
+        Entry{x, y, index});
+  }
+
+  //...Lowest index within the tolerance of (x,y), or -1
+  int find(double x, double y) const {
+    if (!std::isfinite(x) || !std::isfinite(y)) return -1;
+    const qint64 cx = this->cell(x);
+    const qint64 cy = this->cell(y);
+    const double tol2 = this->m_tolerance * this->m_tolerance;
+    int found = -1;
+    for (qint64 i = cx - 1; i <= cx + 1; ++i) {
+      for (qint64 j = cy - 1; j <= cy + 1; ++j) {
+        auto c = this->m_cells.constFind(qMakePair(i, j));
+        if (c == this->m_cells.constEnd()) continue;
+        for (const Entry &e : c.value()) {
+          const double dx = e.x - x;
+          const double dy = e.y - y;
+          if (dx * dx + dy * dy < tol2 && (found == -1 || e.index < found))
+            found = e.index;
+        }
+      }
+    }
+    return found;
+  }
+
+ private:
+  struct Entry {
+    double x;
+    double y;
+    int index;
+  };
+
+  qint64 cell(double v) const {
+    return static_cast<qint64>(std::floor(v / this->m_tolerance));
+  }
+
+  double m_tolerance;
+  QHash<QPair<qint64, qint64>, QVector<Entry>> m_cells;
+};
+}  // namespace
+
 //-------------------------------------------//
 // Generate a unique list of stations so that
 // we can later build a complete list of stations
@@ -607,21 +938,17 @@ int UserTimeseries::processData() {
 int UserTimeseries::getUniqueStationList(QVector<Hmdf *> &Data,
                                          QVector<double> &X,
                                          QVector<double> &Y) {
+  StationGrid grid(this->m_duplicateStationTolerance);
+  for (int k = 0; k < X.length(); k++) grid.insert(X[k], Y[k], k);
+
   for (int i = 0; i < Data.length(); i++) {
     for (int j = 0; j < Data[i]->nstations(); j++) {
-      bool found = false;
-      for (int k = 0; k < X.length(); k++) {
-        double dx = Data[i]->station(j)->longitude() - X[k];
-        double dy = Data[i]->station(j)->latitude() - Y[k];
-        double d = std::sqrt(std::pow(dx, 2.0) + std::pow(dy, 2.0));
-        if (d < this->m_duplicateStationTolerance) {
-          found = true;
-          break;
-        }
-      }
-      if (!found) {
-        X.push_back(Data[i]->station(j)->longitude());
-        Y.push_back(Data[i]->station(j)->latitude());
+      double x = Data[i]->station(j)->longitude();
+      double y = Data[i]->station(j)->latitude();
+      if (grid.find(x, y) == -1) {
+        grid.insert(x, y, X.length());
+        X.push_back(x);
+        Y.push_back(y);
       }
     }
   }
@@ -649,21 +976,18 @@ int UserTimeseries::buildRevisedIMEDS(QVector<Hmdf *> Data,
   }
 
   for (int i = 0; i < Data.length(); i++) {
+    StationGrid grid(this->m_duplicateStationTolerance);
+    for (int k = 0; k < Data[i]->nstations(); k++)
+      grid.insert(Data[i]->station(k)->longitude(),
+                  Data[i]->station(k)->latitude(), k);
+
     for (int j = 0; j < X.length(); j++) {
-      bool found = false;
-      for (int k = 0; k < Data[i]->nstations(); k++) {
-        double dx = Data[i]->station(k)->longitude() - X[j];
-        double dy = Data[i]->station(k)->latitude() - Y[j];
-        double d = std::sqrt(std::pow(dx, 2.0) + std::pow(dy, 2.0));
-        if (d < this->m_duplicateStationTolerance) {
-          HmdfStation *p = Data[i]->station(k);
-          p->setIsNull(false);
-          DataOut[i]->addStation(p);
-          found = true;
-          break;
-        }
-      }
-      if (!found) {
+      int k = grid.find(X[j], Y[j]);
+      if (k != -1) {
+        HmdfStation *p = Data[i]->station(k);
+        p->setIsNull(false);
+        DataOut[i]->addStation(p);
+      } else {
         // Build a station with a null dataset we can find later
         DataOut[i]->addStation(new HmdfStation(DataOut[i]));
         DataOut[i]->station(j)->setLongitude(X[j]);
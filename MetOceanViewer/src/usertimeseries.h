@@ -22,20 +22,27 @@
 
 #include <QChartView>
 #include <QDateTime>
+#include <QFutureWatcher>
 #include <QObject>
 #include <QPrinter>
 #include <QQuickItem>
 #include <QQuickView>
 #include <QQuickWidget>
+#include <QSharedPointer>
 #include <QTableWidget>
 #include <QVector>
 #include <QtCharts>
 #include <memory>
 #include "chartview.h"
+#include "dflowprofilecache.h"
 #include "generic.h"
 #include "hmdf.h"
+#include "hmdfstationview.h"
+#include "metoceanviewer.h"
 #include "stationmodel.h"
 
+class Dflow;
+
 class UserTimeseries : public QObject {
   Q_OBJECT
 
@@ -53,17 +60,57 @@ class UserTimeseries : public QObject {
 
   //...Public functions
   int processData();
+  bool isProcessing() const;
+  void cancelProcessing();
   int plotData();
   int getCurrentMarkerID();
   int getClickedMarkerID();
   int saveImage(QString filename, QString filter);
+  int saveProfile(QString filename);
   QString getErrorString();
   void plot();
 
  signals:
   void timeseriesError(QString);
+  void processingFinished(int);
+
+ private slots:
+  void filesLoaded();
+  void loadProgress(int value);
 
  private:
+  //...One checked table row, read on a worker thread
+  struct LoadJob {
+    int series;
+    int fileType;
+    int dflowLayer;
+    QString filename;
+    QString stationFile;
+    QString dflowVariable;
+    QDateTime coldStart;
+  };
+
+  //...Results own what they read, so any the future drops after a
+  //   cancel are freed with it
+  struct LoadResult {
+    LoadResult() : series(-1), ierr(MetOceanViewer::Error::NOERR) {}
+    int series;
+    int ierr;
+    QString errorString;
+    QSharedPointer<Hmdf> data;
+    QVector<QSharedPointer<Hmdf>> layers;
+    QSharedPointer<DflowProfileCache> profile;
+  };
+
+  struct FileLoader {
+    typedef LoadResult result_type;
+    explicit FileLoader(UserTimeseries *parent) : parent(parent) {}
+    LoadResult operator()(const LoadJob &job) const {
+      return parent->loadFile(job);
+    }
+    UserTimeseries *parent;
+  };
+
   //...Private functions
   int getStationSelections();
   int setMarkerID();
@@ -78,14 +125,30 @@ class UserTimeseries : public QObject {
   int projectStations(QVector<int> epsg, QVector<Hmdf *> &projectedStations);
 
   Qt::PenStyle setPenStyle(const int penIndex);
-  int processDataFiles();
-  int processImedsData(int tableIndex, Hmdf *data);
-  int processAdcircAsciiData(int tableIndex, Hmdf *data);
-  int processAdcircNetcdfData(int tableIndex, Hmdf *data);
-  int processDflowData(int tableIndex, Hmdf *data);
-  int processGenericNetcdfData(int tableIndex, Hmdf *data);
+  int buildLoadJobs();
+  LoadResult loadFile(const LoadJob &job);
+  int processLoadedData();
+  int processImedsData(const LoadJob &job, LoadResult &result);
+  int processAdcircAsciiData(const LoadJob &job, LoadResult &result);
+  int processAdcircNetcdfData(const LoadJob &job, LoadResult &result);
+  int processDflowData(const LoadJob &job, LoadResult &result);
+  int processDflowProfile(const QSharedPointer<Dflow> &dflow,
+                          const LoadJob &job, LoadResult &result);
+  int processGenericNetcdfData(const LoadJob &job, LoadResult &result);
   int processStationLocations();
   int addMarkersToMap();
+  HmdfTransform seriesTransform(int index);
+  int appendStationToSeries(HmdfStation *station, int index,
+                            QVector<QPointF> &points, qint64 startDate,
+                            qint64 endDate, qint64 offset, qint64 &minDate,
+                            qint64 &maxDate, double &minVal, double &maxVal);
+  bool addPointsToPlot(const QVector<QPointF> &points, const QString &name,
+                       const QPen &pen, QVector<QLineSeries *> &series);
+  int addProfileToPlot(int index, int stationIndex, const QString &name,
+                       const QColor &color, Qt::PenStyle lineStyle,
+                       QVector<QLineSeries *> &series, qint64 startDate,
+                       qint64 endDate, qint64 offset, qint64 &minDate,
+                       qint64 &maxDate, double &minVal, double &maxVal);
   void addSingleStationToPlot(Hmdf *h, int &plottedSeriesCounter,
                               int &seriesCounter,
                               QVector<QLineSeries *> &series, qint64 startDate,
@@ -95,17 +158,26 @@ class UserTimeseries : public QObject {
       Hmdf *h, int index, QVector<QLineSeries *> &series, int &seriesCounter,
       int &colorCounter, qint64 offset, qint64 startDate, qint64 endDate,
       qint64 &minDate, qint64 &maxDate, double &minVal, double &maxVal);
+  void addRasterLegend();
 
   //...Private Variables
   int m_markerId;
   QString m_errorString;
   QVector<Hmdf *> m_allFileData, m_fileDataUnique;
+  QVector<QSharedPointer<Hmdf>> m_loadedData;
+  QMap<QString, QSharedPointer<Dflow>> m_dflowFiles;
+  QMap<int, QVector<QSharedPointer<Hmdf>>> m_profileLayers;
+  QMap<int, QSharedPointer<DflowProfileCache>> m_profiles;
+  QVector<LoadJob> m_loadJobs;
+  QFutureWatcher<LoadResult> m_loadWatcher;
   QVector<double> m_xLocations;
   QVector<double> m_yLocations;
   QVector<int> m_selectedStations;
   QVector<QColor> m_randomColorList;
   QVector<int> m_epsg;
   const double m_duplicateStationTolerance = 0.00001;
+  const int m_maxChartSeries = 100;
+  bool m_rasterPlot;
 
   //...Widgets
   QTableWidget *m_table;
@@ -288,21 +288,7 @@ int Usgs::replotChart(Timezone *newTimezone) {
   int offset = newTimezone->utcOffset() * 1000;
   int totalOffset = -this->m_priorOffsetSeconds + offset;
 
-  QVector<QLineSeries *> series;
-  series.resize(this->m_chartView->chart()->series().length());
-
-  for (int i = 0; i < this->m_chartView->chart()->series().length(); i++) {
-    series[i] =
-        static_cast<QLineSeries *>(this->m_chartView->chart()->series().at(i));
-  }
-  for (int i = 0; i < series.length(); i++) {
-    QList<QPointF> data = series[i]->points();
-    series[i]->clear();
-    for (int j = 0; j < data.length(); j++) {
-      data[j].setX(data[j].x() + totalOffset);
-    }
-    series[i]->append(data);
-  }
+  this->m_chartView->shiftSeries(totalOffset);
 
   QDateTime minDateTime = QDateTime::fromMSecsSinceEpoch(
       this->m_allStationData->station(0)->date(0), Qt::UTC);
@@ -19,6 +19,7 @@
 //-----------------------------------------------------------------------*/
 #include "xtide.h"
 #include <float.h>
+#include "hmdfstationview.h"
 #include "xtidedata.h"
 
 //...Constructor
@@ -128,11 +129,13 @@ int XTide::plotChart() {
   else
     multiplier = 3.28084;
 
+  //...The unit conversion is kept with the data so that saved files
+  //   match the plot, and the units written with them follow it
+  this->m_data->setTransform(HmdfTransform(multiplier, 0.0));
+  this->m_data->setUnits(this->m_comboUnits->currentIndex() == 0 ? "m"
+                                                                  : "ft");
   this->m_data->dataBounds(minDate, maxDate, ymin, ymax);
 
-  ymin = ymin * multiplier;
-  ymax = ymax * multiplier;
-
   QString datum = this->m_data->datum();
 
   if (this->m_comboUnits->currentIndex() == 1)
@@ -155,9 +158,9 @@ int XTide::plotChart() {
   this->m_chartView->dateAxis()->setTitleText("Date (GMT)");
   this->m_chartView->yAxis()->setTitleText(this->m_ylabel);
 
-  for (int i = 0; i < this->m_data->station(0)->numSnaps(); i++) {
-    series1->append(this->m_data->station(0)->date(i),
-                    this->m_data->station(0)->data(i) * multiplier);
+  HmdfStationView view(this->m_data->station(0), this->m_data->transform());
+  for (size_t i = 0; i < view.numSnaps(); i++) {
+    series1->append(view.date(i), view.data(i));
   }
 
   this->m_chartView->addSeries(series1, series1->name());
@@ -24,6 +24,7 @@
 #include <QString>
 #include <QStringList>
 #include "netcdf.h"
+#include "stationcatalog.h"
 
 CrmsData::CrmsData(Station &station, QDateTime startDate, QDateTime endDate,
                    const QVector<QString> &header,
@@ -164,23 +165,12 @@ bool CrmsData::readStationList(const QString &filename,
                                QVector<QString> &stationNames,
                                QVector<QDateTime> &startDate,
                                QVector<QDateTime> &endDate) {
-  QFile crmsCsv(":/stations/data/crms_stations.csv");
-  if (!crmsCsv.open(QIODevice::ReadOnly)) {
+  StationCatalog::View crmsStations =
+      StationCatalog::instance().view(StationCatalog::CRMS);
+  if (crmsStations.isEmpty()) {
     return false;
   }
 
-  QMap<QString, QGeoCoordinate> nameMap;
-
-  while (!crmsCsv.atEnd()) {
-    QString s = crmsCsv.readLine().simplified();
-    QStringList sl = s.split(",");
-    double lon = sl[0].toDouble();
-    double lat = sl[1].toDouble();
-    QGeoCoordinate c(lat, lon);
-    nameMap[sl[2]] = c;
-  }
-  crmsCsv.close();
-
   int ncid, dimid_nstation, dimid_stringsize;
   size_t nstations, stringsize;
   int ierr = nc_open(filename.toStdString().c_str(), NC_NOWRITE, &ncid);
@@ -212,12 +202,11 @@ bool CrmsData::readStationList(const QString &filename,
     QString name(nm);
     delete[] nm;
 
-    QGeoCoordinate p;
-    if (nameMap.contains(name)) {
-      p = nameMap[name];
-    } else {
+    int index = crmsStations.indexOf(name);
+    if (index < 0) {
       continue;
     }
+    QGeoCoordinate p = crmsStations.coordinate(index);
 
     char *tms = new char[stringsize];
     char *tme = new char[stringsize];
@@ -21,7 +21,11 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QHostInfo>
-#include <fstream>
+#include <QThread>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstring>
+#include "hmdfasciiformatter.h"
 #include "hmdfasciiparser.h"
 #include "netcdf.h"
 #include "netcdftimeseries.h"
@@ -43,6 +47,8 @@ void Hmdf::init() {
   this->setSuccess(false);
   this->setUnits("");
   this->setNull(true);
+  this->setNetcdfLayout(HmdfNetcdfLegacy);
+  this->setTransform(HmdfTransform());
   return;
 }
 
@@ -50,6 +56,7 @@ void Hmdf::clear() {
   for (int i = 0; i < this->m_station.size(); i++) {
     this->m_station[i]->clear();
   }
+  this->m_arena.clear();
   this->init();
   return;
 }
@@ -93,6 +100,14 @@ void Hmdf::addStation(HmdfStation *station) {
   this->m_station.push_back(station);
 }
 
+Hmdf::HmdfNetcdfLayout Hmdf::netcdfLayout() const {
+  return this->m_netcdfLayout;
+}
+
+void Hmdf::setNetcdfLayout(const HmdfNetcdfLayout &netcdfLayout) {
+  this->m_netcdfLayout = netcdfLayout;
+}
+
 bool Hmdf::success() const { return this->m_success; }
 
 void Hmdf::setSuccess(bool success) { this->m_success = success; }
@@ -102,63 +117,97 @@ bool Hmdf::null() const { return this->m_null; }
 void Hmdf::setNull(bool null) { this->m_null = null; }
 
 int Hmdf::readImeds(QString filename) {
-  std::fstream fid(filename.toStdString().c_str());
-  if (fid.bad()) return -1;
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly)) return -1;
+
+  //...Map the file into memory. If the platform refuses (i.e. empty
+  //   file), fall back to a single bulk read
+  QByteArray buffer;
+  const char *begin = nullptr;
+  qint64 size = file.size();
+  uchar *map = size > 0 ? file.map(0, size) : nullptr;
+  if (map != nullptr) {
+    begin = reinterpret_cast<const char *>(map);
+  } else {
+    buffer = file.readAll();
+    begin = buffer.constData();
+    size = buffer.size();
+  }
+  const char *end = begin + size;
 
   //...Read Header
-  std::string templine;
-  std::getline(fid, templine);
-  this->m_header1 =
-      QString::fromStdString(StringUtil::sanitizeString(templine));
-  std::getline(fid, templine);
-  this->m_header2 =
-      QString::fromStdString(StringUtil::sanitizeString(templine));
-  std::getline(fid, templine);
-  this->m_header3 =
-      QString::fromStdString(StringUtil::sanitizeString(templine));
+  const char *pos = begin;
+  QString *header[3] = {&this->m_header1, &this->m_header2, &this->m_header3};
+  for (int i = 0; i < 3; ++i) {
+    const char *eol = HmdfAsciiParser::lineEnd(pos, end);
+    std::string templine(pos, eol);
+    *(header[i]) = QString::fromStdString(StringUtil::sanitizeString(templine));
+    pos = eol < end ? eol + 1 : end;
+  }
 
-  //...Read Body
-  std::getline(fid, templine);
+  //...Locate each station block so that the buffers can be sized up front
+  //   and the blocks parsed independently. Classifying the lines means
+  //   scanning every token, so the file is indexed in chunks on the
+  //   thread pool and the chunks are stitched together in order
+  std::vector<HmdfAsciiParser::ImedsChunkIndex> chunks;
+  HmdfAsciiParser::splitImedsChunks(
+      pos, end, static_cast<size_t>(4 * QThread::idealThreadCount()), chunks);
+  if (chunks.size() > 1) {
+    QtConcurrent::blockingMap(chunks, HmdfAsciiParser::indexImedsChunk);
+  } else {
+    for (auto &c : chunks) HmdfAsciiParser::indexImedsChunk(c);
+  }
+  std::vector<HmdfAsciiParser::ImedsStationBlock> blocks;
+  HmdfAsciiParser::mergeImedsChunks(chunks, blocks);
+
+  //...All stations of the file share one arena, each a column of it
+  QVector<size_t> lengths;
+  lengths.reserve(static_cast<int>(blocks.size()));
+  for (const auto &b : blocks) lengths.push_back(b.numSnaps);
+  QSharedPointer<HmdfArena> arena(new HmdfArena(lengths));
+
+  std::vector<int> columns(blocks.size());
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    columns[i] = static_cast<int>(i);
+  }
 
-  while (!fid.eof()) {
-    HmdfStation *station = new HmdfStation(this);
+  //...Columns are disjoint, so they can be written concurrently. Only the
+  //   column's own entry in the table is touched when a block is short
+  auto parseBlock = [&](int column) {
+    const HmdfAsciiParser::ImedsStationBlock &block = blocks[column];
+    size_t nRead = HmdfAsciiParser::parseImedsStation(
+        block, arena->date(column), arena->data(column));
+    if (nRead != block.numSnaps) arena->setColumnLength(column, nRead);
+  };
+
+  //...Parse the station blocks on the thread pool. The stations are
+  //   QObjects owned by this object so they are created afterwards, on
+  //   this thread, in file order
+  if (columns.size() > 1) {
+    QtConcurrent::blockingMap(columns, parseBlock);
+  } else {
+    for (auto &c : columns) parseBlock(c);
+  }
 
-    templine = StringUtil::sanitizeString(templine);
+  //...Read Body
+  for (int i = 0; i < arena->numColumns(); ++i) {
+    HmdfStation *station = new HmdfStation(this);
 
+    std::string templine(blocks[i].headerBegin, blocks[i].headerEnd);
     QStringList templist =
-        QString::fromStdString(templine).split(" ", QString::SkipEmptyParts);
-
-    station->setName(templist.at(0));
-    station->setLongitude(templist.at(2).toDouble());
-    station->setLatitude(templist.at(1).toDouble());
-
-    while (!fid.eof()) {
-      std::getline(fid, templine);
-
-      int year, month, day, hour, minute, second;
-      double value;
+        QString::fromStdString(StringUtil::sanitizeString(templine))
+            .split(" ", QString::SkipEmptyParts);
 
-      bool status = HmdfAsciiParser::splitStringHmdfFormat(
-          templine, year, month, day, hour, minute, second, value);
-
-      if (status) {
-        QDateTime datetime;
-        datetime.setTimeSpec(Qt::UTC);
-        datetime.setDate(QDate(year, month, day));
-        datetime.setTime(QTime(hour, minute, second));
-        qint64 secs = datetime.toMSecsSinceEpoch();
-
-        //...Append to the station data
-        station->setNext(secs, value);
-      } else {
-        break;
-      }
-    }
+    station->setName(templist.value(0));
+    station->setLongitude(templist.value(2).toDouble());
+    station->setLatitude(templist.value(1).toDouble());
+    station->setArena(arena, i);
 
     //...Add the station
     this->addStation(station);
   }
 
+  this->setArena(arena);
   this->setNull(false);
 
   return 0;
@@ -182,36 +231,36 @@ int Hmdf::readNetcdf(QString filename) {
   return 0;
 }
 
+//...Reads only the station names and locations. Each station's series is
+//   read the first time it is used and held in a cache limited to
+//   cacheBytes, shared by all stations of this file
+int Hmdf::readNetcdfLazy(QString filename, size_t cacheBytes) {
+  QSharedPointer<NetcdfTimeseries> ncts(new NetcdfTimeseries());
+  ncts->setFilename(filename);
+  ncts->setMaxBytes(cacheBytes);
+  int ierr = ncts->readLazy();
+  if (ierr != 0) return 1;
+
+  ierr = ncts->toHmdf(this);
+  if (ierr != 0) return 1;
+
+  this->setNull(false);
+
+  return 0;
+}
+
 int Hmdf::writeCsv(QString filename) {
-  int i, s;
-  QString value;
   QFile output(filename);
 
   if (!output.open(QIODevice::WriteOnly)) return -1;
 
-  for (s = 0; s < this->nstations(); s++) {
-    output.write(
-        QString("Station: " + this->station(s)->name() + "\n").toUtf8());
-    output.write(QString("Datum: " + this->datum() + "\n").toUtf8());
-    output.write(QString("Units: " + this->units() + "\n").toUtf8());
-    output.write(QString("\n").toUtf8());
-    for (i = 0; i < this->station(s)->numSnaps(); i++) {
-      QDateTime d =
-          QDateTime::fromMSecsSinceEpoch(this->station(s)->date(i), Qt::UTC);
-      if (d.isValid()) {
-        value.sprintf("%10.4e", this->station(s)->data(i));
-        output.write(
-            QString(d.toString("MM/dd/yyyy,hh:mm,") + value + "\n").toUtf8());
-      }
-    }
-    output.write(QString("\n\n\n").toUtf8());
-  }
+  this->writeAsciiStations(output, HmdfCsv);
+
   output.close();
   return 0;
 }
 
 int Hmdf::writeImeds(QString filename) {
-  QString value;
   QFile outputFile(filename);
 
   if (!outputFile.open(QIODevice::WriteOnly)) return -1;
@@ -222,31 +271,120 @@ int Hmdf::writeImeds(QString filename) {
                            this->units() + "\n")
                        .toUtf8());
 
-  for (int s = 0; s < this->nstations(); s++) {
+  this->writeAsciiStations(outputFile, HmdfImeds);
+
+  outputFile.close();
+  return 0;
+}
+
+void Hmdf::formatAsciiStation(int index, HmdfFileType fileType,
+                              const QVector<qint64> &date,
+                              const QVector<double> &data,
+                              QByteArray &buffer) const {
+  HmdfStation *station = this->m_station[index];
+
+  if (fileType == HmdfCsv) {
+    buffer.append(QString("Station: " + station->name() + "\n").toUtf8());
+    buffer.append(QString("Datum: " + this->datum() + "\n").toUtf8());
+    buffer.append(QString("Units: " + this->units() + "\n").toUtf8());
+    buffer.append("\n");
+  } else {
     QString stationName =
-        this->station(s)->name().replace(" ", "_").replace(",", "_").replace(
-            "__", "_");
-    outputFile.write(
-        QString(stationName + "   " +
-                QString::number(this->station(s)->latitude()) + "   " +
-                QString::number(this->station(s)->longitude()) + "\n")
-            .toUtf8());
-
-    for (int i = 0; i < this->station(s)->numSnaps(); i++) {
-      QDateTime d =
-          QDateTime::fromMSecsSinceEpoch(this->station(s)->date(i), Qt::UTC);
-
-      if (d.isValid()) {
-        value.sprintf("%10.4e", this->station(s)->data(i));
-        outputFile.write(
-            QString(d.toString("yyyy    MM    dd    hh    mm    ss") + "    " +
-                    value + "\n")
-                .toUtf8());
+        station->name().replace(" ", "_").replace(",", "_").replace("__", "_");
+    buffer.append(QString(stationName + "   " +
+                          QString::number(station->latitude()) + "   " +
+                          QString::number(station->longitude()) + "\n")
+                      .toUtf8());
+  }
+
+  //...The longest record is a 38 character IMEDS date field and a 12
+  //   character value, so reserve for that up front
+  const int n = std::min(date.size(), data.size());
+  buffer.reserve(buffer.size() + n * 52 + 8);
+
+  char line[128];
+  for (int i = 0; i < n; ++i) {
+    int len = fileType == HmdfCsv
+                  ? HmdfAsciiFormatter::formatCsvDate(date[i], line)
+                  : HmdfAsciiFormatter::formatImedsDate(date[i], line);
+
+    if (len == 0) {
+      //...Outside of the four digit year range, let QDateTime decide
+      QDateTime d = QDateTime::fromMSecsSinceEpoch(date[i], Qt::UTC);
+      if (!d.isValid()) continue;
+      QString value;
+      value.sprintf("%10.4e", data[i]);
+      if (fileType == HmdfCsv) {
+        buffer.append(
+            QString(d.toString("MM/dd/yyyy,hh:mm,") + value + "\n").toUtf8());
+      } else {
+        buffer.append(QString(d.toString("yyyy    MM    dd    hh    mm    ss") +
+                              "    " + value + "\n")
+                          .toUtf8());
       }
+      continue;
+    }
+
+    if (fileType == HmdfImeds) {
+      std::memcpy(line + len, "    ", 4);
+      len += 4;
     }
+    len += HmdfAsciiFormatter::formatValue(data[i], line + len);
+    line[len++] = '\n';
+    buffer.append(line, len);
   }
-  outputFile.close();
-  return 0;
+
+  if (fileType == HmdfCsv) buffer.append("\n\n\n");
+  return;
+}
+
+void Hmdf::writeAsciiStations(QFile &output, HmdfFileType fileType) const {
+  //...Stations are formatted on the thread pool, each into its own
+  //   buffer, and written in order. The work is split into batches so
+  //   that only a bounded amount of formatted text is held at once
+  const size_t batchSnaps = 4000000;
+
+  struct StationBuffer {
+    int index;
+    QVector<qint64> date;
+    QVector<double> data;
+    QByteArray text;
+  };
+
+  auto format = [this, fileType](StationBuffer &b) {
+    this->formatAsciiStation(b.index, fileType, b.date, b.data, b.text);
+  };
+
+  int s0 = 0;
+  const int ns = this->m_station.size();
+  while (s0 < ns) {
+    std::vector<StationBuffer> batch;
+    size_t nSnaps = 0;
+    for (int s = s0; s < ns; ++s) {
+      const size_t n = this->m_station[s]->numSnaps();
+      if (!batch.empty() && nSnaps + n > batchSnaps) break;
+      nSnaps += n;
+      //...The series are taken here, on the calling thread, so that lazily
+      //   read stations are never fetched from the workers
+      StationBuffer b;
+      b.index = s;
+      this->stationSeries(s, b.date, b.data);
+      batch.push_back(b);
+    }
+
+    if (batch.size() > 1) {
+      QtConcurrent::blockingMap(batch, format);
+    } else {
+      format(batch.front());
+    }
+
+    for (const auto &b : batch) {
+      output.write(b.text);
+    }
+
+    s0 += static_cast<int>(batch.size());
+  }
+  return;
 }
 
 void Hmdf::deallocNcArrays(long long *time, double *data, char *name,
@@ -259,6 +397,178 @@ void Hmdf::deallocNcArrays(long long *time, double *data, char *name,
 }
 
 int Hmdf::writeNetcdf(QString filename) {
+  if (this->m_netcdfLayout == HmdfNetcdfRaggedArray)
+    return this->writeNetcdfRaggedArray(filename);
+  return this->writeNetcdfLegacy(filename);
+}
+
+int Hmdf::putNetcdfMetadata(int ncid) {
+  QString name = qgetenv("USER");
+  if (name.isEmpty()) name = qgetenv("USERNAME");
+  QString host = QHostInfo::localHostName();
+  QString createTime =
+      QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss");
+  QString source = "MetOceanViewer";
+  QString ncVersion = QString(nc_inq_libvers());
+  QString format = "20180123";
+
+  QVector<QPair<QString, QString>> attributes;
+  attributes.push_back(qMakePair(QStringLiteral("source"), source));
+  attributes.push_back(qMakePair(QStringLiteral("creation_date"), createTime));
+  attributes.push_back(qMakePair(QStringLiteral("created_by"), name));
+  attributes.push_back(qMakePair(QStringLiteral("host"), host));
+  attributes.push_back(qMakePair(QStringLiteral("netCDF_version"), ncVersion));
+  attributes.push_back(qMakePair(QStringLiteral("fileformat"), format));
+
+  for (auto &a : attributes) {
+    int ierr = nc_put_att(ncid, NC_GLOBAL, a.first.toStdString().c_str(),
+                          NC_CHAR, a.second.length(),
+                          a.second.toStdString().c_str());
+    if (ierr != NC_NOERR) return ierr;
+  }
+  return NC_NOERR;
+}
+
+int Hmdf::writeNetcdfRaggedArray(QString filename) {
+  int ncid;
+  int dimid_nstations, dimid_stationNameLength, dimid_nobs;
+  int varid_stationName, varid_stationId, varid_stationx, varid_stationy;
+  int varid_rowSize, varid_time, varid_data;
+
+  const size_t nstations = this->nstations();
+  const size_t nameLength = 200;
+
+  size_t nobs = 0;
+  for (auto &s : this->m_station) nobs += s->numSnaps();
+
+  //...A zero length passed to nc_def_dim makes the dimension unlimited,
+  //   so there is nothing sensible to write without any samples
+  if (nstations == 0 || nobs == 0) return NC_EINVAL;
+
+  //...Open file
+  NCCHECK(nc_create(filename.toStdString().c_str(), NC_NETCDF4, &ncid));
+
+  //...Dimensions
+  NCCHECK(nc_def_dim(ncid, "numStations", nstations, &dimid_nstations));
+  NCCHECK(
+      nc_def_dim(ncid, "stationNameLen", nameLength, &dimid_stationNameLength));
+  NCCHECK(nc_def_dim(ncid, "numObservations", nobs, &dimid_nobs));
+
+  //...Variables
+  int stationNameDims[2] = {dimid_nstations, dimid_stationNameLength};
+  int nstationDims[1] = {dimid_nstations};
+  int nobsDims[1] = {dimid_nobs};
+  int wgs84[1] = {4326};
+
+  NCCHECK(nc_def_var(ncid, "stationName", NC_CHAR, 2, stationNameDims,
+                     &varid_stationName));
+  NCCHECK(nc_def_var(ncid, "stationId", NC_CHAR, 2, stationNameDims,
+                     &varid_stationId));
+  NCCHECK(nc_def_var(ncid, "stationXCoordinate", NC_DOUBLE, 1, nstationDims,
+                     &varid_stationx));
+  NCCHECK(nc_def_var(ncid, "stationYCoordinate", NC_DOUBLE, 1, nstationDims,
+                     &varid_stationy));
+  NCCHECK(nc_def_var(ncid, "row_size", NC_INT64, 1, nstationDims,
+                     &varid_rowSize));
+  NCCHECK(nc_def_var(ncid, "time", NC_INT64, 1, nobsDims, &varid_time));
+  NCCHECK(nc_def_var(ncid, "data", NC_DOUBLE, 1, nobsDims, &varid_data));
+
+  NCCHECK(nc_put_att_text(ncid, varid_stationName, "cf_role", 13,
+                          "timeseries_id"));
+
+  NCCHECK(nc_put_att_text(ncid, varid_stationx, "HorizontalProjectionName", 5,
+                          "WGS84"));
+  NCCHECK(nc_put_att_text(ncid, varid_stationy, "HorizontalProjectionName", 5,
+                          "WGS84"));
+  NCCHECK(nc_put_att_int(ncid, varid_stationx, "HorizontalProjectionEPSG",
+                         NC_INT, 1, wgs84));
+  NCCHECK(nc_put_att_int(ncid, varid_stationy, "HorizontalProjectionEPSG",
+                         NC_INT, 1, wgs84));
+  NCCHECK(nc_put_att_text(ncid, varid_stationx, "standard_name", 9,
+                          "longitude"));
+  NCCHECK(nc_put_att_text(ncid, varid_stationy, "standard_name", 8,
+                          "latitude"));
+  NCCHECK(nc_put_att_text(ncid, varid_stationx, "units", 12, "degrees_east"));
+  NCCHECK(nc_put_att_text(ncid, varid_stationy, "units", 13, "degrees_north"));
+
+  NCCHECK(nc_put_att_text(ncid, varid_rowSize, "long_name", 39,
+                          "number of observations for this station"));
+  NCCHECK(nc_put_att_text(ncid, varid_rowSize, "sample_dimension", 15,
+                          "numObservations"));
+
+  NCCHECK(nc_put_att_text(ncid, varid_time, "standard_name", 4, "time"));
+  NCCHECK(nc_put_att_text(ncid, varid_time, "units", 33,
+                          "seconds since 1970-01-01 00:00:00"));
+  NCCHECK(nc_put_att_text(ncid, varid_time, "calendar", 9, "gregorian"));
+  NCCHECK(nc_put_att_text(ncid, varid_time, "referenceDate", 20,
+                          "1970-01-01 00:00:00"));
+  NCCHECK(nc_put_att_text(ncid, varid_time, "timezone", 3, "utc"));
+  NCCHECK(nc_def_var_deflate(ncid, varid_time, 1, 1, 2));
+
+  NCCHECK(nc_put_att_text(ncid, varid_data, "units", this->units().length(),
+                          this->units().toStdString().c_str()));
+  NCCHECK(nc_put_att_text(ncid, varid_data, "datum", this->datum().length(),
+                          this->datum().toStdString().c_str()));
+  NCCHECK(nc_put_att_text(ncid, varid_data, "coordinates", 42,
+                          "time stationYCoordinate stationXCoordinate"));
+  NCCHECK(nc_def_var_deflate(ncid, varid_data, 1, 1, 2));
+
+  //...Metadata
+  NCCHECK(nc_put_att_text(ncid, NC_GLOBAL, "Conventions", 6, "CF-1.8"));
+  NCCHECK(nc_put_att_text(ncid, NC_GLOBAL, "featureType", 10, "timeSeries"));
+  NCCHECK(this->putNetcdfMetadata(ncid));
+
+  NCCHECK(nc_enddef(ncid));
+
+  //...Gather every station into contiguous arrays so that each
+  //   variable is written with a single call
+  std::vector<double> lon(nstations), lat(nstations);
+  std::vector<long long> rowSize(nstations);
+  std::vector<char> name(nstations * nameLength, ' ');
+  std::vector<char> id(nstations * nameLength, ' ');
+  std::vector<long long> time(nobs);
+  std::vector<double> data(nobs);
+
+  size_t offset = 0;
+  for (size_t i = 0; i < nstations; ++i) {
+    HmdfStation *station = this->m_station[static_cast<int>(i)];
+    lon[i] = station->longitude();
+    lat[i] = station->latitude();
+    rowSize[i] = static_cast<long long>(station->numSnaps());
+
+    std::string n = station->name().toStdString();
+    std::string d = station->id().toStdString();
+    n.copy(&name[i * nameLength], std::min(n.length(), nameLength), 0);
+    d.copy(&id[i * nameLength], std::min(d.length(), nameLength), 0);
+
+    QVector<qint64> stationDate;
+    QVector<double> stationData;
+    this->stationSeries(static_cast<int>(i), stationDate, stationData);
+    for (int j = 0; j < stationDate.size(); ++j) {
+      time[offset + j] = stationDate[j] / 1000;
+      data[offset + j] = stationData[j];
+    }
+    offset += station->numSnaps();
+  }
+
+  if (nstations > 0) {
+    NCCHECK(nc_put_var_double(ncid, varid_stationx, lon.data()));
+    NCCHECK(nc_put_var_double(ncid, varid_stationy, lat.data()));
+    NCCHECK(nc_put_var_longlong(ncid, varid_rowSize, rowSize.data()));
+    NCCHECK(nc_put_var_text(ncid, varid_stationName, name.data()));
+    NCCHECK(nc_put_var_text(ncid, varid_stationId, id.data()));
+  }
+  if (nobs > 0) {
+    NCCHECK(nc_put_var_longlong(ncid, varid_time, time.data()));
+    NCCHECK(nc_put_var_double(ncid, varid_data, data.data()));
+  }
+
+  nc_close(ncid);
+
+  return 0;
+}
+
+int Hmdf::writeNetcdfLegacy(QString filename) {
   int ncid;
   int dimid_nstations, dimid_stationNameLength;
   int varid_stationName, varid_stationx, varid_stationy;
@@ -349,27 +659,7 @@ int Hmdf::writeNetcdf(QString filename) {
   }
 
   //...Metadata
-  QString name = qgetenv("USER");
-  if (name.isEmpty()) name = qgetenv("USERNAME");
-  QString host = QHostInfo::localHostName();
-  QString createTime =
-      QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss");
-  QString source = "MetOceanViewer";
-  QString ncVersion = QString(nc_inq_libvers());
-  QString format = "20180123";
-
-  NCCHECK(nc_put_att(ncid, NC_GLOBAL, "source", NC_CHAR, source.length(),
-                     source.toStdString().c_str()));
-  NCCHECK(nc_put_att(ncid, NC_GLOBAL, "creation_date", NC_CHAR,
-                     createTime.length(), createTime.toStdString().c_str()));
-  NCCHECK(nc_put_att(ncid, NC_GLOBAL, "created_by", NC_CHAR, name.length(),
-                     name.toStdString().c_str()));
-  NCCHECK(nc_put_att(ncid, NC_GLOBAL, "host", NC_CHAR, host.length(),
-                     host.toStdString().c_str()));
-  NCCHECK(nc_put_att(ncid, NC_GLOBAL, "netCDF_version", NC_CHAR,
-                     ncVersion.length(), ncVersion.toStdString().c_str()));
-  NCCHECK(nc_put_att(ncid, NC_GLOBAL, "fileformat", NC_CHAR, format.length(),
-                     format.toStdString().c_str()));
+  NCCHECK(this->putNetcdfMetadata(ncid));
 
   NCCHECK(nc_enddef(ncid));
 
@@ -393,9 +683,12 @@ int Hmdf::writeNetcdf(QString filename) {
     this->station(i)->id().toStdString().copy(
         id, this->station(i)->id().length(), 0);
 
-    for (int j = 0; j < this->station(i)->numSnaps(); j++) {
-      time[j] = this->station(i)->date(j) / 1000;
-      data[j] = this->station(i)->data(j);
+    QVector<qint64> stationDate;
+    QVector<double> stationData;
+    this->stationSeries(static_cast<int>(i), stationDate, stationData);
+    for (int j = 0; j < stationDate.size(); j++) {
+      time[j] = stationDate[j] / 1000;
+      data[j] = stationData[j];
     }
 
     int status = nc_put_var1_double(ncid, varid_stationx, stindex, lon);
@@ -474,27 +767,87 @@ int Hmdf::write(QString filename) {
 
 void Hmdf::dataBounds(qint64 &dateMin, qint64 &dateMax, double &minValue,
                       double &maxValue) {
-  dateMax = std::numeric_limits<qint64>::max();
-  dateMin = -std::numeric_limits<qint64>::max();
+  dateMin = std::numeric_limits<qint64>::max();
+  dateMax = -std::numeric_limits<qint64>::max();
   maxValue = -std::numeric_limits<double>::max();
   minValue = std::numeric_limits<double>::max();
 
-  for (size_t i = 0; i < this->nstations(); ++i) {
-    qint64 tempDateMin, tempDateMax;
-    double tempMinValue, tempMaxValue;
-    if (!this->station(i)->isNull()) {
-      this->station(i)->dataBounds(tempDateMin, tempDateMax, tempMinValue,
-                                   tempMaxValue);
-      dateMin = std::min(tempDateMin, dateMin);
-      dateMax = std::max(tempDateMax, dateMax);
-      minValue = std::min(tempMinValue, minValue);
-      maxValue = std::max(tempMaxValue, maxValue);
+  struct StationBounds {
+    const HmdfStation *station;
+    qint64 dateMin, dateMax;
+    double minValue, maxValue;
+  };
+
+  //...Lazily loaded stations are bounded here from what is already known
+  //   about them. One that has never been read is left out rather than
+  //   fetched, unless nothing else in the file can be bounded, in which
+  //   case the first is read so the caller still gets a time span. The
+  //   rest are bounded on the thread pool
+  std::vector<StationBounds> bounds;
+  bounds.reserve(this->nstations());
+  HmdfStation *unread = nullptr;
+  for (auto &stn : this->m_station) {
+    if (stn->isNull()) continue;
+    if (stn->isLazy() && !stn->hasBounds() && !stn->isLoaded()) {
+      if (!unread) unread = stn;
+      continue;
     }
+    StationBounds b;
+    b.station = stn;
+    if (stn->isLazy())
+      stn->dataBounds(b.dateMin, b.dateMax, b.minValue, b.maxValue);
+    bounds.push_back(b);
+  }
+  if (bounds.empty() && unread) {
+    StationBounds b;
+    b.station = unread;
+    unread->dataBounds(b.dateMin, b.dateMax, b.minValue, b.maxValue);
+    bounds.push_back(b);
+  }
+
+  auto stationBounds = [](StationBounds &b) {
+    if (b.station->isLazy()) return;
+    b.station->dataBounds(b.dateMin, b.dateMax, b.minValue, b.maxValue);
+  };
+
+  if (bounds.size() > 1) {
+    QtConcurrent::blockingMap(bounds, stationBounds);
+  } else {
+    for (auto &b : bounds) stationBounds(b);
   }
+
+  for (const auto &b : bounds) {
+    dateMin = std::min(b.dateMin, dateMin);
+    dateMax = std::max(b.dateMax, dateMax);
+    if (b.minValue == HmdfStation::nullDataValue()) continue;
+    minValue = std::min(b.minValue, minValue);
+    maxValue = std::max(b.maxValue, maxValue);
+  }
+
+  if (!bounds.empty() && minValue <= maxValue)
+    this->m_transform.applyBounds(dateMin, dateMax, minValue, maxValue);
   return;
 }
 
 bool Hmdf::applyDatumCorrection(const Station &s, const Datum::VDatum &datum) {
+  //...When every station is a column of this file's arena the shift is
+  //   applied in a single pass over the flat value array
+  if (datum != Datum::VDatum::NullDatum && this->stationsInArena()) {
+    Station stn = s;
+    double shift = HmdfStation::datumOffset(stn, datum);
+    if (stn.isNullOffset(shift)) return false;
+    double *data = this->m_arena->data();
+    const size_t n = this->m_arena->size();
+    for (size_t i = 0; i < n; ++i) {
+      data[i] += shift;
+    }
+    for (auto &stn : this->m_station) {
+      stn->invalidateBounds();
+    }
+    this->setDatum(datumName(datum));
+    return true;
+  }
+
   int ierr = 0;
   for (auto &stn : this->m_station) {
     ierr += stn->applyDatumCorrection(s, datum);
@@ -513,3 +866,62 @@ bool Hmdf::applyDatumCorrection(QVector<Station> &s, Datum::VDatum datum) {
   this->setDatum(Datum::datumName(datum));
   return true;
 }
+
+//...Switches every station to its compact storage. Stations in the
+//   file's arena keep their values there. Once every column holds its
+//   times in compact form the arena's time array is freed, and an arena
+//   no station uses any more (i.e. after single precision) is dropped
+void Hmdf::compact(bool singlePrecision) {
+  for (auto &stn : this->m_station) {
+    stn->compact(singlePrecision);
+  }
+
+  if (this->m_arena.isNull()) return;
+
+  bool used = false;
+  bool allCompact = true;
+  for (auto &stn : this->m_station) {
+    if (stn->arena() != this->m_arena.data()) continue;
+    used = true;
+    allCompact = allCompact && stn->isCompactDate();
+  }
+
+  if (!used)
+    this->m_arena.clear();
+  else if (allCompact && this->stationsInArena())
+    this->m_arena->releaseDate();
+}
+
+//...Readers that lay the file out as one arena register it here so that
+//   whole-file operations can run over the flat arrays
+void Hmdf::setArena(QSharedPointer<HmdfArena> arena) { this->m_arena = arena; }
+
+bool Hmdf::stationsInArena() const {
+  if (this->m_arena.isNull()) return false;
+  if (this->m_station.size() != this->m_arena->numColumns()) return false;
+  for (int i = 0; i < this->m_station.size(); ++i) {
+    const HmdfStation *stn = this->m_station[i];
+    if (stn->arena() != this->m_arena.data()) return false;
+    if (stn->arenaOffset() != this->m_arena->column(i).offset) return false;
+  }
+  return true;
+}
+
+HmdfTransform Hmdf::transform() const { return this->m_transform; }
+
+//...The transform is applied to everything read back out of this object
+//   (bounds and written files), never to the stored series
+void Hmdf::setTransform(const HmdfTransform &transform) {
+  this->m_transform = transform;
+}
+
+//...Copy of one station's series with the transform applied
+void Hmdf::stationSeries(int index, QVector<qint64> &date,
+                         QVector<double> &data) const {
+  const HmdfStation *station = this->m_station[index];
+  date = station->allDate();
+  data = station->allData();
+  this->m_transform.apply(date.data(), data.data(),
+                          static_cast<size_t>(date.size()),
+                          station->nullValue());
+}
@@ -20,8 +20,11 @@
 #ifndef HMDF_H
 #define HMDF_H
 
+#include <QByteArray>
 #include <QDateTime>
+#include <QFile>
 #include <QObject>
+#include <QSharedPointer>
 #include <QString>
 #include <QStringList>
 #include <QVector>
@@ -30,6 +33,7 @@
 #include <vector>
 
 #include "hmdfstation.h"
+#include "hmdftransform.h"
 #include "metocean_global.h"
 #include "timezone.h"
 
@@ -43,6 +47,11 @@ class Hmdf : public QObject {
 
   enum HmdfFileType { HmdfImeds, HmdfCsv, HmdfNetCdf };
 
+  //...Legacy writes one dimension and two variables per station. The
+  //   ragged array layout is the CF-1.8 "timeSeries" contiguous ragged
+  //   array, with all samples in one time and one data variable
+  enum HmdfNetcdfLayout { HmdfNetcdfLegacy, HmdfNetcdfRaggedArray };
+
   int write(QString filename, HmdfFileType fileType);
   int write(QString filename);
   int writeImeds(QString filename);
@@ -51,6 +60,9 @@ class Hmdf : public QObject {
 
   int readImeds(QString filename);
   int readNetcdf(QString filename);
+  int readNetcdfLazy(
+      QString filename,
+      size_t cacheBytes = HmdfStationCache::defaultMaxBytes());
 
   size_t nstations() const;
   // void setNstations(size_t nstations);
@@ -74,6 +86,12 @@ class Hmdf : public QObject {
   void setStation(int index, HmdfStation *station);
   void addStation(HmdfStation *station);
 
+  HmdfTransform transform() const;
+  void setTransform(const HmdfTransform &transform);
+
+  HmdfNetcdfLayout netcdfLayout() const;
+  void setNetcdfLayout(const HmdfNetcdfLayout &netcdfLayout);
+
   bool success() const;
   void setSuccess(bool success);
 
@@ -86,12 +104,29 @@ class Hmdf : public QObject {
   bool applyDatumCorrection(const Station &s, const Datum::VDatum &datum);
   bool applyDatumCorrection(QVector<Station> &s, Datum::VDatum datum);
 
+  void compact(bool singlePrecision = false);
+
+  void setArena(QSharedPointer<HmdfArena> arena);
+
  private:
   void init();
+  void formatAsciiStation(int index, HmdfFileType fileType,
+                          const QVector<qint64> &date,
+                          const QVector<double> &data,
+                          QByteArray &buffer) const;
+  void writeAsciiStations(QFile &output, HmdfFileType fileType) const;
+  int writeNetcdfLegacy(QString filename);
+  int writeNetcdfRaggedArray(QString filename);
+  int putNetcdfMetadata(int ncid);
+  bool stationsInArena() const;
+  void stationSeries(int index, QVector<qint64> &date,
+                     QVector<double> &data) const;
   void deallocNcArrays(long long *time, double *data, char *name, char *id);
 
   //...Variables
   bool m_success, m_null;
+  HmdfNetcdfLayout m_netcdfLayout;
+  HmdfTransform m_transform;
 
   Timezone m_tz;
   QString m_header1;
@@ -100,6 +135,7 @@ class Hmdf : public QObject {
   QString m_units;
   QString m_datum;
   QVector<HmdfStation *> m_station;
+  QSharedPointer<HmdfArena> m_arena;
 };
 
 #endif  // HMDF_H
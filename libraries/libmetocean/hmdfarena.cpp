@@ -0,0 +1,81 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#include "hmdfarena.h"
+
+HmdfArena::HmdfArena(const QVector<size_t> &lengths) {
+  size_t offset = 0;
+  this->m_columns.reserve(lengths.size());
+  for (auto &l : lengths) {
+    Column c;
+    c.offset = offset;
+    c.length = l;
+    this->m_columns.push_back(c);
+    offset += l;
+  }
+  this->m_size = offset;
+  this->m_date.resize(offset);
+  this->m_data.resize(offset);
+}
+
+size_t HmdfArena::size() const { return this->m_size; }
+
+int HmdfArena::numColumns() const {
+  return static_cast<int>(this->m_columns.size());
+}
+
+const HmdfArena::Column &HmdfArena::column(int index) const {
+  Q_ASSERT(index >= 0 &&
+           static_cast<size_t>(index) < this->m_columns.size());
+  return this->m_columns[index];
+}
+
+//...Columns can only shrink, i.e. when a reader finds fewer records than
+//   it sized the arena for. The unused tail is left in place. Readers
+//   filling columns concurrently may each shrink their own column
+void HmdfArena::setColumnLength(int index, size_t length) {
+  Q_ASSERT(index >= 0 &&
+           static_cast<size_t>(index) < this->m_columns.size());
+  Q_ASSERT(length <= this->m_columns[index].length);
+  this->m_columns[index].length = length;
+}
+
+qint64 *HmdfArena::date() { return this->m_date.data(); }
+
+const qint64 *HmdfArena::date() const { return this->m_date.data(); }
+
+double *HmdfArena::data() { return this->m_data.data(); }
+
+const double *HmdfArena::data() const { return this->m_data.data(); }
+
+qint64 *HmdfArena::date(int column) {
+  return this->m_date.data() + this->column(column).offset;
+}
+
+double *HmdfArena::data(int column) {
+  return this->m_data.data() + this->column(column).offset;
+}
+
+bool HmdfArena::hasDate() const {
+  return this->m_size == 0 || !this->m_date.empty();
+}
+
+//...Frees the times once no column reads them, i.e. when every station
+//   of the arena holds its times in compact form
+void HmdfArena::releaseDate() { std::vector<qint64>().swap(this->m_date); }
@@ -0,0 +1,63 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#ifndef HMDFARENA_H
+#define HMDFARENA_H
+
+#include <QVector>
+#include <QtGlobal>
+#include <vector>
+
+//...Contiguous storage for the series of all stations in a file. Each
+//   station is a column, a [offset, offset + length) range of the shared
+//   date and value arrays, so whole-file loops run over flat memory
+class HmdfArena {
+ public:
+  struct Column {
+    size_t offset;
+    size_t length;
+  };
+
+  explicit HmdfArena(const QVector<size_t> &lengths);
+
+  size_t size() const;
+  int numColumns() const;
+
+  const Column &column(int index) const;
+  void setColumnLength(int index, size_t length);
+
+  qint64 *date();
+  const qint64 *date() const;
+  double *data();
+  const double *data() const;
+
+  qint64 *date(int column);
+  double *data(int column);
+
+  bool hasDate() const;
+  void releaseDate();
+
+ private:
+  std::vector<Column> m_columns;
+  size_t m_size;
+  std::vector<qint64> m_date;
+  std::vector<double> m_data;
+};
+
+#endif  // HMDFARENA_H
@@ -0,0 +1,169 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#include "hmdfasciiformatter.h"
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+//...Calendar date from a day number relative to 1970-01-01 (H. Hinnant)
+void civilFromDays(long long z, int &y, int &m, int &d) {
+  z += 719468;
+  const long long era = (z >= 0 ? z : z - 146096) / 146097;
+  const long long doe = z - era * 146097;
+  const long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const long long mp = (5 * doy + 2) / 153;
+  d = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+  m = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+  y = static_cast<int>(yoe + era * 400 + (m <= 2 ? 1 : 0));
+}
+
+inline char *put2(char *p, int v) {
+  p[0] = static_cast<char>('0' + v / 10);
+  p[1] = static_cast<char>('0' + v % 10);
+  return p + 2;
+}
+
+inline char *put4(char *p, int v) {
+  p[0] = static_cast<char>('0' + v / 1000);
+  p[1] = static_cast<char>('0' + (v / 100) % 10);
+  p[2] = static_cast<char>('0' + (v / 10) % 10);
+  p[3] = static_cast<char>('0' + v % 10);
+  return p + 4;
+}
+
+inline char *putSpaces(char *p, int n) {
+  for (int i = 0; i < n; ++i) p[i] = ' ';
+  return p + n;
+}
+
+//...10^k for k in [-308, 308]
+const double *powersOfTen() {
+  static const struct Table {
+    double v[617];
+    Table() {
+      for (int k = -308; k <= 308; ++k) v[k + 308] = std::pow(10.0, k);
+    }
+  } table;
+  return table.v;
+}
+
+int formatValueSlow(double value, char *out) {
+  return std::snprintf(out, 32, "%10.4e", value);
+}
+
+}  // namespace
+
+void HmdfAsciiFormatter::toCivil(long long msec, int &yr, int &month,
+                                 int &day, int &hr, int &min, int &sec) {
+  const long long msPerDay = 86400000LL;
+  long long days = msec / msPerDay;
+  long long rem = msec % msPerDay;
+  if (rem < 0) {
+    rem += msPerDay;
+    days -= 1;
+  }
+  civilFromDays(days, yr, month, day);
+  const int secs = static_cast<int>(rem / 1000);
+  hr = secs / 3600;
+  min = (secs / 60) % 60;
+  sec = secs % 60;
+}
+
+//...Writes "yyyy    MM    dd    hh    mm    ss". Returns the number of
+//   characters written, or 0 when the year cannot be written as four
+//   digits and the caller should fall back to QDateTime
+int HmdfAsciiFormatter::formatImedsDate(long long msec, char *out) {
+  int yr, month, day, hr, min, sec;
+  HmdfAsciiFormatter::toCivil(msec, yr, month, day, hr, min, sec);
+  if (yr < 1000 || yr > 9999) return 0;
+  char *p = put4(out, yr);
+  p = putSpaces(p, 4);
+  p = put2(p, month);
+  p = putSpaces(p, 4);
+  p = put2(p, day);
+  p = putSpaces(p, 4);
+  p = put2(p, hr);
+  p = putSpaces(p, 4);
+  p = put2(p, min);
+  p = putSpaces(p, 4);
+  p = put2(p, sec);
+  return static_cast<int>(p - out);
+}
+
+//...Writes "MM/dd/yyyy,hh:mm,". Same return convention as formatImedsDate
+int HmdfAsciiFormatter::formatCsvDate(long long msec, char *out) {
+  int yr, month, day, hr, min, sec;
+  HmdfAsciiFormatter::toCivil(msec, yr, month, day, hr, min, sec);
+  if (yr < 1000 || yr > 9999) return 0;
+  char *p = put2(out, month);
+  *p++ = '/';
+  p = put2(p, day);
+  *p++ = '/';
+  p = put4(p, yr);
+  *p++ = ',';
+  p = put2(p, hr);
+  *p++ = ':';
+  p = put2(p, min);
+  *p++ = ',';
+  return static_cast<int>(p - out);
+}
+
+//...Equivalent of printf("%10.4e"). The five significant digits are
+//   found with a single scaling. Values that land too close to a rounding
+//   tie, and non-finite or extreme values, are passed to snprintf so the
+//   output is always identical. The buffer must hold at least 32 chars
+int HmdfAsciiFormatter::formatValue(double value, char *out) {
+  const double a = std::fabs(value);
+  if (!(a >= 1e-300 && a <= 1e300)) return formatValueSlow(value, out);
+
+  int e = static_cast<int>(std::floor(std::log10(a)));
+  double scaled = a * powersOfTen()[4 - e + 308];
+  if (scaled < 10000.0) {
+    scaled *= 10.0;
+    e -= 1;
+  } else if (scaled >= 100000.0) {
+    scaled /= 10.0;
+    e += 1;
+  }
+
+  const double whole = std::floor(scaled);
+  const double frac = scaled - whole;
+  if (std::fabs(frac - 0.5) < 1e-6) return formatValueSlow(value, out);
+
+  int m = static_cast<int>(whole) + (frac > 0.5 ? 1 : 0);
+  if (m == 100000) {
+    m = 10000;
+    e += 1;
+  }
+
+  char *p = out;
+  if (value < 0) *p++ = '-';
+  *p++ = static_cast<char>('0' + m / 10000);
+  *p++ = '.';
+  p = put4(p, m % 10000);
+  *p++ = 'e';
+  *p++ = e < 0 ? '-' : '+';
+  const int ae = e < 0 ? -e : e;
+  if (ae >= 100) *p++ = static_cast<char>('0' + ae / 100);
+  p = put2(p, ae % 100);
+  return static_cast<int>(p - out);
+}
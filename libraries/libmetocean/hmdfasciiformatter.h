@@ -0,0 +1,35 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#ifndef HMDFASCIIFORMATTER_H
+#define HMDFASCIIFORMATTER_H
+
+class HmdfAsciiFormatter {
+ public:
+  static void toCivil(long long msec, int &yr, int &month, int &day, int &hr,
+                      int &min, int &sec);
+
+  static int formatImedsDate(long long msec, char *out);
+
+  static int formatCsvDate(long long msec, char *out);
+
+  static int formatValue(double value, char *out);
+};
+
+#endif  // HMDFASCIIFORMATTER_H
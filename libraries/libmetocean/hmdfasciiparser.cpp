@@ -18,6 +18,8 @@
 //
 //-----------------------------------------------------------------------*/
 #include "hmdfasciiparser.h"
+#include <cstdlib>
+#include <cstring>
 #include "boost/config/warning_disable.hpp"
 #include "boost/fusion/include/adapt_struct.hpp"
 #include "boost/fusion/include/io.hpp"
@@ -130,3 +132,301 @@ bool HmdfAsciiParser::splitStringHmdfFormat(std::string &data, int &yr, int &mon
     }
   }
 }
+
+//--HAND WRITTEN TOKENIZER--//
+
+namespace {
+
+struct NumberToken {
+  const char *begin;
+  const char *end;
+  bool isInteger;
+};
+
+inline bool isSpace(const char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline bool isDigit(const char c) { return c >= '0' && c <= '9'; }
+
+inline void skipSpace(const char *&p, const char *end) {
+  while (p < end && isSpace(*p)) ++p;
+}
+
+//...Scans one whitespace delimited number. The token must be terminated
+//   by whitespace or the end of the line to be accepted
+bool scanNumber(const char *&p, const char *end, NumberToken &token) {
+  skipSpace(p, end);
+  const char *c = p;
+  token.begin = c;
+  token.isInteger = true;
+
+  if (c < end && (*c == '-' || *c == '+')) ++c;
+
+  size_t nDigits = 0;
+  while (c < end && isDigit(*c)) {
+    ++c;
+    ++nDigits;
+  }
+
+  if (c < end && *c == '.') {
+    token.isInteger = false;
+    ++c;
+    while (c < end && isDigit(*c)) {
+      ++c;
+      ++nDigits;
+    }
+  }
+
+  if (nDigits == 0) return false;
+
+  if (c < end && (*c == 'e' || *c == 'E')) {
+    token.isInteger = false;
+    ++c;
+    if (c < end && (*c == '-' || *c == '+')) ++c;
+    if (c == end || !isDigit(*c)) return false;
+    while (c < end && isDigit(*c)) ++c;
+  }
+
+  if (c < end && !isSpace(*c)) return false;
+
+  token.end = c;
+  p = c;
+  return true;
+}
+
+inline int tokenToInt(const NumberToken &token) {
+  const char *c = token.begin;
+  bool negative = false;
+  if (*c == '-' || *c == '+') {
+    negative = *c == '-';
+    ++c;
+  }
+  int v = 0;
+  for (; c < token.end; ++c) v = v * 10 + (*c - '0');
+  return negative ? -v : v;
+}
+
+//...Fast path for decimal strings which can be represented exactly
+//   (Clinger). Anything outside of that range is passed to strtod so
+//   the result is always correctly rounded
+double tokenToDouble(const NumberToken &token) {
+  static const double pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                 1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                 1e18, 1e19, 1e20, 1e21, 1e22};
+
+  const char *c = token.begin;
+  bool negative = false;
+  if (*c == '-' || *c == '+') {
+    negative = *c == '-';
+    ++c;
+  }
+
+  unsigned long long mantissa = 0;
+  int nDigits = 0;
+  int exponent = 0;
+
+  for (; c < token.end && isDigit(*c); ++c) {
+    if (mantissa == 0 && *c == '0') continue;
+    mantissa = mantissa * 10 + static_cast<unsigned>(*c - '0');
+    ++nDigits;
+  }
+  if (c < token.end && *c == '.') {
+    ++c;
+    for (; c < token.end && isDigit(*c); ++c) {
+      if (mantissa == 0 && *c == '0') {
+        --exponent;
+        continue;
+      }
+      mantissa = mantissa * 10 + static_cast<unsigned>(*c - '0');
+      ++nDigits;
+      --exponent;
+    }
+  }
+  if (c < token.end && (*c == 'e' || *c == 'E')) {
+    ++c;
+    bool negativeExponent = false;
+    if (*c == '-' || *c == '+') {
+      negativeExponent = *c == '-';
+      ++c;
+    }
+    int e = 0;
+    for (; c < token.end && e < 100000; ++c) e = e * 10 + (*c - '0');
+    exponent += negativeExponent ? -e : e;
+  }
+
+  if (nDigits <= 15 && exponent >= -22 && exponent <= 22) {
+    double v = static_cast<double>(mantissa);
+    v = exponent < 0 ? v / pow10[-exponent] : v * pow10[exponent];
+    return negative ? -v : v;
+  }
+
+  char buffer[64];
+  size_t n = static_cast<size_t>(token.end - token.begin);
+  if (n >= sizeof(buffer)) n = sizeof(buffer) - 1;
+  std::memcpy(buffer, token.begin, n);
+  buffer[n] = '\0';
+  return std::strtod(buffer, nullptr);
+}
+
+//...An IMEDS record is yr mo da hr mi [sec] value
+bool scanRecord(const char *begin, const char *end, NumberToken *tokens,
+                bool &hasSeconds) {
+  const char *p = begin;
+  for (int i = 0; i < 6; ++i) {
+    if (!scanNumber(p, end, tokens[i])) return false;
+    if (i < 5 && !tokens[i].isInteger) return false;
+  }
+  hasSeconds = tokens[5].isInteger && scanNumber(p, end, tokens[6]);
+  return true;
+}
+
+//...Gregorian calendar day number relative to 1970-01-01 (H. Hinnant)
+long long daysFromCivil(int y, int m, int d) {
+  y -= m <= 2 ? 1 : 0;
+  const long long era = (y >= 0 ? y : y - 399) / 400;
+  const long long yoe = y - era * 400;
+  const long long doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+bool isBlankLine(const char *begin, const char *end) {
+  skipSpace(begin, end);
+  return begin == end;
+}
+
+}  // namespace
+
+//--END HAND WRITTEN TOKENIZER--//
+
+bool HmdfAsciiParser::isHmdfRecord(const char *begin, const char *end) {
+  NumberToken tokens[7];
+  bool hasSeconds;
+  return scanRecord(begin, end, tokens, hasSeconds);
+}
+
+bool HmdfAsciiParser::parseHmdfRecord(const char *begin, const char *end,
+                                      long long &msec, double &value) {
+  NumberToken tokens[7];
+  bool hasSeconds;
+  if (!scanRecord(begin, end, tokens, hasSeconds)) return false;
+
+  int sec = hasSeconds ? tokenToInt(tokens[5]) : 0;
+  value = tokenToDouble(hasSeconds ? tokens[6] : tokens[5]);
+  msec = HmdfAsciiParser::toMSecsSinceEpoch(
+      tokenToInt(tokens[0]), tokenToInt(tokens[1]), tokenToInt(tokens[2]),
+      tokenToInt(tokens[3]), tokenToInt(tokens[4]), sec);
+  return true;
+}
+
+long long HmdfAsciiParser::toMSecsSinceEpoch(int yr, int month, int day,
+                                             int hr, int min, int sec) {
+  return ((daysFromCivil(yr, month, day) * 24 + hr) * 60 + min) * 60000LL +
+         sec * 1000LL;
+}
+
+const char *HmdfAsciiParser::lineEnd(const char *pos, const char *end) {
+  const char *eol =
+      static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+  return eol ? eol : end;
+}
+
+//...Splits the body into about nChunks pieces on line boundaries. Chunks
+//   are kept to at least a megabyte so small files aren't scattered
+void HmdfAsciiParser::splitImedsChunks(const char *begin, const char *end,
+                                       size_t nChunks,
+                                       std::vector<ImedsChunkIndex> &chunks) {
+  static const size_t minChunkSize = 1 << 20;
+  chunks.clear();
+
+  const size_t size = static_cast<size_t>(end - begin);
+  size_t chunkSize = size / (nChunks > 0 ? nChunks : 1);
+  if (chunkSize < minChunkSize) chunkSize = minChunkSize;
+
+  const char *pos = begin;
+  while (pos < end) {
+    const char *split =
+        static_cast<size_t>(end - pos) > chunkSize ? pos + chunkSize : end;
+    if (split < end) {
+      split = HmdfAsciiParser::lineEnd(split, end);
+      if (split < end) ++split;
+    }
+
+    ImedsChunkIndex chunk;
+    chunk.begin = pos;
+    chunk.end = split;
+    chunk.leadEnd = pos;
+    chunk.leadSnaps = 0;
+    chunks.push_back(chunk);
+    pos = split;
+  }
+}
+
+//...Chunks don't share any state, so they can be indexed concurrently
+void HmdfAsciiParser::indexImedsChunk(ImedsChunkIndex &chunk) {
+  chunk.blocks.clear();
+  const char *pos = chunk.begin;
+  while (pos < chunk.end) {
+    const char *eol = HmdfAsciiParser::lineEnd(pos, chunk.end);
+    const char *next = eol < chunk.end ? eol + 1 : chunk.end;
+    if (HmdfAsciiParser::isHmdfRecord(pos, eol)) {
+      if (!chunk.blocks.empty()) {
+        chunk.blocks.back().dataEnd = eol;
+        chunk.blocks.back().numSnaps++;
+      } else {
+        chunk.leadEnd = eol;
+        chunk.leadSnaps++;
+      }
+    } else if (!isBlankLine(pos, eol)) {
+      ImedsStationBlock block;
+      block.headerBegin = pos;
+      block.headerEnd = eol;
+      block.dataBegin = next;
+      block.dataEnd = next;
+      block.numSnaps = 0;
+      chunk.blocks.push_back(block);
+    }
+    pos = next;
+  }
+}
+
+void HmdfAsciiParser::mergeImedsChunks(
+    const std::vector<ImedsChunkIndex> &chunks,
+    std::vector<ImedsStationBlock> &blocks) {
+  blocks.clear();
+  for (const auto &chunk : chunks) {
+    if (chunk.leadSnaps > 0 && !blocks.empty()) {
+      blocks.back().dataEnd = chunk.leadEnd;
+      blocks.back().numSnaps += chunk.leadSnaps;
+    }
+    blocks.insert(blocks.end(), chunk.blocks.begin(), chunk.blocks.end());
+  }
+}
+
+size_t HmdfAsciiParser::parseImedsStation(const ImedsStationBlock &block,
+                                          long long *date, double *value) {
+  size_t n = 0;
+  const char *pos = block.dataBegin;
+  while (pos < block.dataEnd && n < block.numSnaps) {
+    const char *eol = HmdfAsciiParser::lineEnd(pos, block.dataEnd);
+    if (HmdfAsciiParser::parseHmdfRecord(pos, eol, date[n], value[n])) ++n;
+    pos = eol + 1;
+  }
+  return n;
+}
+
+//...Reads up to maxValues whitespace delimited numbers from the start of
+//   a line. Returns the number read, stopping at the first token that
+//   isn't a number
+size_t HmdfAsciiParser::parseNumbers(const char *begin, const char *end,
+                                     double *values, size_t maxValues) {
+  const char *p = begin;
+  size_t n = 0;
+  NumberToken token;
+  while (n < maxValues && scanNumber(p, end, token)) {
+    values[n++] = tokenToDouble(token);
+  }
+  return n;
+}
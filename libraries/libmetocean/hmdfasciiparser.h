@@ -20,13 +20,59 @@
 #ifndef HMDFASCIIPARSER_H
 #define HMDFASCIIPARSER_H
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 class HmdfAsciiParser {
  public:
+  //...Byte range of one station in an IMEDS file: the name/lat/lon
+  //   header line followed by its sample lines
+  struct ImedsStationBlock {
+    const char *headerBegin;
+    const char *headerEnd;
+    const char *dataBegin;
+    const char *dataEnd;
+    size_t numSnaps;
+  };
+
+  //...Station blocks found in one chunk of an IMEDS file. Records ahead
+  //   of the chunk's first header line belong to the last block of the
+  //   chunks before it
+  struct ImedsChunkIndex {
+    const char *begin;
+    const char *end;
+    const char *leadEnd;
+    size_t leadSnaps;
+    std::vector<ImedsStationBlock> blocks;
+  };
+
   static bool splitStringHmdfFormat(std::string &data, int &yr, int &month,
                                     int &day, int &hr, int &min, int &sec,
                                     double &value);
+
+  static bool isHmdfRecord(const char *begin, const char *end);
+
+  static bool parseHmdfRecord(const char *begin, const char *end,
+                              long long &msec, double &value);
+
+  static long long toMSecsSinceEpoch(int yr, int month, int day, int hr,
+                                     int min, int sec);
+
+  static const char *lineEnd(const char *pos, const char *end);
+
+  static void splitImedsChunks(const char *begin, const char *end,
+                               size_t nChunks,
+                               std::vector<ImedsChunkIndex> &chunks);
+  static void indexImedsChunk(ImedsChunkIndex &chunk);
+  static void mergeImedsChunks(const std::vector<ImedsChunkIndex> &chunks,
+                               std::vector<ImedsStationBlock> &blocks);
+
+  static size_t parseImedsStation(const ImedsStationBlock &block,
+                                  long long *date, double *value);
+
+  static size_t parseNumbers(const char *begin, const char *end,
+                             double *values, size_t maxValues);
 };
 
 #endif  // HMDFASCIIPARSER_H
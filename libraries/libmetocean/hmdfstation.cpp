@@ -19,6 +19,36 @@
 //-----------------------------------------------------------------------*/
 #include "hmdfstation.h"
 
+namespace {
+//...Branch free min/max loops so the compiler can vectorize them
+void dateKernel(const qint64 *date, size_t n, qint64 &minDate,
+                qint64 &maxDate) {
+  qint64 lo = minDate;
+  qint64 hi = maxDate;
+  for (size_t i = 0; i < n; ++i) {
+    lo = date[i] < lo ? date[i] : lo;
+    hi = date[i] > hi ? date[i] : hi;
+  }
+  minDate = lo;
+  maxDate = hi;
+}
+
+template <typename T>
+void valueKernel(const T *data, size_t n, double nullValue, double &minValue,
+                 double &maxValue) {
+  double lo = minValue;
+  double hi = maxValue;
+  for (size_t i = 0; i < n; ++i) {
+    const double v = static_cast<double>(data[i]);
+    const bool valid = !HmdfStation::isNullValue(v, nullValue);
+    lo = valid && v < lo ? v : lo;
+    hi = valid && v > hi ? v : hi;
+  }
+  minValue = lo;
+  maxValue = hi;
+}
+}  // namespace
+
 HmdfStation::HmdfStation(QObject *parent) : QObject(parent) {
   this->m_coordinate = QGeoCoordinate();
   this->m_name = "noname";
@@ -26,16 +56,46 @@ HmdfStation::HmdfStation(QObject *parent) : QObject(parent) {
   this->m_isNull = true;
   this->m_stationIndex = 0;
   this->m_nullValue = HmdfStation::nullDataValue();
+  this->m_cacheIndex = 0;
+  this->m_loaded = true;
+  this->m_lruPrev = nullptr;
+  this->m_lruNext = nullptr;
+  this->m_arenaOffset = 0;
+  this->m_arenaLength = 0;
+  this->m_compactDate = false;
+  this->m_interval = 0;
+  this->m_singlePrecision = false;
+  this->m_boundsValid = false;
+  this->m_minDate = 0;
+  this->m_maxDate = 0;
+  this->m_minValue = 0.0;
+  this->m_maxValue = 0.0;
+}
+
+HmdfStation::~HmdfStation() {
+  if (!this->m_cache.isNull()) this->m_cache->release(this);
 }
 
 void HmdfStation::clear() {
+  if (!this->m_cache.isNull()) {
+    this->m_cache->release(this);
+    this->m_cache.clear();
+    this->m_loaded = true;
+  }
   this->m_coordinate = QGeoCoordinate();
   this->m_name = "noname";
   this->m_id = "noid";
   this->m_isNull = true;
   this->m_stationIndex = 0;
+  this->m_arena.clear();
   this->m_data.clear();
   this->m_date.clear();
+  this->m_compactDate = false;
+  this->m_interval = 0;
+  this->m_dateSegments.clear();
+  this->m_singlePrecision = false;
+  this->m_dataFloat.clear();
+  this->invalidateBounds();
   return;
 }
 
@@ -47,7 +107,14 @@ QString HmdfStation::id() const { return this->m_id; }
 
 void HmdfStation::setId(const QString &id) { this->m_id = id; }
 
-size_t HmdfStation::numSnaps() const { return this->m_data.size(); }
+//...Lazily loaded stations take their length from the file so it can be
+//   asked for without reading the series
+size_t HmdfStation::numSnaps() const {
+  if (!this->m_cache.isNull()) return this->m_cache->length(this);
+  if (!this->m_arena.isNull()) return this->m_arenaLength;
+  if (this->m_singlePrecision) return this->m_dataFloat.size();
+  return this->m_data.size();
+}
 
 int HmdfStation::stationIndex() const { return this->m_stationIndex; }
 
@@ -56,29 +123,46 @@ void HmdfStation::setStationIndex(int stationIndex) {
 }
 
 qint64 HmdfStation::date(int index) const {
+  this->useData();
   Q_ASSERT(index >= 0 && index < this->numSnaps());
   if (index >= 0 || index < this->numSnaps())
-    return this->m_date[index];
+    return this->dateAt(index);
   else
     return 0;
 }
 
 double HmdfStation::data(int index) const {
+  this->useData();
   Q_ASSERT(index >= 0 && index < this->numSnaps());
   if (index >= 0 || index < this->numSnaps())
-    return this->m_data[index];
+    return this->dataAt(index);
   else
     return 0;
 }
 
 void HmdfStation::setData(const double &data, int index) {
+  this->detachCache();
+  this->invalidateBounds();
   Q_ASSERT(index >= 0 && index < this->numSnaps());
-  if (index >= 0 || index < this->numSnaps()) this->m_data[index] = data;
+  if (index >= 0 || index < this->numSnaps()) {
+    if (this->m_singlePrecision)
+      this->m_dataFloat[index] = static_cast<float>(data);
+    else
+      this->mutableDataPointer()[index] = data;
+  }
 }
 
 void HmdfStation::setDate(const qint64 &date, int index) {
+  this->detachCache();
+  this->invalidateBounds();
   Q_ASSERT(index >= 0 && index < this->numSnaps());
-  if (index >= 0 || index < this->numSnaps()) this->m_date[index] = date;
+  if (index >= 0 || index < this->numSnaps()) {
+    if (this->m_compactDate) {
+      if (this->dateAt(index) == date) return;
+      this->expandDate();
+    }
+    this->mutableDatePointer()[index] = date;
+  }
 }
 
 bool HmdfStation::isNull() const { return this->m_isNull; }
@@ -86,16 +170,38 @@ bool HmdfStation::isNull() const { return this->m_isNull; }
 void HmdfStation::setIsNull(bool isNull) { this->m_isNull = isNull; }
 
 void HmdfStation::setDate(const QVector<qint64> &date) {
+  this->detachCache();
+  this->invalidateBounds();
+  this->detachArena();
+  this->m_compactDate = false;
+  this->m_dateSegments.clear();
   this->m_date = date;
   return;
 }
 
 void HmdfStation::setData(const QVector<double> &data) {
-  this->m_data = data;
+  this->detachCache();
+  this->invalidateBounds();
+  this->detachArena();
+  if (this->m_singlePrecision) {
+    this->m_dataFloat.resize(data.size());
+    for (int i = 0; i < data.size(); ++i) {
+      this->m_dataFloat[i] = static_cast<float>(data[i]);
+    }
+  } else {
+    this->m_data = data;
+  }
   return;
 }
 
 void HmdfStation::setData(const QVector<float> &data) {
+  this->detachCache();
+  this->invalidateBounds();
+  this->detachArena();
+  if (this->m_singlePrecision) {
+    this->m_dataFloat = data;
+    return;
+  }
   this->m_data.resize(data.size());
   for (size_t i = 0; i < data.size(); ++i) {
     this->m_data[i] = static_cast<double>(data[i]);
@@ -104,13 +210,119 @@ void HmdfStation::setData(const QVector<float> &data) {
 }
 
 void HmdfStation::setNext(const qint64 &date, const double &data) {
-  this->m_date.push_back(date);
-  this->m_data.push_back(data);
+  this->detachCache();
+  this->detachArena();
+
+  //...A regular series stays compact while the new time continues the
+  //   current interval, otherwise a new segment starts here
+  if (this->m_compactDate) {
+    const int n = static_cast<int>(this->numSnaps());
+    if (n == 0 || date != this->dateAt(n - 1) + this->m_interval) {
+      DateSegment segment;
+      segment.start = n;
+      segment.t0 = date;
+      this->m_dateSegments.push_back(segment);
+    }
+  } else {
+    this->m_date.push_back(date);
+  }
+
+  if (this->m_singlePrecision)
+    this->m_dataFloat.push_back(static_cast<float>(data));
+  else
+    this->m_data.push_back(data);
+
+  //...Appending only widens the bounds, so they are kept up to date
+  if (this->m_boundsValid) {
+    const double value = this->dataAt(this->numSnaps() - 1);
+    this->m_minDate = std::min(this->m_minDate, date);
+    this->m_maxDate = std::max(this->m_maxDate, date);
+    if (!HmdfStation::isNullValue(value, this->m_nullValue)) {
+      if (this->m_minValue == HmdfStation::nullDataValue()) {
+        this->m_minValue = value;
+        this->m_maxValue = value;
+      } else {
+        this->m_minValue = std::min(this->m_minValue, value);
+        this->m_maxValue = std::max(this->m_maxValue, value);
+      }
+    }
+  }
 }
 
-QVector<qint64> HmdfStation::allDate() const { return this->m_date; }
+QVector<qint64> HmdfStation::allDate() const {
+  this->useData();
+  if (this->m_compactDate) {
+    QVector<qint64> date(static_cast<int>(this->numSnaps()));
+    this->fillCompactDate(date.data(), date.size());
+    return date;
+  }
+  if (this->m_arena.isNull()) return this->m_date;
+  QVector<qint64> date(static_cast<int>(this->m_arenaLength));
+  std::copy(this->datePointer(), this->datePointer() + this->m_arenaLength,
+            date.begin());
+  return date;
+}
 
-QVector<double> HmdfStation::allData() const { return this->m_data; }
+QVector<double> HmdfStation::allData() const {
+  this->useData();
+  if (this->m_singlePrecision) {
+    QVector<double> data(this->m_dataFloat.size());
+    for (int i = 0; i < data.size(); ++i) {
+      data[i] = static_cast<double>(this->m_dataFloat[i]);
+    }
+    return data;
+  }
+  if (this->m_arena.isNull()) return this->m_data;
+  QVector<double> data(static_cast<int>(this->m_arenaLength));
+  std::copy(this->dataPointer(), this->dataPointer() + this->m_arenaLength,
+            data.begin());
+  return data;
+}
+
+//...Times are sorted, so the window [startDate, endDate] is found by
+//   binary search and costs the same regardless of the series length
+HmdfStation::Window HmdfStation::window(qint64 startDate,
+                                        qint64 endDate) const {
+  this->useData();
+  Window w;
+  w.m_station = this;
+  w.m_first = this->lowerBound(startDate);
+  w.m_size = std::max(this->upperBound(endDate), w.m_first) - w.m_first;
+  w.m_date = this->m_compactDate ? nullptr : this->datePointer() + w.m_first;
+  w.m_data =
+      this->m_singlePrecision ? nullptr : this->dataPointer() + w.m_first;
+  return w;
+}
+
+//...Index of the first time not before date
+size_t HmdfStation::lowerBound(qint64 date) const {
+  this->useData();
+  size_t lo = 0;
+  size_t hi = this->numSnaps();
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (this->dateAt(mid) < date)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+//...Index of the first time after date
+size_t HmdfStation::upperBound(qint64 date) const {
+  this->useData();
+  size_t lo = 0;
+  size_t hi = this->numSnaps();
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (this->dateAt(mid) <= date)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
 
 void HmdfStation::setLatitude(const double latitude) {
   this->m_coordinate.setLatitude(latitude);
@@ -130,34 +342,77 @@ void HmdfStation::setCoordinate(const QGeoCoordinate coordinate) {
 
 QGeoCoordinate *HmdfStation::coordinate() { return &this->m_coordinate; }
 
+//...Bounds are computed in one pass and kept until the series changes.
+//   Null values are left out of the value bounds
 void HmdfStation::dataBounds(qint64 &minDate, qint64 &maxDate, double &minValue,
-                             double &maxValue) {
-  minDate = *std::min_element(this->m_date.begin(), this->m_date.end());
-  maxDate = *std::max_element(this->m_date.begin(), this->m_date.end());
+                             double &maxValue) const {
+  if (!this->m_boundsValid) {
+    this->useData();
+    this->computeBounds();
+  }
+  minDate = this->m_minDate;
+  maxDate = this->m_maxDate;
+  minValue = this->m_minValue;
+  maxValue = this->m_maxValue;
+  return;
+}
 
-  std::vector<double> sortedData = this->m_data.toStdVector();
-  std::sort(sortedData.begin(), sortedData.end());
+void HmdfStation::invalidateBounds() { this->m_boundsValid = false; }
+
+bool HmdfStation::hasBounds() const { return this->m_boundsValid; }
+
+void HmdfStation::computeBounds() const {
+  const size_t n = this->numSnaps();
+
+  qint64 minDate = std::numeric_limits<qint64>::max();
+  qint64 maxDate = -std::numeric_limits<qint64>::max();
+  if (this->m_compactDate) {
+    //...Only the first and last time of each segment can be a bound
+    for (int s = 0; s < this->m_dateSegments.size(); ++s) {
+      const size_t end = s + 1 < this->m_dateSegments.size()
+                             ? this->m_dateSegments[s + 1].start
+                             : n;
+      const qint64 first = this->m_dateSegments[s].t0;
+      const qint64 last =
+          first + (end - 1 - this->m_dateSegments[s].start) * this->m_interval;
+      minDate = std::min(minDate, first);
+      maxDate = std::max(maxDate, last);
+    }
+  } else {
+    dateKernel(this->datePointer(), n, minDate, maxDate);
+  }
 
-  if (sortedData.front() != sortedData.back()) {
-    minValue = *std::upper_bound(sortedData.begin(), sortedData.end(),
-                                 this->nullDataValue());
+  double minValue = std::numeric_limits<double>::max();
+  double maxValue = -std::numeric_limits<double>::max();
+  if (this->m_singlePrecision) {
+    valueKernel(this->m_dataFloat.constData(), n, this->m_nullValue,
+                minValue, maxValue);
   } else {
-    minValue = sortedData.front();
+    valueKernel(this->dataPointer(), n, this->m_nullValue, minValue,
+                maxValue);
   }
-  maxValue = sortedData.back();
 
-  return;
+  //...A series with no valid values reports the null value for both
+  if (minValue > maxValue) {
+    minValue = HmdfStation::nullDataValue();
+    maxValue = HmdfStation::nullDataValue();
+  }
+
+  this->m_minDate = minDate;
+  this->m_maxDate = maxDate;
+  this->m_minValue = minValue;
+  this->m_maxValue = maxValue;
+  this->m_boundsValid = true;
 }
 
 double HmdfStation::nullValue() const { return this->m_nullValue; }
 
 void HmdfStation::setNullValue(double nullValue) {
+  this->invalidateBounds();
   this->m_nullValue = nullValue;
 }
 
-int HmdfStation::applyDatumCorrection(Station s, Datum::VDatum datum) {
-  if (datum == Datum::VDatum::NullDatum) return 0;
-
+double HmdfStation::datumOffset(Station s, Datum::VDatum datum) {
   double shift = 0.0;
   if (datum == Datum::VDatum::MLLW)
     shift = s.mllwOffset();
@@ -173,12 +428,265 @@ int HmdfStation::applyDatumCorrection(Station s, Datum::VDatum datum) {
     shift = s.ngvd29Offset();
   else if (datum == Datum::VDatum::NAVD88)
     shift = s.navd88Offset();
+  return shift;
+}
+
+int HmdfStation::applyDatumCorrection(Station s, Datum::VDatum datum) {
+  if (datum == Datum::VDatum::NullDatum) return 0;
 
+  double shift = HmdfStation::datumOffset(s, datum);
   if (s.isNullOffset(shift)) return 1;
 
-  for (auto &d : this->m_data) {
-    d += shift;
+  this->detachCache();
+  this->invalidateBounds();
+  if (this->m_singlePrecision) {
+    for (auto &d : this->m_dataFloat) {
+      d = static_cast<float>(d + shift);
+    }
+    return 0;
+  }
+
+  double *data = this->mutableDataPointer();
+  const size_t n = this->numSnaps();
+  for (size_t i = 0; i < n; ++i) {
+    data[i] += shift;
   }
 
   return 0;
 }
+
+void HmdfStation::setCache(QSharedPointer<HmdfStationCache> cache,
+                           int cacheIndex) {
+  if (!this->m_cache.isNull()) this->m_cache->release(this);
+  this->m_cache = cache;
+  this->m_cacheIndex = cacheIndex;
+  this->m_arena.clear();
+  this->m_date.clear();
+  this->m_data.clear();
+  this->m_compactDate = false;
+  this->m_dateSegments.clear();
+  this->m_singlePrecision = false;
+  this->m_dataFloat.clear();
+  this->invalidateBounds();
+  this->m_loaded = cache.isNull();
+}
+
+bool HmdfStation::isLoaded() const {
+  if (this->m_cache.isNull()) return true;
+  return this->m_cache->isResident(this);
+}
+
+bool HmdfStation::isLazy() const { return !this->m_cache.isNull(); }
+
+//...Pulls the series of a lazily loaded station into memory
+void HmdfStation::useData() const {
+  if (this->m_cache.isNull()) return;
+  this->m_cache->use(const_cast<HmdfStation *>(this));
+}
+
+//...Before a lazily loaded station is modified it is read in full and
+//   taken out of the cache so the edit can't be evicted
+void HmdfStation::detachCache() {
+  if (this->m_cache.isNull()) return;
+  this->useData();
+  this->m_cache->release(this);
+  this->m_cache.clear();
+  this->m_loaded = true;
+}
+
+void HmdfStation::setArena(QSharedPointer<HmdfArena> arena, int column) {
+  this->detachCache();
+  this->invalidateBounds();
+  this->m_arena = arena;
+  this->m_arenaOffset = arena->column(column).offset;
+  this->m_arenaLength = arena->column(column).length;
+  this->m_date.clear();
+  this->m_data.clear();
+  this->m_compactDate = false;
+  this->m_dateSegments.clear();
+  this->m_singlePrecision = false;
+  this->m_dataFloat.clear();
+}
+
+HmdfArena *HmdfStation::arena() const { return this->m_arena.data(); }
+
+size_t HmdfStation::arenaOffset() const { return this->m_arenaOffset; }
+
+const qint64 *HmdfStation::datePointer() const {
+  if (this->m_arena.isNull()) return this->m_date.constData();
+  return this->m_arena->date() + this->m_arenaOffset;
+}
+
+const double *HmdfStation::dataPointer() const {
+  if (this->m_arena.isNull()) return this->m_data.constData();
+  return this->m_arena->data() + this->m_arenaOffset;
+}
+
+//...Edits that keep the length are written in place, into the arena when
+//   the station is a column of one
+qint64 *HmdfStation::mutableDatePointer() {
+  if (this->m_arena.isNull()) return this->m_date.data();
+  return this->m_arena->date() + this->m_arenaOffset;
+}
+
+double *HmdfStation::mutableDataPointer() {
+  if (this->m_arena.isNull()) return this->m_data.data();
+  return this->m_arena->data() + this->m_arenaOffset;
+}
+
+//...Edits that change the length need the station to own its series.
+//   Compact times are already owned
+void HmdfStation::detachArena() {
+  if (this->m_arena.isNull()) return;
+  const int n = static_cast<int>(this->m_arenaLength);
+  if (!this->m_compactDate) {
+    this->m_date.resize(n);
+    std::copy(this->datePointer(), this->datePointer() + n,
+              this->m_date.begin());
+  }
+  this->m_data.resize(n);
+  std::copy(this->dataPointer(), this->dataPointer() + n,
+            this->m_data.begin());
+  this->m_arena.clear();
+  this->m_arenaOffset = 0;
+  this->m_arenaLength = 0;
+}
+
+bool HmdfStation::isCompactDate() const { return this->m_compactDate; }
+
+bool HmdfStation::singlePrecision() const { return this->m_singlePrecision; }
+
+//...Values are held as float when enabled, halving their memory at the
+//   cost of precision. Lazily loaded stations are left to the cache. A
+//   station in an arena converts its column directly and leaves the arena,
+//   so the arena can be freed once no station uses it
+void HmdfStation::setSinglePrecision(bool singlePrecision) {
+  if (singlePrecision == this->m_singlePrecision) return;
+  if (!this->m_cache.isNull()) return;
+  this->invalidateBounds();
+  if (singlePrecision && !this->m_arena.isNull()) {
+    const int n = static_cast<int>(this->m_arenaLength);
+    if (!this->m_compactDate) {
+      this->m_date.resize(n);
+      std::copy(this->datePointer(), this->datePointer() + n,
+                this->m_date.begin());
+    }
+    const double *data = this->dataPointer();
+    this->m_dataFloat.resize(n);
+    for (int i = 0; i < n; ++i) {
+      this->m_dataFloat[i] = static_cast<float>(data[i]);
+    }
+    this->m_arena.clear();
+    this->m_arenaOffset = 0;
+    this->m_arenaLength = 0;
+    this->m_singlePrecision = true;
+    return;
+  }
+  this->detachArena();
+  if (singlePrecision) {
+    this->m_dataFloat.resize(this->m_data.size());
+    for (int i = 0; i < this->m_data.size(); ++i) {
+      this->m_dataFloat[i] = static_cast<float>(this->m_data[i]);
+    }
+    this->m_data = QVector<double>();
+  } else {
+    this->m_data.resize(this->m_dataFloat.size());
+    for (int i = 0; i < this->m_dataFloat.size(); ++i) {
+      this->m_data[i] = static_cast<double>(this->m_dataFloat[i]);
+    }
+    this->m_dataFloat = QVector<float>();
+  }
+  this->m_singlePrecision = singlePrecision;
+}
+
+//...Moves the series into the smallest storage that holds it. A series on
+//   a regular interval keeps only the start time and interval, plus one
+//   entry for each gap, instead of a time per value. Series with too many
+//   gaps to benefit keep their times as they are. The check runs on the
+//   times where they are, so a station in an arena stays there; its time
+//   column is freed by Hmdf::compact once the whole arena is compact
+void HmdfStation::compact(bool singlePrecision) {
+  if (!this->m_cache.isNull()) return;
+  this->compactDate();
+  if (singlePrecision) this->setSinglePrecision(true);
+}
+
+void HmdfStation::compactDate() {
+  const size_t n = this->numSnaps();
+  if (this->m_compactDate || n < 2) return;
+
+  const qint64 *date = this->datePointer();
+  const qint64 interval = date[1] - date[0];
+  if (interval <= 0) return;
+
+  //...Each segment costs about as much as two stored times
+  const size_t maxSegments = n / 4;
+
+  QVector<DateSegment> segments;
+  DateSegment segment;
+  segment.start = 0;
+  segment.t0 = date[0];
+  segments.push_back(segment);
+  for (size_t i = 1; i < n; ++i) {
+    if (date[i] - date[i - 1] != interval) {
+      segment.start = static_cast<int>(i);
+      segment.t0 = date[i];
+      segments.push_back(segment);
+      if (static_cast<size_t>(segments.size()) > maxSegments) return;
+    }
+  }
+
+  this->m_interval = interval;
+  this->m_dateSegments = segments;
+  this->m_compactDate = true;
+  this->m_date = QVector<qint64>();
+}
+
+qint64 HmdfStation::dateAt(size_t index) const {
+  if (!this->m_compactDate) return this->datePointer()[index];
+  if (this->m_dateSegments.size() == 1)
+    return this->m_dateSegments[0].t0 +
+           static_cast<qint64>(index) * this->m_interval;
+  auto segment = std::upper_bound(
+      this->m_dateSegments.begin(), this->m_dateSegments.end(),
+      static_cast<int>(index),
+      [](int i, const DateSegment &s) { return i < s.start; });
+  --segment;
+  return segment->t0 +
+         (static_cast<int>(index) - segment->start) * this->m_interval;
+}
+
+double HmdfStation::dataAt(size_t index) const {
+  if (this->m_singlePrecision)
+    return static_cast<double>(this->m_dataFloat[index]);
+  return this->dataPointer()[index];
+}
+
+void HmdfStation::fillCompactDate(qint64 *date, size_t n) const {
+  for (int s = 0; s < this->m_dateSegments.size(); ++s) {
+    const DateSegment &segment = this->m_dateSegments[s];
+    const size_t end = s + 1 < this->m_dateSegments.size()
+                           ? this->m_dateSegments[s + 1].start
+                           : n;
+    qint64 t = segment.t0;
+    for (size_t i = segment.start; i < end; ++i) {
+      date[i] = t;
+      t += this->m_interval;
+    }
+  }
+}
+
+//...Edits to a single time that break the interval bring back the full
+//   time vector, in the arena column when the station still has one. If
+//   the arena has freed its times the station takes its series out first
+void HmdfStation::expandDate() {
+  if (!this->m_compactDate) return;
+  if (!this->m_arena.isNull() && !this->m_arena->hasDate())
+    this->detachArena();
+  const size_t n = this->numSnaps();
+  if (this->m_arena.isNull()) this->m_date.resize(static_cast<int>(n));
+  this->fillCompactDate(this->mutableDatePointer(), n);
+  this->m_compactDate = false;
+  this->m_interval = 0;
+  this->m_dateSegments.clear();
+}
@@ -22,9 +22,13 @@
 
 #include <QGeoCoordinate>
 #include <QObject>
+#include <QSharedPointer>
 #include <QString>
 #include <QVector>
+#include <cmath>
 #include "datum.h"
+#include "hmdfarena.h"
+#include "hmdfstationcache.h"
 #include "metocean_global.h"
 #include "station.h"
 
@@ -34,6 +38,39 @@ class HmdfStation : public QObject {
  public:
   explicit HmdfStation(QObject *parent = nullptr);
 
+  //...A contiguous run of the series, located without copying. The
+  //   pointers are null when the series is held in compact storage. A
+  //   window is valid until the station is modified or, for lazily loaded
+  //   stations, until another station of the file is read
+  class Window {
+   public:
+    size_t size() const { return this->m_size; }
+    bool isEmpty() const { return this->m_size == 0; }
+    size_t first() const { return this->m_first; }
+
+    qint64 date(size_t index) const {
+      return this->m_date ? this->m_date[index]
+                          : this->m_station->dateAt(this->m_first + index);
+    }
+    double data(size_t index) const {
+      return this->m_data ? this->m_data[index]
+                          : this->m_station->dataAt(this->m_first + index);
+    }
+
+    const qint64 *datePointer() const { return this->m_date; }
+    const double *dataPointer() const { return this->m_data; }
+
+   private:
+    friend class HmdfStation;
+    const HmdfStation *m_station;
+    const qint64 *m_date;
+    const double *m_data;
+    size_t m_first;
+    size_t m_size;
+  };
+
+  ~HmdfStation();
+
   void clear();
 
   static constexpr double nullDataValue() {
@@ -44,6 +81,13 @@ class HmdfStation : public QObject {
     return -std::numeric_limits<qint64>::max();
   }
 
+  //...Values within a small tolerance of a station's null value are
+  //   treated as null wherever a series is read
+  static bool isNullValue(double value, double nullValue) {
+    return value == HmdfStation::nullDataValue() ||
+           std::abs(value - nullValue) <= 0.0001;
+  }
+
   QGeoCoordinate *coordinate();
   void setCoordinate(const QGeoCoordinate coordinate);
 
@@ -81,15 +125,87 @@ class HmdfStation : public QObject {
   QVector<qint64> allDate() const;
   QVector<double> allData() const;
 
+  Window window(qint64 startDate, qint64 endDate) const;
+  size_t lowerBound(qint64 date) const;
+  size_t upperBound(qint64 date) const;
+
   void dataBounds(qint64 &minDate, qint64 &maxDate, double &minValue,
-                  double &maxValue);
+                  double &maxValue) const;
+  void invalidateBounds();
+  bool hasBounds() const;
 
   double nullValue() const;
   void setNullValue(double nullValue);
 
   int applyDatumCorrection(Station s, Datum::VDatum datum);
+  static double datumOffset(Station s, Datum::VDatum datum);
+
+  void setArena(QSharedPointer<HmdfArena> arena, int column);
+  HmdfArena *arena() const;
+  size_t arenaOffset() const;
+
+  void setCache(QSharedPointer<HmdfStationCache> cache, int cacheIndex);
+  bool isLoaded() const;
+  bool isLazy() const;
+
+  void compact(bool singlePrecision = false);
+  bool isCompactDate() const;
+
+  bool singlePrecision() const;
+  void setSinglePrecision(bool singlePrecision);
 
  private:
+  friend class HmdfStationCache;
+
+  void useData() const;
+  void detachCache();
+  void detachArena();
+
+  const qint64 *datePointer() const;
+  const double *dataPointer() const;
+  qint64 *mutableDatePointer();
+  double *mutableDataPointer();
+
+  qint64 dateAt(size_t index) const;
+  double dataAt(size_t index) const;
+  void compactDate();
+  void fillCompactDate(qint64 *date, size_t n) const;
+  void expandDate();
+  void computeBounds() const;
+
+  mutable bool m_boundsValid;
+  mutable qint64 m_minDate;
+  mutable qint64 m_maxDate;
+  mutable double m_minValue;
+  mutable double m_maxValue;
+
+  //...Times of a compact series: a run of values on the interval starting
+  //   at index start with time t0
+  struct DateSegment {
+    int start;
+    qint64 t0;
+  };
+
+  bool m_compactDate;
+  qint64 m_interval;
+  QVector<DateSegment> m_dateSegments;
+
+  bool m_singlePrecision;
+  QVector<float> m_dataFloat;
+
+  QSharedPointer<HmdfArena> m_arena;
+  size_t m_arenaOffset;
+  size_t m_arenaLength;
+
+  QSharedPointer<HmdfStationCache> m_cache;
+  int m_cacheIndex;
+
+  //...Residency and the links of the cache's recency list, guarded by the
+  //   cache mutex
+  bool m_loaded;
+  HmdfStation *m_lruPrev;
+  HmdfStation *m_lruNext;
+
   QGeoCoordinate m_coordinate;
 
   QString m_name;
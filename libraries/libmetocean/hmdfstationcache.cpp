@@ -0,0 +1,131 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#include "hmdfstationcache.h"
+#include "hmdfstation.h"
+
+HmdfStationCache::HmdfStationCache(size_t maxBytes)
+    : m_newest(nullptr),
+      m_oldest(nullptr),
+      m_maxBytes(maxBytes),
+      m_usedBytes(0) {}
+
+HmdfStationCache::~HmdfStationCache() {}
+
+size_t HmdfStationCache::maxBytes() const {
+  QMutexLocker lock(&this->m_mutex);
+  return this->m_maxBytes;
+}
+
+void HmdfStationCache::setMaxBytes(size_t maxBytes) {
+  QMutexLocker lock(&this->m_mutex);
+  this->m_maxBytes = maxBytes;
+  this->evict(0);
+}
+
+size_t HmdfStationCache::usedBytes() const {
+  QMutexLocker lock(&this->m_mutex);
+  return this->m_usedBytes;
+}
+
+size_t HmdfStationCache::stationBytes(const HmdfStation *station) {
+  return station->m_date.size() * sizeof(qint64) +
+         station->m_data.size() * sizeof(double);
+}
+
+void HmdfStationCache::use(HmdfStation *station) {
+  QMutexLocker lock(&this->m_mutex);
+  if (station->m_loaded) {
+    //...Resident stations move to the front of the recency list
+    if (station != this->m_newest) {
+      this->unlink(station);
+      this->link(station);
+    }
+    return;
+  }
+
+  QVector<qint64> date;
+  QVector<double> data;
+  if (this->fetch(station->m_cacheIndex, date, data) != 0 ||
+      date.size() != data.size()) {
+    date.clear();
+    data.clear();
+  }
+
+  this->evict(date.size() * sizeof(qint64) + data.size() * sizeof(double));
+
+  station->m_date = date;
+  station->m_data = data;
+  station->m_loaded = true;
+  this->link(station);
+  this->m_usedBytes += HmdfStationCache::stationBytes(station);
+}
+
+void HmdfStationCache::release(HmdfStation *station) {
+  QMutexLocker lock(&this->m_mutex);
+  if (!station->m_loaded) return;
+  this->m_usedBytes -= HmdfStationCache::stationBytes(station);
+  this->unlink(station);
+}
+
+bool HmdfStationCache::isResident(const HmdfStation *station) {
+  QMutexLocker lock(&this->m_mutex);
+  return station->m_loaded;
+}
+
+//...Length of a station's series, known from the file without reading it
+size_t HmdfStationCache::length(const HmdfStation *station) {
+  QMutexLocker lock(&this->m_mutex);
+  if (station->m_loaded) return station->m_data.size();
+  return this->stationLength(station->m_cacheIndex);
+}
+
+//...Drops the least recently used stations, from the back of the list
+void HmdfStationCache::evict(size_t incomingBytes) {
+  while (this->m_oldest != nullptr &&
+         this->m_usedBytes + incomingBytes > this->m_maxBytes) {
+    HmdfStation *station = this->m_oldest;
+    this->m_usedBytes -= HmdfStationCache::stationBytes(station);
+    this->unlink(station);
+    station->m_date = QVector<qint64>();
+    station->m_data = QVector<double>();
+    station->m_loaded = false;
+  }
+}
+
+void HmdfStationCache::link(HmdfStation *station) {
+  station->m_lruPrev = nullptr;
+  station->m_lruNext = this->m_newest;
+  if (this->m_newest != nullptr) this->m_newest->m_lruPrev = station;
+  this->m_newest = station;
+  if (this->m_oldest == nullptr) this->m_oldest = station;
+}
+
+void HmdfStationCache::unlink(HmdfStation *station) {
+  if (station->m_lruPrev != nullptr)
+    station->m_lruPrev->m_lruNext = station->m_lruNext;
+  else
+    this->m_newest = station->m_lruNext;
+  if (station->m_lruNext != nullptr)
+    station->m_lruNext->m_lruPrev = station->m_lruPrev;
+  else
+    this->m_oldest = station->m_lruPrev;
+  station->m_lruPrev = nullptr;
+  station->m_lruNext = nullptr;
+}
@@ -0,0 +1,70 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#ifndef HMDFSTATIONCACHE_H
+#define HMDFSTATIONCACHE_H
+
+#include <QMutex>
+#include <QVector>
+#include "metocean_global.h"
+
+class HmdfStation;
+
+//...Holds the time series of lazily loaded stations in memory up to a
+//   byte budget. Stations are fetched from the backing file the first
+//   time their data is touched, and the least recently used stations are
+//   dropped when the budget is exceeded. Residency of the stations and
+//   the recency list are only touched under the cache mutex, so stations
+//   of one file can be read from several threads
+class HmdfStationCache {
+ public:
+  explicit HmdfStationCache(size_t maxBytes = defaultMaxBytes());
+  virtual ~HmdfStationCache();
+
+  static constexpr size_t defaultMaxBytes() { return 256 * 1024 * 1024; }
+
+  size_t maxBytes() const;
+  void setMaxBytes(size_t maxBytes);
+
+  size_t usedBytes() const;
+
+  void use(HmdfStation *station);
+  void release(HmdfStation *station);
+  bool isResident(const HmdfStation *station);
+  size_t length(const HmdfStation *station);
+
+ protected:
+  virtual int fetch(int index, QVector<qint64> &date,
+                    QVector<double> &data) = 0;
+  virtual size_t stationLength(int index) const = 0;
+
+ private:
+  static size_t stationBytes(const HmdfStation *station);
+  void evict(size_t incomingBytes);
+  void link(HmdfStation *station);
+  void unlink(HmdfStation *station);
+
+  mutable QMutex m_mutex;
+  HmdfStation *m_newest;
+  HmdfStation *m_oldest;
+  size_t m_maxBytes;
+  size_t m_usedBytes;
+};
+
+#endif  // HMDFSTATIONCACHE_H
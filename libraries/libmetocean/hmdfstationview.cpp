@@ -0,0 +1,103 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#include "hmdfstationview.h"
+
+HmdfStationView::HmdfStationView(const HmdfStation *station,
+                                 const HmdfTransform &transform)
+    : m_station(station), m_transform(transform) {}
+
+const HmdfStation *HmdfStationView::station() const { return this->m_station; }
+
+void HmdfStationView::setStation(const HmdfStation *station) {
+  this->m_station = station;
+}
+
+HmdfTransform HmdfStationView::transform() const { return this->m_transform; }
+
+void HmdfStationView::setTransform(const HmdfTransform &transform) {
+  this->m_transform = transform;
+}
+
+HmdfStationView HmdfStationView::then(const HmdfTransform &transform) const {
+  return HmdfStationView(this->m_station, this->m_transform.then(transform));
+}
+
+size_t HmdfStationView::numSnaps() const { return this->m_station->numSnaps(); }
+
+bool HmdfStationView::isNull(size_t index) const {
+  return this->isNullValue(this->m_station->data(index));
+}
+
+qint64 HmdfStationView::date(size_t index) const {
+  return this->m_transform.date(this->m_station->date(index));
+}
+
+double HmdfStationView::data(size_t index) const {
+  const double value = this->m_station->data(index);
+  return this->isNullValue(value) ? value : this->m_transform.value(value);
+}
+
+//...Transformed samples with a (transformed) time in [startDate, endDate],
+//   null values left out. The window is located by binary search and
+//   filled in one pass. Returns the number of samples
+size_t HmdfStationView::series(qint64 startDate, qint64 endDate,
+                               QVector<qint64> &date,
+                               QVector<double> &data) const {
+  const qint64 shift = this->m_transform.timeShift();
+  HmdfStation::Window w =
+      this->m_station->window(startDate - shift, endDate - shift);
+
+  date.resize(static_cast<int>(w.size()));
+  data.resize(static_cast<int>(w.size()));
+  qint64 *t = date.data();
+  double *v = data.data();
+
+  size_t k = 0;
+  if (w.datePointer() != nullptr && w.dataPointer() != nullptr) {
+    const qint64 *wt = w.datePointer();
+    const double *wv = w.dataPointer();
+    for (size_t i = 0; i < w.size(); ++i) {
+      t[k] = wt[i] + shift;
+      v[k] = this->m_transform.value(wv[i]);
+      k += this->isNullValue(wv[i]) ? 0 : 1;
+    }
+  } else {
+    for (size_t i = 0; i < w.size(); ++i) {
+      const double value = w.data(i);
+      t[k] = w.date(i) + shift;
+      v[k] = this->m_transform.value(value);
+      k += this->isNullValue(value) ? 0 : 1;
+    }
+  }
+
+  date.resize(static_cast<int>(k));
+  data.resize(static_cast<int>(k));
+  return k;
+}
+
+void HmdfStationView::dataBounds(qint64 &minDate, qint64 &maxDate,
+                                 double &minValue, double &maxValue) const {
+  this->m_station->dataBounds(minDate, maxDate, minValue, maxValue);
+  this->m_transform.applyBounds(minDate, maxDate, minValue, maxValue);
+}
+
+bool HmdfStationView::isNullValue(double value) const {
+  return HmdfStation::isNullValue(value, this->m_station->nullValue());
+}
@@ -0,0 +1,62 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#ifndef HMDFSTATIONVIEW_H
+#define HMDFSTATIONVIEW_H
+
+#include <QVector>
+#include "hmdfstation.h"
+#include "hmdftransform.h"
+
+//...Read only view of a station with a transform applied on the fly. The
+//   station's data is neither copied nor modified, so changing the
+//   transform only means reading the view again
+class HmdfStationView {
+ public:
+  explicit HmdfStationView(const HmdfStation *station = nullptr,
+                           const HmdfTransform &transform = HmdfTransform());
+
+  const HmdfStation *station() const;
+  void setStation(const HmdfStation *station);
+
+  HmdfTransform transform() const;
+  void setTransform(const HmdfTransform &transform);
+
+  HmdfStationView then(const HmdfTransform &transform) const;
+
+  size_t numSnaps() const;
+
+  bool isNull(size_t index) const;
+  qint64 date(size_t index) const;
+  double data(size_t index) const;
+
+  size_t series(qint64 startDate, qint64 endDate, QVector<qint64> &date,
+                QVector<double> &data) const;
+
+  void dataBounds(qint64 &minDate, qint64 &maxDate, double &minValue,
+                  double &maxValue) const;
+
+ private:
+  bool isNullValue(double value) const;
+
+  const HmdfStation *m_station;
+  HmdfTransform m_transform;
+};
+
+#endif  // HMDFSTATIONVIEW_H
@@ -0,0 +1,111 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#include "hmdftransform.h"
+#include <algorithm>
+#include "hmdfstation.h"
+
+HmdfTransform::HmdfTransform()
+    : m_scale(1.0), m_offset(0.0), m_datumOffset(0.0), m_timeShift(0) {
+  this->update();
+}
+
+HmdfTransform::HmdfTransform(double scale, double offset, qint64 timeShift)
+    : m_scale(scale),
+      m_offset(offset),
+      m_datumOffset(0.0),
+      m_timeShift(timeShift) {
+  this->update();
+}
+
+double HmdfTransform::scale() const { return this->m_scale; }
+
+void HmdfTransform::setScale(double scale) {
+  this->m_scale = scale;
+  this->update();
+}
+
+double HmdfTransform::offset() const { return this->m_offset; }
+
+void HmdfTransform::setOffset(double offset) {
+  this->m_offset = offset;
+  this->update();
+}
+
+qint64 HmdfTransform::timeShift() const { return this->m_timeShift; }
+
+void HmdfTransform::setTimeShift(qint64 timeShift) {
+  this->m_timeShift = timeShift;
+}
+
+double HmdfTransform::datumOffset() const { return this->m_datumOffset; }
+
+void HmdfTransform::setDatumOffset(double datumOffset) {
+  this->m_datumOffset = datumOffset;
+  this->update();
+}
+
+bool HmdfTransform::isIdentity() const {
+  return this->m_scale == 1.0 && this->m_intercept == 0.0 &&
+         this->m_timeShift == 0;
+}
+
+//...The transform that applies this one followed by next
+HmdfTransform HmdfTransform::then(const HmdfTransform &next) const {
+  HmdfTransform t;
+  t.m_datumOffset = this->m_datumOffset;
+  t.m_scale = this->m_scale * next.m_scale;
+  t.m_offset = (this->m_offset + next.m_datumOffset) * next.m_scale +
+               next.m_offset;
+  t.m_timeShift = this->m_timeShift + next.m_timeShift;
+  t.update();
+  return t;
+}
+
+//...Single fused pass over both arrays. The null test is a select rather
+//   than a branch so the loop vectorizes
+void HmdfTransform::apply(qint64 *date, double *data, size_t n,
+                          double nullValue) const {
+  if (this->isIdentity()) return;
+  const qint64 shift = this->m_timeShift;
+  const double a = this->m_scale;
+  const double b = this->m_intercept;
+  for (size_t i = 0; i < n; ++i) {
+    const double v = data[i];
+    const bool isNull = HmdfStation::isNullValue(v, nullValue);
+    data[i] = isNull ? v : v * a + b;
+    date[i] += shift;
+  }
+}
+
+//...Bounds of the transformed series. A negative scale swaps the value
+//   bounds
+void HmdfTransform::applyBounds(qint64 &minDate, qint64 &maxDate,
+                                double &minValue, double &maxValue) const {
+  minDate = this->date(minDate);
+  maxDate = this->date(maxDate);
+  if (minValue == HmdfStation::nullDataValue()) return;
+  minValue = this->value(minValue);
+  maxValue = this->value(maxValue);
+  if (minValue > maxValue) std::swap(minValue, maxValue);
+}
+
+void HmdfTransform::update() {
+  this->m_intercept = this->m_datumOffset * this->m_scale + this->m_offset;
+}
@@ -0,0 +1,73 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#ifndef HMDFTRANSFORM_H
+#define HMDFTRANSFORM_H
+
+#include <QtGlobal>
+#include <cstddef>
+
+//...A recorded change to a series, applied when the series is read rather
+//   than to the stored data. Values become
+//   (value + datumOffset) * scale + offset and times are moved by
+//   timeShift milliseconds. Null values are passed through unchanged
+class HmdfTransform {
+ public:
+  HmdfTransform();
+  HmdfTransform(double scale, double offset, qint64 timeShift = 0);
+
+  double scale() const;
+  void setScale(double scale);
+
+  double offset() const;
+  void setOffset(double offset);
+
+  qint64 timeShift() const;
+  void setTimeShift(qint64 timeShift);
+
+  double datumOffset() const;
+  void setDatumOffset(double datumOffset);
+
+  bool isIdentity() const;
+
+  HmdfTransform then(const HmdfTransform &next) const;
+
+  qint64 date(qint64 date) const { return date + this->m_timeShift; }
+  double value(double value) const {
+    return value * this->m_scale + this->m_intercept;
+  }
+
+  void apply(qint64 *date, double *data, size_t n, double nullValue) const;
+
+  void applyBounds(qint64 &minDate, qint64 &maxDate, double &minValue,
+                   double &maxValue) const;
+
+ private:
+  void update();
+
+  double m_scale;
+  double m_offset;
+  double m_datumOffset;
+  qint64 m_timeShift;
+
+  //...Constant term of the combined affine map
+  double m_intercept;
+};
+
+#endif  // HMDFTRANSFORM_H
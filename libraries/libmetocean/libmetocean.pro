@@ -18,7 +18,7 @@
 #
 #-----------------------------------------------------------------------#
 
-QT       += network positioning
+QT       += network positioning concurrent
 
 TARGET = metocean
 TEMPLATE = lib
@@ -43,9 +43,14 @@ INCLUDEPATH += $$PWD/../../thirdparty/boost_1_67_0
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += hmdfasciiparser.cpp  \
+           hmdfasciiformatter.cpp \
            crmsdata.cpp \
            hmdf.cpp  \
            hmdfstation.cpp  \
+           hmdfstationcache.cpp \
+           hmdfarena.cpp \
+           hmdftransform.cpp \
+           hmdfstationview.cpp \
            netcdftimeseries.cpp  \
            noaacoops.cpp  \
            stringutil.cpp  \
@@ -58,16 +63,23 @@ SOURCES += hmdfasciiparser.cpp  \
            tideprediction.cpp \
            ndbcdata.cpp \
            stationlocations.cpp \
+           stationcatalog.cpp \
+           stationtree.cpp \
            generic.cpp \
            constants.cpp \
            highwatermarks.cpp \
            hwmdata.cpp
 
 HEADERS += hmdfasciiparser.h  \
+           hmdfasciiformatter.h \
            crmsdata.h \
            datum.h \
            hmdf.h  \
            hmdfstation.h  \
+           hmdfstationcache.h \
+           hmdfarena.h \
+           hmdftransform.h \
+           hmdfstationview.h \
            netcdftimeseries.h  \
            noaacoops.h  \
            stringutil.h  \
@@ -81,6 +93,8 @@ HEADERS += hmdfasciiparser.h  \
            tideprediction.h \
            ndbcdata.h \
            stationlocations.h \
+           stationcatalog.h \
+           stationtree.h \
            metocean_global.h \
            generic.h \
            constants.h \
@@ -108,4 +122,24 @@ else:unix: PRE_TARGETDEPS += $$OUT_PWD/../libtide/libtide.a
 RESOURCES += \
     resource_files.qrc
 
+#...The station lists are compiled into the station catalog table by
+#   mkstationcatalog, which is built before this library
+win32:CONFIG(release, debug|release): MKSTATIONCATALOG = $$OUT_PWD/../mkstationcatalog/release/mkstationcatalog.exe
+else:win32:CONFIG(debug, debug|release): MKSTATIONCATALOG = $$OUT_PWD/../mkstationcatalog/debug/mkstationcatalog.exe
+else: MKSTATIONCATALOG = $$OUT_PWD/../mkstationcatalog/mkstationcatalog
+
+STATION_LISTS = $$PWD/data/noaa_stations.csv \
+                $$PWD/data/usgs_stations.csv \
+                $$PWD/data/xtide_stations.csv \
+                $$PWD/data/ndbc_stations.csv \
+                $$PWD/data/crms_stations.csv
+
+stationcatalog.input = STATION_LISTS
+stationcatalog.output = $$OUT_PWD/stationcatalogdata.cpp
+stationcatalog.commands = $$shell_path($$MKSTATIONCATALOG) $$STATION_LISTS ${QMAKE_FILE_OUT}
+stationcatalog.depends = $$MKSTATIONCATALOG
+stationcatalog.CONFIG += combine
+stationcatalog.variable_out = SOURCES
+QMAKE_EXTRA_COMPILERS += stationcatalog
+
 unix|win32: LIBS += -lnetcdf
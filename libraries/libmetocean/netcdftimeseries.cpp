@@ -33,6 +33,23 @@ NetcdfTimeseries::NetcdfTimeseries(QObject *parent) : QObject(parent) {
   this->m_verticalDatum = "unknown";
   this->m_horizontalProjection = "WGS84";
   this->m_numStations = 0;
+  this->m_ncid = -1;
+  this->m_raggedArray = false;
+  this->m_lazy = false;
+}
+
+NetcdfTimeseries::~NetcdfTimeseries() {
+  QMutexLocker lock(NetcdfTimeseries::mutex());
+  if (this->m_ncid != -1) nc_close(this->m_ncid);
+}
+
+//...The netCDF library isn't thread safe, so every reader in the process,
+//   here or in the application, serializes on this one lock. It is
+//   recursive so a loader holding it may close or fetch through objects
+//   that take it themselves
+QMutex *NetcdfTimeseries::mutex() {
+  static QMutex s_netcdfMutex(QMutex::Recursive);
+  return &s_netcdfMutex;
 }
 
 QString NetcdfTimeseries::filename() const { return this->m_filename; }
@@ -46,18 +63,47 @@ int NetcdfTimeseries::epsg() const { return this->m_epsg; }
 void NetcdfTimeseries::setEpsg(int epsg) { this->m_epsg = epsg; }
 
 int NetcdfTimeseries::read() {
+  QMutexLocker lock(NetcdfTimeseries::mutex());
+  int ierr = this->readStationInfo();
+  if (ierr != NC_NOERR) return ierr;
+
+  //...Every station is a column of one arena, filled in place
+  this->m_arena.reset(new HmdfArena(this->m_stationLength));
+
+  if (this->m_raggedArray) {
+    ierr = this->readRaggedArray();
+  } else {
+    for (size_t i = 0; i < this->m_numStations && ierr == NC_NOERR; i++) {
+      ierr = this->fetchColumn(i, this->m_arena->date(i),
+                               this->m_arena->data(i));
+    }
+  }
+
+  nc_close(this->m_ncid);
+  this->m_ncid = -1;
+
+  return ierr;
+}
+
+int NetcdfTimeseries::readLazy() {
+  QMutexLocker lock(NetcdfTimeseries::mutex());
+  int ierr = this->readStationInfo();
+  if (ierr != NC_NOERR) return ierr;
+  this->m_lazy = true;
+  return NC_NOERR;
+}
+
+//...Reads the station names, locations and the information needed to
+//   locate each station's series. The file is left open on success
+int NetcdfTimeseries::readStationInfo() {
   if (this->m_filename == QString()) return 1;
 
-  QDateTime refTime;
-  refTime.setTimeSpec(Qt::UTC);
-  QString station_dim_string, station_time_var_string, station_data_var_string,
-      stationNameString;
-  size_t stationNameLength, length;
+  QString stationNameString;
+  size_t stationNameLength;
   int ierr, ncid;
-  int dimid_nstations, dimidStationLength, dimid_stationNameLen;
-  int varid_time, varid_data, varid_xcoor, varid_ycoor, varid_stationName;
+  int dimid_nstations, dimid_stationNameLen;
+  int varid_xcoor, varid_ycoor, varid_stationName;
   int epsg;
-  char timeChar[80];
 
   NCCHECK(nc_open(this->m_filename.toStdString().c_str(), NC_NOWRITE, &ncid));
   NCCHECK(nc_inq_dimid(ncid, "numStations", &dimid_nstations));
@@ -101,7 +147,8 @@ int NetcdfTimeseries::read() {
   char *stationName = new char[stationNameLength * this->m_numStations];
 
   NCCHECK(nc_get_var_text(ncid, varid_stationName, stationName));
-  stationNameString = QString(stationName);
+  stationNameString =
+      QString::fromLatin1(stationName, stationNameLength * this->m_numStations);
 
   delete[] stationName;
 
@@ -110,70 +157,183 @@ int NetcdfTimeseries::read() {
         stationNameString.mid(200 * i, 200).simplified());
   }
 
-  this->m_time.resize(this->m_numStations);
-  this->m_data.resize(this->m_numStations);
+  //...Files written with the CF contiguous ragged array layout carry a
+  //   row_size variable instead of one dimension per station
+  int varid_rowSize;
+  this->m_raggedArray =
+      nc_inq_varid(ncid, "row_size", &varid_rowSize) == NC_NOERR;
 
-  for (size_t i = 0; i < this->m_numStations; i++) {
-    station_dim_string.sprintf("stationLength_%4.4d", i + 1);
-    station_time_var_string.sprintf("time_station_%4.4d", i + 1);
-    station_data_var_string.sprintf("data_station_%4.4d", i + 1);
+  if (this->m_raggedArray) {
+    int varid_time, varid_data, dimid_obs;
+    size_t nobs;
+    qint64 refTime;
+    double fillValue;
 
-    NCCHECK(nc_inq_dimid(ncid, station_dim_string.toStdString().c_str(),
-                         &dimidStationLength));
+    NCCHECK(nc_inq_varid(ncid, "time", &varid_time));
+    NCCHECK(nc_inq_varid(ncid, "data", &varid_data));
+    NCCHECK(nc_inq_vardimid(ncid, varid_time, &dimid_obs));
+    NCCHECK(nc_inq_dimlen(ncid, dimid_obs, &nobs));
+    NCCHECK(this->referenceTime(ncid, varid_time, refTime));
+    NCCHECK(nc_inq_var_fill(ncid, varid_data, NULL, &fillValue));
+    if (fillValue == NC_FILL_DOUBLE) fillValue = -99999.0;
 
-    NCCHECK(nc_inq_dimlen(ncid, dimidStationLength, &length));
-    this->m_stationLength.push_back(length);
+    std::vector<long long> rowSize(this->m_numStations);
+    if (this->m_numStations > 0) {
+      NCCHECK(nc_get_var_longlong(ncid, varid_rowSize, rowSize.data()));
+    }
 
-    NCCHECK(nc_inq_varid(ncid, station_time_var_string.toStdString().c_str(),
-                         &varid_time));
+    size_t offset = 0;
+    for (size_t i = 0; i < this->m_numStations; i++) {
+      size_t length = static_cast<size_t>(rowSize[i]);
+      if (rowSize[i] < 0 || offset + length > nobs) {
+        nc_close(ncid);
+        return NC_EEDGE;
+      }
+      this->m_stationOffset.push_back(offset);
+      this->m_stationLength.push_back(length);
+      this->m_varidTime.push_back(varid_time);
+      this->m_varidData.push_back(varid_data);
+      this->m_refTime.push_back(refTime);
+      this->m_fillValue.push_back(fillValue);
+      offset += length;
+    }
+  } else {
+    QString station_dim_string, station_time_var_string,
+        station_data_var_string;
+    size_t length;
+    int dimidStationLength, varid_time, varid_data;
+    qint64 refTime;
+    double fillValue;
 
-    NCCHECK(nc_inq_varid(ncid, station_data_var_string.toStdString().c_str(),
-                         &varid_data));
+    for (size_t i = 0; i < this->m_numStations; i++) {
+      station_dim_string.sprintf("stationLength_%4.4d", i + 1);
+      station_time_var_string.sprintf("time_station_%4.4d", i + 1);
+      station_data_var_string.sprintf("data_station_%4.4d", i + 1);
+
+      NCCHECK(nc_inq_dimid(ncid, station_dim_string.toStdString().c_str(),
+                           &dimidStationLength));
+      NCCHECK(nc_inq_dimlen(ncid, dimidStationLength, &length));
+      NCCHECK(nc_inq_varid(ncid, station_time_var_string.toStdString().c_str(),
+                           &varid_time));
+      NCCHECK(nc_inq_varid(ncid, station_data_var_string.toStdString().c_str(),
+                           &varid_data));
+      NCCHECK(this->referenceTime(ncid, varid_time, refTime));
+      NCCHECK(nc_inq_var_fill(ncid, varid_data, NULL, &fillValue));
+      if (fillValue == NC_FILL_DOUBLE) fillValue = -99999.0;
+
+      this->m_stationOffset.push_back(0);
+      this->m_stationLength.push_back(length);
+      this->m_varidTime.push_back(varid_time);
+      this->m_varidData.push_back(varid_data);
+      this->m_refTime.push_back(refTime);
+      this->m_fillValue.push_back(fillValue);
+    }
+  }
 
-    NCCHECK(nc_get_att_text(ncid, varid_time, "referenceDate", timeChar));
-    QString timeString = QString(timeChar).mid(0, 19);
-    refTime = QDateTime::fromString(timeString, "yyyy-MM-dd hh:mm:ss");
-    refTime.setTimeSpec(Qt::UTC);
+  this->m_ncid = ncid;
 
-    double fillValue;
-    NCCHECK(nc_inq_var_fill(ncid, varid_data, NULL, &fillValue));
-    if (fillValue == NC_FILL_DOUBLE) fillValue = -99999.0;
-    this->m_fillValue.push_back(fillValue);
+  return NC_NOERR;
+}
 
-    qint64 *timeData = new qint64[length];
-    double *varData = new double[length];
+//...Reference time of a station time variable in ms since the epoch.
+//   Does not close the file on error, the caller is responsible for that
+int NetcdfTimeseries::referenceTime(int ncid, int varid_time,
+                                    qint64 &refTime) {
+  size_t length;
+  int ierr = nc_inq_attlen(ncid, varid_time, "referenceDate", &length);
+  if (ierr != NC_NOERR) return ierr;
+
+  std::vector<char> timeChar(length + 1, 0);
+  ierr = nc_get_att_text(ncid, varid_time, "referenceDate", timeChar.data());
+  if (ierr != NC_NOERR) return ierr;
+
+  QString timeString = QString(timeChar.data()).mid(0, 19);
+  QDateTime ref = QDateTime::fromString(timeString, "yyyy-MM-dd hh:mm:ss");
+  ref.setTimeSpec(Qt::UTC);
+  refTime = ref.toMSecsSinceEpoch();
+  return NC_NOERR;
+}
 
-    ierr = nc_get_var_double(ncid, varid_data, varData);
-    if (ierr != NC_NOERR) {
-      delete[] timeData;
-      delete[] varData;
-      nc_close(ncid);
-      return ierr;
-    }
+//...Reads one station's series. For ragged array files this is a single
+//   hyperslab of the shared time and data variables
+int NetcdfTimeseries::fetch(int index, QVector<qint64> &date,
+                            QVector<double> &data) {
+  if (this->m_ncid == -1) return 1;
+  size_t length = this->m_stationLength[index];
+  date.resize(length);
+  data.resize(length);
+  return this->fetchColumn(index, date.data(), data.data());
+}
 
-    ierr = nc_get_var_longlong(ncid, varid_time, timeData);
-    if (ierr != NC_NOERR) {
-      delete[] timeData;
-      delete[] varData;
-      nc_close(ncid);
-      return ierr;
-    }
+size_t NetcdfTimeseries::stationLength(int index) const {
+  if (index < 0 || index >= this->m_stationLength.size()) return 0;
+  return this->m_stationLength[index];
+}
+
+//...Reads one station's series into caller sized buffers. Lazy fetches
+//   arrive from whichever thread touches the station, so the library lock
+//   is taken here rather than left to the caller
+int NetcdfTimeseries::fetchColumn(int index, qint64 *date, double *data) {
+  QMutexLocker lock(NetcdfTimeseries::mutex());
+  if (this->m_ncid == -1) return 1;
+
+  size_t length = this->m_stationLength[index];
+  if (length == 0) return NC_NOERR;
+
+  int ierr;
+  if (this->m_raggedArray) {
+    size_t start[1] = {this->m_stationOffset[index]};
+    size_t count[1] = {length};
+    ierr = nc_get_vara_longlong(this->m_ncid, this->m_varidTime[index], start,
+                                count, date);
+    if (ierr != NC_NOERR) return ierr;
+    ierr = nc_get_vara_double(this->m_ncid, this->m_varidData[index], start,
+                              count, data);
+    if (ierr != NC_NOERR) return ierr;
+  } else {
+    ierr = nc_get_var_longlong(this->m_ncid, this->m_varidTime[index], date);
+    if (ierr != NC_NOERR) return ierr;
+    ierr = nc_get_var_double(this->m_ncid, this->m_varidData[index], data);
+    if (ierr != NC_NOERR) return ierr;
+  }
+
+  const qint64 refTime = this->m_refTime[index];
+  for (size_t i = 0; i < length; i++) {
+    date[i] = refTime + date[i] * 1000;
+  }
+
+  return NC_NOERR;
+}
 
-    this->m_data[i].resize(length);
-    this->m_time[i].resize(length);
+//...Two bulk reads: the row sizes are already known and the arena columns
+//   are laid out in the same order as the file, so the time and data
+//   variables are read straight into the arena and the times converted
+//   in place
+int NetcdfTimeseries::readRaggedArray() {
+  if (this->m_arena->size() == 0 || this->m_numStations == 0)
+    return NC_NOERR;
+
+  //...The observation dimension may be longer than the sum of the row
+  //   sizes, so only the leading part is read
+  size_t start[1] = {0};
+  size_t count[1] = {this->m_arena->size()};
+  int ierr = nc_get_vara_longlong(this->m_ncid, this->m_varidTime[0], start,
+                                  count, this->m_arena->date());
+  if (ierr != NC_NOERR) return ierr;
+  ierr = nc_get_vara_double(this->m_ncid, this->m_varidData[0], start, count,
+                            this->m_arena->data());
+  if (ierr != NC_NOERR) return ierr;
 
+  for (size_t i = 0; i < this->m_numStations; i++) {
+    qint64 *time = this->m_arena->date(i);
+    const size_t length = this->m_arena->column(i).length;
+    const qint64 refTime = this->m_refTime[i];
     for (size_t j = 0; j < length; j++) {
-      this->m_data[i][j] = varData[j];
-      this->m_time[i][j] = refTime.addSecs(timeData[j]).toMSecsSinceEpoch();
+      time[j] = refTime + time[j] * 1000;
     }
-
-    delete[] timeData;
-    delete[] varData;
   }
 
-  NCCHECK(nc_close(ncid));
-
-  return 0;
+  return NC_NOERR;
 }
 
 int NetcdfTimeseries::toHmdf(Hmdf *hmdf) {
@@ -183,10 +343,21 @@ int NetcdfTimeseries::toHmdf(Hmdf *hmdf) {
   hmdf->setHeader3("none");
   hmdf->setSuccess(false);
 
+  //...Lazily read stations share ownership of this object, which serves
+  //   their series on demand
+  QSharedPointer<HmdfStationCache> cache;
+  if (this->m_lazy) {
+    cache = this->sharedFromThis();
+    if (cache.isNull()) return 1;
+  }
+
   for (size_t i = 0; i < this->m_numStations; i++) {
     HmdfStation *station = new HmdfStation(hmdf);
-    station->setDate(this->m_time[i]);
-    station->setData(this->m_data[i]);
+    if (this->m_lazy) {
+      station->setCache(cache, i);
+    } else {
+      station->setArena(this->m_arena, i);
+    }
     station->setLatitude(this->m_ycoor[i]);
     station->setLongitude(this->m_xcoor[i]);
     station->setName(this->m_stationName[i]);
@@ -195,6 +366,7 @@ int NetcdfTimeseries::toHmdf(Hmdf *hmdf) {
     station->setNullValue(this->m_fillValue[i]);
     hmdf->addStation(station);
   }
+  if (!this->m_lazy) hmdf->setArena(this->m_arena);
 
   hmdf->setSuccess(true);
 
@@ -202,6 +374,7 @@ int NetcdfTimeseries::toHmdf(Hmdf *hmdf) {
 }
 
 int NetcdfTimeseries::getEpsg(QString file) {
+  QMutexLocker lock(NetcdfTimeseries::mutex());
   int ncid, varid_xcoor, epsg;
   NCCHECK(nc_open(file.toStdString().c_str(), NC_NOWRITE, &ncid));
   NCCHECK(nc_inq_varid(ncid, "stationXCoordinate", &varid_xcoor));
@@ -21,18 +21,28 @@
 #define NETCDFTIMESERIES_H
 
 #include <QDateTime>
+#include <QMutex>
 #include <QObject>
+#include <QSharedPointer>
 #include <QVector>
+#include <vector>
 #include "hmdf.h"
+#include "hmdfstationcache.h"
 #include "metocean_global.h"
 
-class NetcdfTimeseries : public QObject {
+class NetcdfTimeseries : public QObject,
+                         public HmdfStationCache,
+                         public QEnableSharedFromThis<NetcdfTimeseries> {
   Q_OBJECT
  public:
   explicit NetcdfTimeseries(QObject *parent = nullptr);
 
+  ~NetcdfTimeseries();
+
   int read();
 
+  int readLazy();
+
   int toHmdf(Hmdf *hmdf);
 
   QString filename() const;
@@ -43,21 +53,38 @@ class NetcdfTimeseries : public QObject {
 
   static int getEpsg(QString file);
 
+  static QMutex *mutex();
+
+protected:
+  int fetch(int index, QVector<qint64> &date, QVector<double> &data) override;
+  size_t stationLength(int index) const override;
+
 private:
+  int readStationInfo();
+  int readRaggedArray();
+  int fetchColumn(int index, qint64 *date, double *data);
+  int referenceTime(int ncid, int varid_time, qint64 &refTime);
+
   QString m_filename;
   QString m_units;
   QString m_verticalDatum;
   QString m_horizontalProjection;
   int m_epsg;
+  int m_ncid;
+  bool m_raggedArray;
+  bool m_lazy;
   size_t m_numStations;
 
   QVector<double> m_fillValue;
   QVector<double> m_xcoor;
   QVector<double> m_ycoor;
   QVector<size_t> m_stationLength;
+  QVector<size_t> m_stationOffset;
+  QVector<int> m_varidTime;
+  QVector<int> m_varidData;
+  QVector<qint64> m_refTime;
   QVector<QString> m_stationName;
-  QVector<QVector<qint64> > m_time;
-  QVector<QVector<double> > m_data;
+  QSharedPointer<HmdfArena> m_arena;
 };
 
 #endif  // NETCDFTIMESERIES_H
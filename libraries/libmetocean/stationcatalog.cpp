@@ -0,0 +1,208 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#include "stationcatalog.h"
+#include <algorithm>
+#include <cstring>
+#include "station.h"
+
+//...Generated by mkstationcatalog from the csv files in data/
+extern const unsigned char stationCatalogData[];
+extern const std::size_t stationCatalogSize;
+
+//...Columns are used in place, so the table has to match the host
+Q_STATIC_ASSERT_X(Q_BYTE_ORDER == Q_LITTLE_ENDIAN,
+                  "The station catalog is stored little endian");
+Q_STATIC_ASSERT(sizeof(StationCatalog::StringRef) == 8);
+Q_STATIC_ASSERT(sizeof(StationCatalog::TableHeader) == 44);
+Q_STATIC_ASSERT(sizeof(StationCatalog::Header) == 244);
+
+static const char c_catalogMagic[8] = {'M', 'O', 'V', 'S', 'T', 'C', 'A', 'T'};
+
+StationCatalog::StationCatalog()
+    : m_data(stationCatalogData), m_size(stationCatalogSize) {
+  this->m_valid = this->validate();
+}
+
+//...Function local statics are initialized once and thread safe in C++11
+const StationCatalog &StationCatalog::instance() {
+  static StationCatalog catalog;
+  return catalog;
+}
+
+bool StationCatalog::isValid() const { return this->m_valid; }
+
+bool StationCatalog::validate() const {
+  if (this->m_size < sizeof(Header)) return false;
+  if (reinterpret_cast<quintptr>(this->m_data) % 8 != 0) return false;
+
+  const Header *header = reinterpret_cast<const Header *>(this->m_data);
+  if (std::memcmp(header->magic, c_catalogMagic, sizeof(c_catalogMagic)) != 0)
+    return false;
+  if (header->version != StationCatalog::formatVersion()) return false;
+  if (header->nTables != NumTypes) return false;
+  if (static_cast<size_t>(header->strings) +
+          2 * static_cast<size_t>(header->stringsLength) >
+      this->m_size)
+    return false;
+
+  auto fits = [this](quint32 offset, size_t count, size_t bytes) {
+    return offset == 0 ||
+           static_cast<size_t>(offset) + count * bytes <= this->m_size;
+  };
+
+  for (int i = 0; i < NumTypes; ++i) {
+    const TableHeader &t = header->tables[i];
+    if (t.count == 0) continue;
+    if (t.latitude == 0 || t.longitude == 0 || t.id == 0 || t.name == 0 ||
+        t.byId == 0)
+      return false;
+    if ((t.flags & HasDates) &&
+        (t.startDate == 0 || t.endDate == 0 || t.active == 0))
+      return false;
+    if ((t.flags & HasOffsets) && t.offsets == 0) return false;
+    if (!fits(t.latitude, t.count, sizeof(double)) ||
+        !fits(t.longitude, t.count, sizeof(double)) ||
+        !fits(t.id, t.count, sizeof(StringRef)) ||
+        !fits(t.name, t.count, sizeof(StringRef)) ||
+        !fits(t.byId, t.count, sizeof(quint32)) ||
+        !fits(t.startDate, t.count, sizeof(qint64)) ||
+        !fits(t.endDate, t.count, sizeof(qint64)) ||
+        !fits(t.active, t.count, sizeof(quint8)) ||
+        !fits(t.offsets, t.count * NumDatums, sizeof(double)))
+      return false;
+  }
+  return true;
+}
+
+StationCatalog::View StationCatalog::view(Type type) const {
+  if (!this->m_valid || type < 0 || type >= NumTypes) return View();
+  const Header *header = reinterpret_cast<const Header *>(this->m_data);
+  return View(this->m_data, &header->tables[type]);
+}
+
+StationCatalog::View::View() : m_data(nullptr), m_table(nullptr) {}
+
+StationCatalog::View::View(const uchar *data, const TableHeader *table)
+    : m_data(data), m_table(table) {}
+
+int StationCatalog::View::size() const {
+  return this->m_table ? static_cast<int>(this->m_table->count) : 0;
+}
+
+bool StationCatalog::View::isEmpty() const { return this->size() == 0; }
+
+double StationCatalog::View::latitude(int index) const {
+  return this->column<double>(this->m_table->latitude)[index];
+}
+
+double StationCatalog::View::longitude(int index) const {
+  return this->column<double>(this->m_table->longitude)[index];
+}
+
+QGeoCoordinate StationCatalog::View::coordinate(int index) const {
+  return QGeoCoordinate(this->latitude(index), this->longitude(index));
+}
+
+//...Strings point into the compiled table, which lives as long as the
+//   process, so they are never copied
+QString StationCatalog::View::string(const StringRef &ref) const {
+  const Header *header = reinterpret_cast<const Header *>(this->m_data);
+  const QChar *pool =
+      reinterpret_cast<const QChar *>(this->m_data + header->strings);
+  return QString::fromRawData(pool + ref.offset,
+                              static_cast<int>(ref.length));
+}
+
+QString StationCatalog::View::id(int index) const {
+  return this->string(this->column<StringRef>(this->m_table->id)[index]);
+}
+
+QString StationCatalog::View::name(int index) const {
+  return this->string(this->column<StringRef>(this->m_table->name)[index]);
+}
+
+bool StationCatalog::View::active(int index) const {
+  if (this->m_table->active == 0) return true;
+  return this->column<quint8>(this->m_table->active)[index] != 0;
+}
+
+QDateTime StationCatalog::View::date(quint32 column, int index) const {
+  qint64 msec = this->column<qint64>(column)[index];
+  if (msec == StationCatalog::invalidDate()) return QDateTime();
+  return QDateTime::fromMSecsSinceEpoch(msec, Qt::UTC);
+}
+
+QDateTime StationCatalog::View::startDate(int index) const {
+  if (this->m_table->startDate == 0) return QDateTime();
+  return this->date(this->m_table->startDate, index);
+}
+
+QDateTime StationCatalog::View::endDate(int index) const {
+  if (this->m_table->endDate == 0) return QDateTime();
+  return this->date(this->m_table->endDate, index);
+}
+
+double StationCatalog::View::offset(int index, Datum datum) const {
+  if (this->m_table->offsets == 0) return Station::nullOffset();
+  return this->column<double>(
+      this->m_table->offsets)[datum * this->m_table->count + index];
+}
+
+//...Binary search of the id column, returns -1 if the id is not listed
+int StationCatalog::View::indexOf(const QString &id) const {
+  if (this->isEmpty()) return -1;
+  const quint32 *first = this->column<quint32>(this->m_table->byId);
+  const quint32 *last = first + this->m_table->count;
+  const quint32 *it =
+      std::lower_bound(first, last, id, [this](quint32 row, const QString &s) {
+        return this->id(static_cast<int>(row)) < s;
+      });
+  if (it == last || this->id(static_cast<int>(*it)) != id) return -1;
+  return static_cast<int>(*it);
+}
+
+Station StationCatalog::View::station(int index) const {
+  Station s;
+  if (this->m_table->flags & HasDates) {
+    s = Station(this->coordinate(index), this->id(index), this->name(index), 0,
+                0, 0, this->active(index), this->startDate(index),
+                this->endDate(index));
+  } else {
+    s = Station(this->coordinate(index), this->id(index), this->name(index));
+  }
+
+  if (this->m_table->flags & HasOffsets) {
+    s.setMllwOffset(this->offset(index, MLLW));
+    s.setMlwOffset(this->offset(index, MLW));
+    s.setMslOffset(this->offset(index, MSL));
+    s.setMhwOffset(this->offset(index, MHW));
+    s.setMhhwOffset(this->offset(index, MHHW));
+    s.setNgvd29Offset(this->offset(index, NGVD29));
+    s.setNavd88Offset(this->offset(index, NAVD88));
+  }
+  return s;
+}
+
+QVector<Station> StationCatalog::View::stations() const {
+  QVector<Station> output;
+  output.reserve(this->size());
+  for (int i = 0; i < this->size(); ++i) output.push_back(this->station(i));
+  return output;
+}
@@ -0,0 +1,133 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#ifndef STATIONCATALOG_H
+#define STATIONCATALOG_H
+
+#include <QDateTime>
+#include <QGeoCoordinate>
+#include <QString>
+#include <QVector>
+#include <limits>
+#include "metocean_global.h"
+
+class Station;
+
+//...Station lists compiled into the library at build time by
+//   mkstationcatalog. The table is a column store: every station list has
+//   its own coordinate, id, name, date and datum offset columns, and all
+//   strings share one UTF-16 pool. The catalog is checked once per process
+//   on first use, and views read the columns and strings in place without
+//   parsing or copying
+class StationCatalog {
+ public:
+  enum Type { NOAA, USGS, XTIDE, NDBC, CRMS, NumTypes };
+  enum Datum { MLLW, MLW, MSL, MHW, MHHW, NGVD29, NAVD88, NumDatums };
+  enum Flags { HasDates = 0x1, HasOffsets = 0x2 };
+
+  //...On disk layout. Column offsets are in bytes from the start of the
+  //   table and are 8 byte aligned, and a zero offset marks a column that
+  //   is not present. byId holds the rows sorted by id
+  struct StringRef {
+    quint32 offset;
+    quint32 length;
+  };
+
+  struct TableHeader {
+    quint32 count;
+    quint32 flags;
+    quint32 latitude;
+    quint32 longitude;
+    quint32 id;
+    quint32 name;
+    quint32 byId;
+    quint32 startDate;
+    quint32 endDate;
+    quint32 active;
+    quint32 offsets;
+  };
+
+  struct Header {
+    char magic[8];
+    quint32 version;
+    quint32 strings;
+    quint32 stringsLength;
+    quint32 nTables;
+    TableHeader tables[NumTypes];
+  };
+
+  static constexpr quint32 formatVersion() { return 1; }
+  static constexpr qint64 invalidDate() {
+    return std::numeric_limits<qint64>::min();
+  }
+
+  class View {
+   public:
+    View();
+
+    int size() const;
+    bool isEmpty() const;
+
+    double latitude(int index) const;
+    double longitude(int index) const;
+    QGeoCoordinate coordinate(int index) const;
+    QString id(int index) const;
+    QString name(int index) const;
+    bool active(int index) const;
+    QDateTime startDate(int index) const;
+    QDateTime endDate(int index) const;
+    double offset(int index, Datum datum) const;
+
+    int indexOf(const QString &id) const;
+
+    Station station(int index) const;
+    QVector<Station> stations() const;
+
+   private:
+    friend class StationCatalog;
+    View(const uchar *data, const TableHeader *table);
+
+    template <typename T>
+    const T *column(quint32 offset) const {
+      return reinterpret_cast<const T *>(this->m_data + offset);
+    }
+    QString string(const StringRef &ref) const;
+    QDateTime date(quint32 column, int index) const;
+
+    const uchar *m_data;
+    const TableHeader *m_table;
+  };
+
+  static const StationCatalog &instance();
+
+  bool isValid() const;
+  View view(Type type) const;
+
+ private:
+  StationCatalog();
+  Q_DISABLE_COPY(StationCatalog)
+
+  bool validate() const;
+
+  const uchar *m_data;
+  size_t m_size;
+  bool m_valid;
+};
+
+#endif  // STATIONCATALOG_H
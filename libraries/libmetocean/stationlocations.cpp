@@ -18,210 +18,46 @@
 //
 //-----------------------------------------------------------------------*/
 #include "stationlocations.h"
-#include <QFile>
+#include <QMap>
+#include <QMutex>
 #include "generic.h"
 
 StationLocations::StationLocations(QObject *parent) : QObject(parent) {}
 
+//...Station lists other than CRMS never change while the program runs, so
+//   each one is built from the catalog once and shared by every caller
+static QMutex s_markerCacheMutex;
+static QMap<StationLocations::MarkerType, QVector<Station>> s_markerCache;
+
 QVector<Station> StationLocations::readMarkers(
     StationLocations::MarkerType markerType) {
+  if (markerType == CRMS) return StationLocations::readCrmsMarkers();
+
+  QMutexLocker lock(&s_markerCacheMutex);
+  QMap<MarkerType, QVector<Station>>::const_iterator it =
+      s_markerCache.constFind(markerType);
+  if (it == s_markerCache.constEnd())
+    it = s_markerCache.insert(markerType,
+                              StationLocations::catalog(markerType).stations());
+  return it.value();
+}
+
+StationCatalog::View StationLocations::catalog(
+    StationLocations::MarkerType markerType) {
+  const StationCatalog &catalog = StationCatalog::instance();
   if (markerType == NOAA) {
-    return StationLocations::readNoaaMarkers();
+    return catalog.view(StationCatalog::NOAA);
   } else if (markerType == USGS) {
-    return StationLocations::readUsgsMarkers();
+    return catalog.view(StationCatalog::USGS);
   } else if (markerType == XTIDE) {
-    return StationLocations::readXtideMarkers();
+    return catalog.view(StationCatalog::XTIDE);
   } else if (markerType == NDBC) {
-    return StationLocations::readNdbcMarkers();
+    return catalog.view(StationCatalog::NDBC);
   } else if (markerType == CRMS) {
-    return StationLocations::readCrmsMarkers();
+    return catalog.view(StationCatalog::CRMS);
   } else {
-    QVector<Station> output;
-    return output;
-  }
-}
-
-QVector<Station> StationLocations::readNoaaMarkers() {
-  QVector<Station> output;
-
-  QFile stationFile(":/stations/data/noaa_stations.csv");
-
-  if (!stationFile.open(QIODevice::ReadOnly)) return output;
-
-  while (!stationFile.atEnd()) {
-    QString line = stationFile.readLine().simplified();
-    QStringList list = line.split(";");
-    QString id = list.value(0);
-    QString name = list.value(1);
-    name = name.simplified();
-    QString temp = list.value(3);
-    double lat = temp.toDouble();
-    temp = list.value(2);
-    double lon = temp.toDouble();
-
-    QString startDateString = list.value(4).simplified();
-    QString endDateString = list.value(5).simplified();
-    QDateTime startDate =
-        QDateTime::fromString(startDateString, "MMM dd, yyyy");
-    startDate.setTimeSpec(Qt::UTC);
-    QDateTime endDate;
-    if (endDateString == "present")
-      endDate = QDateTime(QDate(2050, 1, 1), QTime(0, 0, 0));
-    else
-      endDate = QDateTime::fromString(endDateString, "MMM dd, yyyy");
-    endDate.setTimeSpec(Qt::UTC);
-
-    if (startDate.isValid() || endDate.isValid()) {
-      Station s = Station();
-      if (endDateString == "present") {
-        s = Station(QGeoCoordinate(lat, lon), id, name, 0, 0, 0, true,
-                    startDate, endDate);
-      } else {
-        s = Station(QGeoCoordinate(lat, lon), id, name, 0, 0, 0, false,
-                    startDate, endDate);
-      }
-      double mllw = list.value(6).toDouble();
-      double mlw = list.value(7).toDouble();
-      double mhw = list.value(9).toDouble();
-      double mhhw = list.value(10).toDouble();
-      double ngvd = list.value(11).toDouble();
-      double navd = list.value(12).toDouble();
-
-      if (mlw < -900.0) mlw = s.nullOffset();
-      if (mllw < -900.0) mllw = s.nullOffset();
-      if (mhw < -900.0) mhw = s.nullOffset();
-      if (mhhw < -900.0) mhhw = s.nullOffset();
-      if (ngvd < -900.0) ngvd = s.nullOffset();
-      if (navd < -900.0) navd = s.nullOffset();
-
-      s.setMllwOffset(mllw);
-      s.setMlwOffset(mlw);
-      s.setMslOffset(0.0);
-      s.setMhwOffset(mhw);
-      s.setMhhwOffset(mhhw);
-      s.setNgvd29Offset(ngvd);
-      s.setNavd88Offset(navd);
-
-      output.push_back(s);
-    }
-  }
-
-  stationFile.close();
-
-  return output;
-}
-
-QVector<Station> StationLocations::readUsgsMarkers() {
-  QVector<Station> output;
-
-  QFile stationFile(":/stations/data/usgs_stations.csv");
-
-  if (!stationFile.open(QIODevice::ReadOnly)) return output;
-
-  int index = 0;
-
-  while (!stationFile.atEnd()) {
-    QString line = stationFile.readLine().simplified();
-    index++;
-    if (index > 1) {
-      QStringList list = line.split(";");
-      QString id = list.value(0);
-      QString name = list.value(1);
-      name = name.simplified();
-      QString temp = list.value(2);
-      double lat = temp.toDouble();
-      temp = list.value(3);
-      double lon = temp.toDouble();
-      Station s = Station(QGeoCoordinate(lat, lon), id, name);
-      output.push_back(s);
-    }
+    return StationCatalog::View();
   }
-
-  stationFile.close();
-
-  return output;
-}
-
-QVector<Station> StationLocations::readXtideMarkers() {
-  QVector<Station> output;
-  QFile stationFile(":/stations/data/xtide_stations.csv");
-
-  if (!stationFile.open(QIODevice::ReadOnly)) return output;
-
-  int index = 0;
-
-  while (!stationFile.atEnd()) {
-    QString line = stationFile.readLine().simplified();
-    index++;
-    if (index > 1) {
-      QStringList list = line.split(";");
-      QString id = list.value(3);
-      QString name = list.value(4);
-      name = name.simplified();
-      QString temp = list.value(0);
-      double lat = temp.toDouble();
-      temp = list.value(1);
-      double lon = temp.toDouble();
-      Station s = Station(QGeoCoordinate(lat, lon), id, name);
-
-      double mlw = list.value(6).toDouble();
-      double msl = list.value(7).toDouble();
-      double mhw = list.value(8).toDouble();
-      double mhhw = list.value(9).toDouble();
-      double ngvd = list.value(10).toDouble();
-      double navd = list.value(11).toDouble();
-
-      if (mlw < -900.0) mlw = s.nullOffset();
-      if (msl < -900.0) msl = s.nullOffset();
-      if (mhw < -900.0) mhw = s.nullOffset();
-      if (mhhw < -900.0) mhhw = s.nullOffset();
-      if (ngvd < -900.0) ngvd = s.nullOffset();
-      if (navd < -900.0) navd = s.nullOffset();
-
-      s.setMllwOffset(0.0);
-      s.setMlwOffset(mlw);
-      s.setMslOffset(msl);
-      s.setMhwOffset(mhw);
-      s.setMhhwOffset(mhhw);
-      s.setNgvd29Offset(ngvd);
-      s.setNavd88Offset(navd);
-
-      output.push_back(s);
-    }
-  }
-
-  stationFile.close();
-
-  return output;
-}
-
-QVector<Station> StationLocations::readNdbcMarkers() {
-  QVector<Station> output;
-  QFile stationFile(":/stations/data/ndbc_stations.csv");
-
-  if (!stationFile.open(QIODevice::ReadOnly)) return output;
-
-  int index = 0;
-
-  while (!stationFile.atEnd()) {
-    QString line = stationFile.readLine().simplified();
-    index++;
-    if (index > 1) {
-      QStringList list = line.split(",");
-      QString id = list.value(0).simplified();
-      QString name = "NDBC_" + id;
-      QString temp = list.value(1);
-      double lon = temp.toDouble();
-      temp = list.value(2);
-      double lat = temp.toDouble();
-      Station s = Station(QGeoCoordinate(lat, lon), id, name);
-      output.push_back(s);
-    }
-  }
-
-  stationFile.close();
-
-  return output;
 }
 
 QVector<Station> StationLocations::readCrmsMarkers() {
@@ -25,6 +25,7 @@
 #include "crmsdata.h"
 #include "metocean_global.h"
 #include "station.h"
+#include "stationcatalog.h"
 
 class StationLocations : public QObject {
   Q_OBJECT
@@ -34,12 +35,9 @@ class StationLocations : public QObject {
   enum MarkerType { NOAA, USGS, XTIDE, NDBC, CRMS };
 
   static QVector<Station> readMarkers(MarkerType markerType);
+  static StationCatalog::View catalog(MarkerType markerType);
 
  private:
-  static QVector<Station> readNoaaMarkers();
-  static QVector<Station> readUsgsMarkers();
-  static QVector<Station> readXtideMarkers();
-  static QVector<Station> readNdbcMarkers();
   static QVector<Station> readCrmsMarkers();
 };
 
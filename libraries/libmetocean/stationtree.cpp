@@ -0,0 +1,207 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#include "stationtree.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "constants.h"
+
+StationTree::StationTree(const StationCatalog::View &stations)
+    : m_stations(stations) {
+  this->m_points.resize(stations.size());
+  this->m_split.resize(stations.size());
+  for (int i = 0; i < stations.size(); ++i) {
+    StationTree::toSphere(stations.longitude(i), stations.latitude(i),
+                          this->m_points[i].p);
+    this->m_points[i].station = i;
+  }
+  this->build(0, this->m_points.size());
+}
+
+int StationTree::size() const { return this->m_points.size(); }
+
+void StationTree::toSphere(double longitude, double latitude, double p[3]) {
+  double lon = Constants::toRadians(longitude);
+  double lat = Constants::toRadians(latitude);
+  p[0] = std::cos(lat) * std::cos(lon);
+  p[1] = std::cos(lat) * std::sin(lon);
+  p[2] = std::sin(lat);
+}
+
+double StationTree::distance2(const double a[3], const double b[3]) {
+  double dx = a[0] - b[0];
+  double dy = a[1] - b[1];
+  double dz = a[2] - b[2];
+  return dx * dx + dy * dy + dz * dz;
+}
+
+//...The tree is implicit: the median of each range is its node, split
+//   along the axis where the range is widest
+void StationTree::build(int lo, int hi) {
+  if (hi - lo < 2) return;
+
+  double pmin[3], pmax[3];
+  for (int d = 0; d < 3; ++d) {
+    pmin[d] = std::numeric_limits<double>::max();
+    pmax[d] = -std::numeric_limits<double>::max();
+  }
+  for (int i = lo; i < hi; ++i) {
+    for (int d = 0; d < 3; ++d) {
+      pmin[d] = std::min(pmin[d], this->m_points[i].p[d]);
+      pmax[d] = std::max(pmax[d], this->m_points[i].p[d]);
+    }
+  }
+
+  int axis = 0;
+  for (int d = 1; d < 3; ++d) {
+    if (pmax[d] - pmin[d] > pmax[axis] - pmin[axis]) axis = d;
+  }
+
+  int mid = (lo + hi) / 2;
+  std::nth_element(this->m_points.begin() + lo, this->m_points.begin() + mid,
+                   this->m_points.begin() + hi,
+                   [axis](const Point &a, const Point &b) {
+                     return a.p[axis] < b.p[axis];
+                   });
+  this->m_split[mid] = static_cast<quint8>(axis);
+
+  this->build(lo, mid);
+  this->build(mid + 1, hi);
+}
+
+//...heap is a max heap on distance holding the closest count points seen
+void StationTree::searchNearest(int lo, int hi, const double q[3], int count,
+                                QVector<Candidate> &heap) const {
+  if (lo >= hi) return;
+
+  int mid = (lo + hi) / 2;
+  const Point &node = this->m_points[mid];
+  double d2 = StationTree::distance2(node.p, q);
+  if (heap.size() < count) {
+    heap.push_back(Candidate(d2, node.station));
+    std::push_heap(heap.begin(), heap.end());
+  } else if (d2 < heap.front().first) {
+    std::pop_heap(heap.begin(), heap.end());
+    heap.back() = Candidate(d2, node.station);
+    std::push_heap(heap.begin(), heap.end());
+  }
+  if (hi - lo == 1) return;
+
+  double diff = q[this->m_split[mid]] - node.p[this->m_split[mid]];
+  if (diff < 0.0) {
+    this->searchNearest(lo, mid, q, count, heap);
+    if (heap.size() < count || diff * diff < heap.front().first)
+      this->searchNearest(mid + 1, hi, q, count, heap);
+  } else {
+    this->searchNearest(mid + 1, hi, q, count, heap);
+    if (heap.size() < count || diff * diff < heap.front().first)
+      this->searchNearest(lo, mid, q, count, heap);
+  }
+}
+
+void StationTree::searchRadius(int lo, int hi, const double q[3],
+                               double chord2, QVector<int> &stations) const {
+  if (lo >= hi) return;
+
+  int mid = (lo + hi) / 2;
+  const Point &node = this->m_points[mid];
+  if (StationTree::distance2(node.p, q) <= chord2)
+    stations.push_back(node.station);
+  if (hi - lo == 1) return;
+
+  double diff = q[this->m_split[mid]] - node.p[this->m_split[mid]];
+  if (diff < 0.0 || diff * diff <= chord2)
+    this->searchRadius(lo, mid, q, chord2, stations);
+  if (diff >= 0.0 || diff * diff <= chord2)
+    this->searchRadius(mid + 1, hi, q, chord2, stations);
+}
+
+//...Stations within radius meters sorted by their geodesic distance. The
+//   earth radius varies with latitude in Constants::distance, so the tree
+//   is searched with the smallest radius of the earth, which can only
+//   return extra candidates, and those are then measured exactly
+QVector<StationTree::Candidate> StationTree::ranked(double longitude,
+                                                    double latitude,
+                                                    double radius) const {
+  double q[3];
+  StationTree::toSphere(longitude, latitude, q);
+  double angle = std::min(radius / Constants::polarRadius(), Constants::pi());
+  double chord = 2.0 * std::sin(angle / 2.0);
+
+  QVector<int> stations;
+  this->searchRadius(0, this->m_points.size(), q, chord * chord * (1.0 + 1e-9),
+                     stations);
+
+  QVector<Candidate> result;
+  result.reserve(stations.size());
+  for (int i = 0; i < stations.size(); ++i) {
+    double d = Constants::distance(longitude, latitude,
+                                   this->m_stations.longitude(stations[i]),
+                                   this->m_stations.latitude(stations[i]),
+                                   true);
+    if (d <= radius) result.push_back(Candidate(d, stations[i]));
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+int StationTree::nearest(double longitude, double latitude) const {
+  QVector<int> n = this->nearest(longitude, latitude, 1);
+  return n.isEmpty() ? -1 : n.first();
+}
+
+//...The closest count stations on the sphere fix a search radius that is
+//   then ranked by geodesic distance, so the result matches a linear scan
+//   with Constants::distance
+QVector<int> StationTree::nearest(double longitude, double latitude,
+                                  int count) const {
+  QVector<int> output;
+  if (count < 1 || this->m_points.isEmpty()) return output;
+
+  double q[3];
+  StationTree::toSphere(longitude, latitude, q);
+  QVector<Candidate> heap;
+  heap.reserve(count);
+  this->searchNearest(0, this->m_points.size(), q, count, heap);
+
+  double radius = 0.0;
+  for (int i = 0; i < heap.size(); ++i) {
+    radius = std::max(
+        radius, Constants::distance(
+                    longitude, latitude,
+                    this->m_stations.longitude(heap[i].second),
+                    this->m_stations.latitude(heap[i].second), true));
+  }
+
+  QVector<Candidate> candidates = this->ranked(longitude, latitude, radius);
+  for (int i = 0; i < candidates.size() && i < count; ++i)
+    output.push_back(candidates[i].second);
+  return output;
+}
+
+QVector<int> StationTree::withinRadius(double longitude, double latitude,
+                                       double radius) const {
+  QVector<int> output;
+  QVector<Candidate> candidates = this->ranked(longitude, latitude, radius);
+  output.reserve(candidates.size());
+  for (int i = 0; i < candidates.size(); ++i)
+    output.push_back(candidates[i].second);
+  return output;
+}
@@ -0,0 +1,70 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#ifndef STATIONTREE_H
+#define STATIONTREE_H
+
+#include <QPair>
+#include <QVector>
+#include "metocean_global.h"
+#include "stationcatalog.h"
+
+//...k-d tree over the stations of a catalog view for nearest station
+//   searches. Stations are placed on the unit sphere, where the straight
+//   line distance between two points orders them the same way as the
+//   distance along the surface, so the tree needs no special handling of
+//   the dateline or the poles. Results are ranked with the same geodesic
+//   distance used by Constants::distance and are returned as row indices
+//   into the view
+class StationTree {
+ public:
+  explicit StationTree(const StationCatalog::View &stations);
+
+  int size() const;
+
+  int nearest(double longitude, double latitude) const;
+  QVector<int> nearest(double longitude, double latitude, int count) const;
+  QVector<int> withinRadius(double longitude, double latitude,
+                            double radius) const;
+
+ private:
+  struct Point {
+    double p[3];
+    int station;
+  };
+
+  typedef QPair<double, int> Candidate;
+
+  void build(int lo, int hi);
+  void searchNearest(int lo, int hi, const double q[3], int count,
+                     QVector<Candidate> &heap) const;
+  void searchRadius(int lo, int hi, const double q[3], double chord2,
+                    QVector<int> &stations) const;
+  QVector<Candidate> ranked(double longitude, double latitude,
+                            double radius) const;
+
+  static void toSphere(double longitude, double latitude, double p[3]);
+  static double distance2(const double a[3], const double b[3]);
+
+  StationCatalog::View m_stations;
+  QVector<Point> m_points;
+  QVector<quint8> m_split;
+};
+
+#endif  // STATIONTREE_H
@@ -22,6 +22,7 @@ TEMPLATE = subdirs
 
 SUBDIRS  = ../thirdparty/ezproj \
            libtide \
+           mkstationcatalog \
            libmetocean
 
 CONFIG += ordered
@@ -0,0 +1,49 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#include <iostream>
+#include "stationcatalogwriter.h"
+
+int main(int argc, char *argv[]) {
+  if (argc != 7) {
+    std::cerr << "Usage: ./mkstationcatalog [noaa] [usgs] [xtide] [ndbc] "
+                 "[crms] [output]"
+              << std::endl;
+    return 1;
+  }
+
+  const StationCatalog::Type types[] = {
+      StationCatalog::NOAA, StationCatalog::USGS, StationCatalog::XTIDE,
+      StationCatalog::NDBC, StationCatalog::CRMS};
+
+  StationCatalogWriter writer;
+  for (int i = 0; i < StationCatalog::NumTypes; ++i) {
+    if (!writer.read(types[i], QString::fromLocal8Bit(argv[i + 1]))) {
+      std::cerr << "Could not read " << argv[i + 1] << std::endl;
+      return 1;
+    }
+  }
+
+  if (!writer.write(QString::fromLocal8Bit(argv[6]))) {
+    std::cerr << "Could not write " << argv[6] << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
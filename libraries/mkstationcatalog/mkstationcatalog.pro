@@ -0,0 +1,40 @@
+#-------------------------------GPL-------------------------------------#
+#
+# MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+# Copyright (C) 2019  Zach Cobell
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+#-----------------------------------------------------------------------#
+
+#...Host tool that compiles the station lists into the station catalog
+#   table used by libmetocean
+
+include($$PWD/../../global.pri)
+
+QT = core positioning
+
+TARGET = mkstationcatalog
+TEMPLATE = app
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += $$PWD/../libmetocean
+
+SOURCES += main.cpp \
+           stationcatalogwriter.cpp
+
+HEADERS += stationcatalogwriter.h
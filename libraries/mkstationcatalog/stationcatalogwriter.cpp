@@ -0,0 +1,309 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#include "stationcatalogwriter.h"
+#include <QBuffer>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QLocale>
+#include <QStringList>
+#include <algorithm>
+#include <cstring>
+#include "station.h"
+
+StationCatalogWriter::StationCatalogWriter() {
+  for (int i = 0; i < StationCatalog::NumTypes; ++i)
+    this->m_tables[i].flags = 0;
+}
+
+bool StationCatalogWriter::read(StationCatalog::Type type,
+                                const QString &filename) {
+  QFile stationFile(filename);
+  if (!stationFile.open(QIODevice::ReadOnly)) return false;
+
+  QVector<QByteArray> lines;
+  while (!stationFile.atEnd())
+    lines.push_back(stationFile.readLine().simplified());
+  stationFile.close();
+
+  Table &table = this->m_tables[type];
+  if (type == StationCatalog::NOAA) {
+    this->readNoaa(table, lines);
+  } else if (type == StationCatalog::USGS) {
+    this->readUsgs(table, lines);
+  } else if (type == StationCatalog::XTIDE) {
+    this->readXtide(table, lines);
+  } else if (type == StationCatalog::NDBC) {
+    this->readNdbc(table, lines);
+  } else if (type == StationCatalog::CRMS) {
+    this->readCrms(table, lines);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void StationCatalogWriter::appendStation(Table &table, double latitude,
+                                         double longitude, const QString &id,
+                                         const QString &name) {
+  table.latitude.push_back(latitude);
+  table.longitude.push_back(longitude);
+  table.id.push_back(id);
+  table.name.push_back(name);
+}
+
+double StationCatalogWriter::offset(const QString &value) {
+  double v = value.toDouble();
+  return v < -900.0 ? Station::nullOffset() : v;
+}
+
+void StationCatalogWriter::readNoaa(Table &table,
+                                    const QVector<QByteArray> &lines) {
+  table.flags = StationCatalog::HasDates | StationCatalog::HasOffsets;
+  const QLocale c = QLocale::c();
+
+  for (int i = 0; i < lines.size(); ++i) {
+    QStringList list = QString(lines[i]).split(";");
+
+    QString startDateString = list.value(4).simplified();
+    QString endDateString = list.value(5).simplified();
+    QDateTime startDate = c.toDateTime(startDateString, "MMM dd, yyyy");
+    startDate.setTimeSpec(Qt::UTC);
+    QDateTime endDate;
+    if (endDateString == "present")
+      endDate = QDateTime(QDate(2050, 1, 1), QTime(0, 0, 0));
+    else
+      endDate = c.toDateTime(endDateString, "MMM dd, yyyy");
+    endDate.setTimeSpec(Qt::UTC);
+
+    if (!startDate.isValid() && !endDate.isValid()) continue;
+
+    StationCatalogWriter::appendStation(
+        table, list.value(3).toDouble(), list.value(2).toDouble(),
+        list.value(0), list.value(1).simplified());
+    table.startDate.push_back(startDate.isValid()
+                                  ? startDate.toMSecsSinceEpoch()
+                                  : StationCatalog::invalidDate());
+    table.endDate.push_back(endDate.isValid() ? endDate.toMSecsSinceEpoch()
+                                              : StationCatalog::invalidDate());
+    table.active.push_back(endDateString == "present" ? 1 : 0);
+
+    table.offsets[StationCatalog::MLLW].push_back(
+        StationCatalogWriter::offset(list.value(6)));
+    table.offsets[StationCatalog::MLW].push_back(
+        StationCatalogWriter::offset(list.value(7)));
+    table.offsets[StationCatalog::MSL].push_back(0.0);
+    table.offsets[StationCatalog::MHW].push_back(
+        StationCatalogWriter::offset(list.value(9)));
+    table.offsets[StationCatalog::MHHW].push_back(
+        StationCatalogWriter::offset(list.value(10)));
+    table.offsets[StationCatalog::NGVD29].push_back(
+        StationCatalogWriter::offset(list.value(11)));
+    table.offsets[StationCatalog::NAVD88].push_back(
+        StationCatalogWriter::offset(list.value(12)));
+  }
+}
+
+void StationCatalogWriter::readUsgs(Table &table,
+                                    const QVector<QByteArray> &lines) {
+  for (int i = 1; i < lines.size(); ++i) {
+    QStringList list = QString(lines[i]).split(";");
+    StationCatalogWriter::appendStation(
+        table, list.value(2).toDouble(), list.value(3).toDouble(),
+        list.value(0), list.value(1).simplified());
+  }
+}
+
+void StationCatalogWriter::readXtide(Table &table,
+                                     const QVector<QByteArray> &lines) {
+  table.flags = StationCatalog::HasOffsets;
+  for (int i = 1; i < lines.size(); ++i) {
+    QStringList list = QString(lines[i]).split(";");
+    StationCatalogWriter::appendStation(
+        table, list.value(0).toDouble(), list.value(1).toDouble(),
+        list.value(3), list.value(4).simplified());
+
+    table.offsets[StationCatalog::MLLW].push_back(0.0);
+    table.offsets[StationCatalog::MLW].push_back(
+        StationCatalogWriter::offset(list.value(6)));
+    table.offsets[StationCatalog::MSL].push_back(
+        StationCatalogWriter::offset(list.value(7)));
+    table.offsets[StationCatalog::MHW].push_back(
+        StationCatalogWriter::offset(list.value(8)));
+    table.offsets[StationCatalog::MHHW].push_back(
+        StationCatalogWriter::offset(list.value(9)));
+    table.offsets[StationCatalog::NGVD29].push_back(
+        StationCatalogWriter::offset(list.value(10)));
+    table.offsets[StationCatalog::NAVD88].push_back(
+        StationCatalogWriter::offset(list.value(11)));
+  }
+}
+
+void StationCatalogWriter::readNdbc(Table &table,
+                                    const QVector<QByteArray> &lines) {
+  for (int i = 1; i < lines.size(); ++i) {
+    QStringList list = QString(lines[i]).split(",");
+    QString id = list.value(0).simplified();
+    StationCatalogWriter::appendStation(table, list.value(2).toDouble(),
+                                        list.value(1).toDouble(), id,
+                                        "NDBC_" + id);
+  }
+}
+
+//...CRMS station names double as their ids. The dates come from the CRMS
+//   database when the markers are read, so only the locations are kept
+void StationCatalogWriter::readCrms(Table &table,
+                                    const QVector<QByteArray> &lines) {
+  for (int i = 0; i < lines.size(); ++i) {
+    QStringList list = QString(lines[i]).split(",");
+    if (list.size() < 3) continue;
+    StationCatalogWriter::appendStation(table, list.value(1).toDouble(),
+                                        list.value(0).toDouble(),
+                                        list.value(2), list.value(2));
+  }
+}
+
+static quint32 alignStream(QDataStream &stream) {
+  while (stream.device()->pos() % 8 != 0) stream << static_cast<quint8>(0);
+  return static_cast<quint32>(stream.device()->pos());
+}
+
+template <typename T>
+static quint32 writeColumn(QDataStream &stream, const QVector<T> &column) {
+  quint32 offset = alignStream(stream);
+  for (int i = 0; i < column.size(); ++i) stream << column[i];
+  return offset;
+}
+
+static quint32 writeStrings(QDataStream &stream, const QVector<QString> &column,
+                            QString &pool) {
+  quint32 offset = alignStream(stream);
+  for (int i = 0; i < column.size(); ++i) {
+    stream << static_cast<quint32>(pool.size())
+           << static_cast<quint32>(column[i].size());
+    pool += column[i];
+  }
+  return offset;
+}
+
+static void writeHeader(QDataStream &stream,
+                        const StationCatalog::Header &header) {
+  stream.writeRawData(header.magic, sizeof(header.magic));
+  stream << header.version << header.strings << header.stringsLength
+         << header.nTables;
+  for (int i = 0; i < StationCatalog::NumTypes; ++i) {
+    const StationCatalog::TableHeader &t = header.tables[i];
+    stream << t.count << t.flags << t.latitude << t.longitude << t.id
+           << t.name << t.byId << t.startDate << t.endDate << t.active
+           << t.offsets;
+  }
+}
+
+QByteArray StationCatalogWriter::serialize() const {
+  QByteArray output;
+  QBuffer buffer(&output);
+  buffer.open(QIODevice::WriteOnly);
+  QDataStream stream(&buffer);
+  stream.setByteOrder(QDataStream::LittleEndian);
+  stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+  StationCatalog::Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, "MOVSTCAT", sizeof(header.magic));
+  header.version = StationCatalog::formatVersion();
+  header.nTables = StationCatalog::NumTypes;
+
+  //...Placeholder until the column offsets are known
+  writeHeader(stream, header);
+
+  QString pool;
+  for (int i = 0; i < StationCatalog::NumTypes; ++i) {
+    const Table &table = this->m_tables[i];
+    StationCatalog::TableHeader &t = header.tables[i];
+    t.count = static_cast<quint32>(table.id.size());
+    t.flags = table.flags;
+    if (t.count == 0) continue;
+
+    QVector<quint32> byId(table.id.size());
+    for (int j = 0; j < byId.size(); ++j) byId[j] = static_cast<quint32>(j);
+    std::stable_sort(byId.begin(), byId.end(),
+                     [&table](quint32 a, quint32 b) {
+                       return table.id[a] < table.id[b];
+                     });
+
+    t.latitude = writeColumn(stream, table.latitude);
+    t.longitude = writeColumn(stream, table.longitude);
+    t.id = writeStrings(stream, table.id, pool);
+    t.name = writeStrings(stream, table.name, pool);
+    t.byId = writeColumn(stream, byId);
+    if (table.flags & StationCatalog::HasDates) {
+      t.startDate = writeColumn(stream, table.startDate);
+      t.endDate = writeColumn(stream, table.endDate);
+      t.active = writeColumn(stream, table.active);
+    }
+    if (table.flags & StationCatalog::HasOffsets) {
+      t.offsets = writeColumn(stream, table.offsets[0]);
+      for (int d = 1; d < StationCatalog::NumDatums; ++d)
+        writeColumn(stream, table.offsets[d]);
+    }
+  }
+
+  header.strings = alignStream(stream);
+  header.stringsLength = static_cast<quint32>(pool.size());
+  for (int i = 0; i < pool.size(); ++i) stream << pool.at(i).unicode();
+  alignStream(stream);
+
+  buffer.seek(0);
+  writeHeader(stream, header);
+  buffer.close();
+  return output;
+}
+
+//...The table goes into an 8 byte aligned array so the columns can be
+//   read in place
+bool StationCatalogWriter::write(const QString &filename) const {
+  static const char hex[] = "0123456789abcdef";
+  const QByteArray data = this->serialize();
+
+  QByteArray source;
+  source.reserve(data.size() * 5 + 1024);
+  source +=
+      "// Generated by mkstationcatalog from the station lists. Do not "
+      "edit.\n"
+      "#include <cstddef>\n\n"
+      "alignas(8) extern const unsigned char stationCatalogData[] = {\n";
+  for (int i = 0; i < data.size(); ++i) {
+    const uchar b = static_cast<uchar>(data.at(i));
+    source += "0x";
+    source += hex[b >> 4];
+    source += hex[b & 0xf];
+    source += (i % 16 == 15 || i == data.size() - 1) ? ",\n" : ",";
+  }
+  source +=
+      "};\n"
+      "extern const std::size_t stationCatalogSize = "
+      "sizeof(stationCatalogData);\n";
+
+  QFile output(filename);
+  if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+  bool ok = output.write(source) == source.size();
+  output.close();
+  return ok;
+}
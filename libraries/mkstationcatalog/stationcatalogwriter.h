@@ -0,0 +1,66 @@
+/*-------------------------------GPL-------------------------------------//
+//
+// MetOcean Viewer - A simple interface for viewing hydrodynamic model data
+// Copyright (C) 2019  Zach Cobell
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------*/
+#ifndef STATIONCATALOGWRITER_H
+#define STATIONCATALOGWRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include "stationcatalog.h"
+
+//...Reads the csv station lists and writes them out as a C++ source file
+//   holding the StationCatalog table. The rows are parsed the same way the
+//   station lists used to be read at run time
+class StationCatalogWriter {
+ public:
+  StationCatalogWriter();
+
+  bool read(StationCatalog::Type type, const QString &filename);
+  bool write(const QString &filename) const;
+
+ private:
+  struct Table {
+    quint32 flags;
+    QVector<double> latitude;
+    QVector<double> longitude;
+    QVector<QString> id;
+    QVector<QString> name;
+    QVector<qint64> startDate;
+    QVector<qint64> endDate;
+    QVector<quint8> active;
+    QVector<double> offsets[StationCatalog::NumDatums];
+  };
+
+  void readNoaa(Table &table, const QVector<QByteArray> &lines);
+  void readUsgs(Table &table, const QVector<QByteArray> &lines);
+  void readXtide(Table &table, const QVector<QByteArray> &lines);
+  void readNdbc(Table &table, const QVector<QByteArray> &lines);
+  void readCrms(Table &table, const QVector<QByteArray> &lines);
+
+  static void appendStation(Table &table, double latitude, double longitude,
+                            const QString &id, const QString &name);
+  static double offset(const QString &value);
+
+  QByteArray serialize() const;
+
+  Table m_tables[StationCatalog::NumTypes];
+};
+
+#endif  // STATIONCATALOGWRITER_H